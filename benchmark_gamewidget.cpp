@@ -0,0 +1,332 @@
+// GameWidget 离屏渲染基准测试
+// 在 QT_QPA_PLATFORM=offscreen 下把 GameWidget::paintEvent() 渲染到 QImage，
+// 使用合成棋盘（1-64条蛇、0-2000块墙、不同格子大小、双人/AI/联机/暂停等覆盖层），
+// 输出每个场景的帧率和各绘制阶段耗时。
+//
+// 用法：GameWidgetBench [--frames N] [--filter 文本] [--csv] [--budget-ms X]
+//   --budget-ms X  任一场景 p95 帧耗时超过 X 毫秒时返回非零退出码，用于回归检查
+
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QLayout>
+#include <iostream>
+#include <iomanip>
+#include "gamewidget.h"
+#include "frameprofiler.h"
+
+namespace {
+
+// 合成场景中叠加的模式
+enum class SceneOverlay {
+    None,
+    Multiplayer,   // 其他玩家的蛇
+    LocalCoop,     // 本地双人
+    AIBattle,      // 人机对战
+    Paused,        // 暂停遮罩
+    GameOver       // 游戏结束遮罩
+};
+
+struct BenchScene {
+    QString name;
+    int snakes;
+    int walls;
+    int cellSize;
+    SceneOverlay overlay;
+};
+
+struct BenchResult {
+    double fps;
+    double frameP50;
+    double frameP95;
+    double frameP99;
+    QList<double> phaseAverages;
+};
+
+// 合成棋盘尺寸：足够容纳2000块墙和64条蛇
+const int BENCH_GRID_WIDTH = 80;
+const int BENCH_GRID_HEIGHT = 50;
+const int BENCH_SNAKE_LENGTH = 24;
+
+const QList<ProfilePhase> REPORTED_PHASES = {
+    ProfilePhase::DrawGrid, ProfilePhase::DrawFood, ProfilePhase::DrawWalls,
+    ProfilePhase::DrawSnakes, ProfilePhase::DrawMultiplayer, ProfilePhase::DrawEffects
+};
+
+// 基准测试期间屏蔽qDebug输出，避免日志本身成为主要开销
+void quietMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::cerr << message.toStdString() << std::endl;
+}
+
+QList<BenchScene> buildScenes()
+{
+    QList<BenchScene> scenes;
+
+    // 蛇数量
+    for (int snakes : {1, 4, 16, 64}) {
+        scenes.append({QString("snakes-%1").arg(snakes), snakes, 0, 20,
+                       snakes > 1 ? SceneOverlay::Multiplayer : SceneOverlay::None});
+    }
+
+    // 墙体数量
+    for (int walls : {0, 200, 500, 2000}) {
+        scenes.append({QString("walls-%1").arg(walls), 1, walls, 20, SceneOverlay::None});
+    }
+
+    // 格子大小
+    for (int cellSize : {15, 20, 25}) {
+        scenes.append({QString("cell-%1").arg(cellSize), 16, 500, cellSize, SceneOverlay::Multiplayer});
+    }
+
+    // 覆盖层
+    scenes.append({"overlay-localcoop", 2, 200, 20, SceneOverlay::LocalCoop});
+    scenes.append({"overlay-ai", 2, 200, 20, SceneOverlay::AIBattle});
+    scenes.append({"overlay-paused", 16, 500, 20, SceneOverlay::Paused});
+    scenes.append({"overlay-gameover", 16, 500, 20, SceneOverlay::GameOver});
+
+    // 最坏情况
+    scenes.append({"worst-case", 64, 2000, 25, SceneOverlay::Multiplayer});
+
+    return scenes;
+}
+
+} // namespace
+
+/**
+ * 基准测试驱动
+ * 作为 GameWidget 的友元直接构造合成场景
+ */
+class GameWidgetBenchmark
+{
+public:
+    static void setupScene(GameWidget& widget, const BenchScene& scene);
+    static BenchResult run(GameWidget& widget, int frames);
+
+private:
+    static std::deque<Point> zigzagBody(int index, int length);
+};
+
+std::deque<Point> GameWidgetBenchmark::zigzagBody(int index, int length)
+{
+    // 每条蛇占据一条横向通道，蛇身在通道内来回折返，头部朝右
+    const int lanes = BENCH_GRID_HEIGHT / 2;
+    const int lane = index % lanes;
+    const int column = (index / lanes) * (BENCH_GRID_WIDTH / 3);
+    const int laneWidth = 12;
+
+    std::deque<Point> body;
+    for (int i = 0; i < length; ++i) {
+        const int row = i / laneWidth;
+        const int offset = i % laneWidth;
+        const int x = column + ((row % 2 == 0) ? (laneWidth - 1 - offset) : offset);
+        body.push_back(Point(x, lane * 2 + (row % 2)));
+    }
+    return body;
+}
+
+void GameWidgetBenchmark::setupScene(GameWidget& widget, const BenchScene& scene)
+{
+    widget.resetGame();
+
+    widget.gridWidth = BENCH_GRID_WIDTH;
+    widget.gridHeight = BENCH_GRID_HEIGHT;
+    widget.resize(BENCH_GRID_WIDTH * scene.cellSize + 20, BENCH_GRID_HEIGHT * scene.cellSize + 20);
+    widget.updateGameArea();
+    widget.layout()->activate();
+
+    // 墙体：固定种子，保证每次运行的场景一致
+    QRandomGenerator random(20240601);
+    QSet<Point> walls;
+    while (walls.size() < scene.walls) {
+        walls.insert(Point(random.bounded(BENCH_GRID_WIDTH), random.bounded(BENCH_GRID_HEIGHT)));
+    }
+    widget.wall->setWallPositions(walls);
+
+    widget.snake->setBody(zigzagBody(0, BENCH_SNAKE_LENGTH));
+    widget.food->setPosition(Point(BENCH_GRID_WIDTH - 2, BENCH_GRID_HEIGHT - 2));
+
+    widget.isMultiplayer = false;
+    widget.isLocalCoop = false;
+    widget.singlePlayerManager->setGameMode(SinglePlayerMode::CLASSIC);
+    widget.currentState = GameState::PLAYING;
+
+    switch (scene.overlay) {
+    case SceneOverlay::None:
+        break;
+    case SceneOverlay::Multiplayer:
+    case SceneOverlay::Paused:
+    case SceneOverlay::GameOver:
+        widget.isMultiplayer = scene.snakes > 1;
+        widget.currentState = GameState::MULTIPLAYER_GAME;
+        if (scene.overlay == SceneOverlay::Paused) {
+            widget.currentState = GameState::PAUSED;
+        } else if (scene.overlay == SceneOverlay::GameOver) {
+            widget.currentState = GameState::GAME_OVER;
+        }
+        break;
+    case SceneOverlay::LocalCoop:
+        widget.isLocalCoop = true;
+        widget.player1Alive = true;
+        widget.player2Alive = true;
+        widget.player2Snake->setBody(zigzagBody(1, BENCH_SNAKE_LENGTH));
+        break;
+    case SceneOverlay::AIBattle:
+        widget.singlePlayerManager->setGameMode(SinglePlayerMode::AI_BATTLE);
+        widget.singlePlayerManager->initializeAI();
+        break;
+    }
+
+    if (widget.isMultiplayer) {
+        const CharacterType characters[] = {
+            CharacterType::SPONGEBOB, CharacterType::PATRICK, CharacterType::SQUIDWARD,
+            CharacterType::SANDY, CharacterType::MR_KRABS, CharacterType::PLANKTON
+        };
+        for (int i = 1; i < scene.snakes; ++i) {
+            const QString name = QString("player%1").arg(i);
+            widget.otherPlayers[name] = zigzagBody(i, BENCH_SNAKE_LENGTH);
+            widget.playerCharacters[name] = characters[i % 6];
+            widget.playerAliveStatus[name] = true;
+        }
+    }
+}
+
+BenchResult GameWidgetBenchmark::run(GameWidget& widget, int frames)
+{
+    QImage target(widget.size() * widget.devicePixelRatioF(), QImage::Format_ARGB32_Premultiplied);
+    target.setDevicePixelRatio(widget.devicePixelRatioF());
+
+    // 预热：让后台栅格化的精灵就位，排除首次加载的开销
+    QElapsedTimer warmup;
+    warmup.start();
+    while (warmup.elapsed() < 200) {
+        target.fill(Qt::transparent);
+        widget.render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+        QCoreApplication::processEvents();
+    }
+
+    FrameProfiler* profiler = FrameProfiler::instance();
+    profiler->reset();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        target.fill(Qt::transparent);
+        // 不绘制子控件，只测量 GameWidget::paintEvent()
+        widget.render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+    }
+    const double elapsedMs = timer.nsecsElapsed() / 1000000.0;
+
+    BenchResult result;
+    result.fps = frames * 1000.0 / qMax(0.001, elapsedMs);
+    result.frameP50 = profiler->percentile(ProfilePhase::FrameTotal, 0.50);
+    result.frameP95 = profiler->percentile(ProfilePhase::FrameTotal, 0.95);
+    result.frameP99 = profiler->percentile(ProfilePhase::FrameTotal, 0.99);
+    for (ProfilePhase phase : REPORTED_PHASES) {
+        result.phaseAverages.append(profiler->average(phase));
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    // 默认使用离屏平台，无需显示器即可运行
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    qInstallMessageHandler(quietMessageHandler);
+
+    int frames = 200;
+    QString filter;
+    bool csv = false;
+    double budgetMs = 0.0;
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--frames" && i + 1 < args.size()) {
+            frames = qMax(1, args[++i].toInt());
+        } else if (args[i] == "--filter" && i + 1 < args.size()) {
+            filter = args[++i];
+        } else if (args[i] == "--csv") {
+            csv = true;
+        } else if (args[i] == "--budget-ms" && i + 1 < args.size()) {
+            budgetMs = args[++i].toDouble();
+        } else {
+            std::cerr << "Usage: GameWidgetBench [--frames N] [--filter text] [--csv] [--budget-ms X]" << std::endl;
+            return 2;
+        }
+    }
+
+    // 样本环形缓冲区只保留最近的帧，帧数过多时分位数只反映尾部
+    if (frames > FrameProfiler::SAMPLE_COUNT) {
+        std::cerr << "Note: percentiles use the last " << FrameProfiler::SAMPLE_COUNT << " frames" << std::endl;
+    }
+
+    GameWidget widget;
+    widget.show();
+    QCoreApplication::processEvents();
+
+    FrameProfiler::instance()->setEnabled(true);
+
+    if (csv) {
+        std::cout << "scene,fps,frame_p50_ms,frame_p95_ms,frame_p99_ms";
+        for (ProfilePhase phase : REPORTED_PHASES) {
+            std::cout << "," << FrameProfiler::phaseName(phase).toStdString() << "_ms";
+        }
+        std::cout << std::endl;
+    } else {
+        std::cout << std::left << std::setw(20) << "scene"
+                  << std::right << std::setw(10) << "fps"
+                  << std::setw(9) << "p50" << std::setw(9) << "p95" << std::setw(9) << "p99";
+        for (ProfilePhase phase : REPORTED_PHASES) {
+            std::cout << std::setw(16) << FrameProfiler::phaseName(phase).toStdString();
+        }
+        std::cout << std::endl;
+    }
+
+    bool overBudget = false;
+    const QList<BenchScene> scenes = buildScenes();
+    for (const BenchScene& scene : scenes) {
+        if (!filter.isEmpty() && !scene.name.contains(filter)) {
+            continue;
+        }
+
+        GameWidgetBenchmark::setupScene(widget, scene);
+        const BenchResult result = GameWidgetBenchmark::run(widget, frames);
+
+        if (csv) {
+            std::cout << scene.name.toStdString() << "," << result.fps << ","
+                      << result.frameP50 << "," << result.frameP95 << "," << result.frameP99;
+            for (double average : result.phaseAverages) {
+                std::cout << "," << average;
+            }
+            std::cout << std::endl;
+        } else {
+            std::cout << std::fixed << std::setprecision(2)
+                      << std::left << std::setw(20) << scene.name.toStdString()
+                      << std::right << std::setw(10) << result.fps
+                      << std::setw(9) << result.frameP50 << std::setw(9) << result.frameP95
+                      << std::setw(9) << result.frameP99;
+            for (double average : result.phaseAverages) {
+                std::cout << std::setw(16) << average;
+            }
+            std::cout << std::endl;
+        }
+
+        if (budgetMs > 0.0 && result.frameP95 > budgetMs) {
+            std::cerr << "Scene " << scene.name.toStdString() << " p95 frame time "
+                      << result.frameP95 << " ms exceeds budget " << budgetMs << " ms" << std::endl;
+            overBudget = true;
+        }
+    }
+
+    return overBudget ? 1 : 0;
+}
@@ -3,7 +3,7 @@
 #include <QFont>
 #include <QEnterEvent>
 #include <QDebug>
-#include <QSvgRenderer>
+#include "svgrasterizer.h"
 #include <QBrush>
 #include <QColor>
 #include <QMessageBox>
@@ -16,6 +16,13 @@ CharacterButton::CharacterButton(CharacterType character, QWidget *parent)
 {
     loadCharacterInfo();
     setFixedSize(120, 150);
+    
+    // 新尺寸（如移动到HiDPI屏幕）栅格化完成后重绘
+    connect(SvgRasterizer::instance(), &SvgRasterizer::pixmapReady, this, [this](const QString& svgPath) {
+        if (svgPath == headSvgPath) {
+            update();
+        }
+    });
     setCheckable(true);
     setStyleSheet("QPushButton { border: 2px solid #333; border-radius: 10px; background-color: #f0f0f0; font-family: '华文彩云'; }"
                   "QPushButton:checked { border: 3px solid #ff6b35; background-color: #ffe0d6; }"
@@ -29,7 +36,11 @@ void CharacterButton::paintEvent(QPaintEvent *event)
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
     
-    // 绘制角色图片
+    // 绘制角色图片：优先使用按当前屏幕像素比栅格化的SVG，加载失败时使用默认图片
+    QPixmap characterPixmap = SvgRasterizer::instance()->pixmap(headSvgPath, QSize(100, 100), devicePixelRatioF());
+    if (characterPixmap.isNull()) {
+        characterPixmap = fallbackPixmap;
+    }
     if (!characterPixmap.isNull()) {
         QRect pixmapRect(10, 10, 100, 100);
         painter.drawPixmap(pixmapRect, characterPixmap);
@@ -89,20 +100,16 @@ void CharacterButton::loadCharacterInfo()
         break;
     }
     
-    // 使用蛇头图片
-    QString headPath = basePath + characterName_en + "_head.svg";
-    QSvgRenderer headRenderer;
-    headRenderer.load(headPath);
+    // 使用蛇头图片，由SvgRasterizer按物理像素尺寸栅格化
+    headSvgPath = basePath + characterName_en + "_head.svg";
+    QPixmap headPixmap = SvgRasterizer::instance()->pixmap(headSvgPath, QSize(100, 100), devicePixelRatioF());
     
-    if (headRenderer.isValid()) {
-        characterPixmap = QPixmap(100, 100);
-        characterPixmap.fill(Qt::transparent);
-        QPainter painter(&characterPixmap);
-        headRenderer.render(&painter);
+    if (!headPixmap.isNull()) {
+        fallbackPixmap = QPixmap();
     } else {
         // 如果蛇头SVG不存在，创建默认图片
-        characterPixmap = QPixmap(100, 100);
-        QPainter painter(&characterPixmap);
+        fallbackPixmap = QPixmap(100, 100);
+        QPainter painter(&fallbackPixmap);
         
         // 根据角色类型设置不同颜色
         QColor color;
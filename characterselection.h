@@ -34,7 +34,8 @@ protected:
     
 private:
     CharacterType character;
-    QPixmap characterPixmap;
+    QString headSvgPath;
+    QPixmap fallbackPixmap;  // SVG无法加载时使用的默认图片
     QString characterName;
     bool hovered;
     
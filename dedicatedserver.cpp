@@ -0,0 +1,256 @@
+#include "dedicatedserver.h"
+#include "serverroom.h"
+#include "hotspotnetworkmanager.h"
+#include <QThread>
+#include <QUdpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QNetworkInterface>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <cstdio>
+
+namespace {
+
+// 广播中告知客户端的服务器地址：第一个已启用的非回环IPv4地址
+QString localIPv4Address()
+{
+    const QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface& interface : interfaces) {
+        if (!(interface.flags() & QNetworkInterface::IsUp) ||
+            !(interface.flags() & QNetworkInterface::IsRunning) ||
+            (interface.flags() & QNetworkInterface::IsLoopBack)) {
+            continue;
+        }
+        const QList<QNetworkAddressEntry> entries = interface.addressEntries();
+        for (const QNetworkAddressEntry& entry : entries) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                return entry.ip().toString();
+            }
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+DedicatedServer::DedicatedServer(const Options& options, QObject *parent)
+    : QObject(parent)
+    , options(options)
+    , statusTimer(new QTimer(this))
+    , announceTimer(new QTimer(this))
+    , responseTimer(new QTimer(this))
+    , announceInterval(INITIAL_ANNOUNCE_INTERVAL)
+    , discoverySocket(nullptr)
+    , statusServer(nullptr)
+{
+    connect(statusTimer, &QTimer::timeout, this, &DedicatedServer::onStatusTimer);
+    announceTimer->setSingleShot(true);
+    responseTimer->setSingleShot(true);
+    connect(announceTimer, &QTimer::timeout, this, &DedicatedServer::onAnnounceTimeout);
+    connect(responseTimer, &QTimer::timeout, this, &DedicatedServer::announceRooms);
+}
+
+DedicatedServer::~DedicatedServer()
+{
+    stopWorkers();
+}
+
+bool DedicatedServer::start()
+{
+    const int threadCount = qBound(1, options.threads > 0 ? options.threads : QThread::idealThreadCount(), options.rooms);
+    for (int i = 0; i < threadCount; ++i) {
+        QThread* worker = new QThread(this);
+        worker->setObjectName(QString("room-worker-%1").arg(i));
+        worker->start();
+        workers.append(worker);
+    }
+
+    roomStatuses.resize(options.rooms);
+    for (int i = 0; i < options.rooms; ++i) {
+        ServerRoom::Config config;
+        config.roomName = options.rooms == 1 ? options.roomName : QString("%1 #%2").arg(options.roomName).arg(i + 1);
+        config.maxPlayers = options.maxPlayers;
+        config.gameSpeed = options.gameSpeed;
+        config.lockstep = options.lockstep;
+        config.autoStart = options.autoStart;
+        config.tcpPort = static_cast<quint16>(options.basePort + 2 * i);
+        config.statePort = static_cast<quint16>(options.basePort + 2 * i + 1);
+
+        // 房间在主线程构造后整体移到工作线程，之后只在该线程内访问
+        QThread* worker = workers.at(i % workers.size());
+        ServerRoom* room = new ServerRoom(config);
+        room->moveToThread(worker);
+        connect(worker, &QThread::finished, room, &QObject::deleteLater);
+        connect(room, &ServerRoom::statusUpdated, this, [this, i](const QJsonObject& status) {
+            // 人数变化时尽快重新通告，客户端列表中的人数不会长时间过期
+            const bool countChanged = roomStatuses[i]["playerCount"] != status["playerCount"];
+            roomStatuses[i] = status;
+            if (countChanged) {
+                restartAnnouncements();
+            }
+        });
+        rooms.append(room);
+
+        bool started = false;
+        QMetaObject::invokeMethod(room, &ServerRoom::start, Qt::BlockingQueuedConnection, &started);
+        if (!started) {
+            return false;
+        }
+    }
+
+    // 所有房间共用一个发现端口，由主线程统一应答和通告
+    discoverySocket = new QUdpSocket(this);
+    if (!discoverySocket->bind(QHostAddress::AnyIPv4, HotspotNetworkManager::DISCOVERY_PORT,
+                               QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        qWarning() << "Failed to bind discovery port, rooms will not be announced:" << discoverySocket->errorString();
+    } else {
+        if (!discoverySocket->joinMulticastGroup(HotspotNetworkManager::discoveryGroupAddress())) {
+            qWarning() << "Failed to join discovery multicast group, falling back to broadcast:" << discoverySocket->errorString();
+        }
+        discoverySocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+        connect(discoverySocket, &QUdpSocket::readyRead, this, &DedicatedServer::onDiscoveryDataReceived);
+        restartAnnouncements();
+    }
+
+    if (!options.statusSocket.isEmpty()) {
+        statusServer = new QLocalServer(this);
+        QLocalServer::removeServer(options.statusSocket);  // 清理上次异常退出遗留的套接字文件
+        if (!statusServer->listen(options.statusSocket)) {
+            qWarning() << "Failed to listen on status socket" << options.statusSocket << statusServer->errorString();
+            return false;
+        }
+        connect(statusServer, &QLocalServer::newConnection, this, &DedicatedServer::onStatusConnection);
+    }
+
+    if (options.statusInterval > 0) {
+        statusTimer->start(options.statusInterval * 1000);
+    }
+
+    qInfo() << "Dedicated server started:" << options.rooms << "rooms on" << workers.size() << "threads,"
+            << "ports" << options.basePort << "-" << options.basePort + 2 * options.rooms - 1
+            << (options.lockstep ? "lockstep" : "snapshot");
+    return true;
+}
+
+QJsonObject DedicatedServer::serverStatus() const
+{
+    QJsonArray roomArray;
+    int playerCount = 0;
+    int worstTickUs = 0;
+    for (const QJsonObject& status : roomStatuses) {
+        if (status.isEmpty()) {
+            continue;
+        }
+        roomArray.append(status);
+        playerCount += status["playerCount"].toInt();
+        worstTickUs = qMax(worstTickUs, status["tickPeakUs"].toInt());
+    }
+
+    QJsonObject status;
+    status["time"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    status["threads"] = workers.size();
+    status["rooms"] = roomArray;
+    status["players"] = playerCount;
+    status["tickPeakUs"] = worstTickUs;
+    return status;
+}
+
+void DedicatedServer::onStatusTimer()
+{
+    // 每次一行JSON，方便外部脚本逐行解析
+    const QByteArray line = QJsonDocument(serverStatus()).toJson(QJsonDocument::Compact);
+    std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+void DedicatedServer::onStatusConnection()
+{
+    while (QLocalSocket* socket = statusServer->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        socket->write(QJsonDocument(serverStatus()).toJson(QJsonDocument::Compact));
+        socket->write("\n");
+        socket->disconnectFromServer();
+    }
+}
+
+void DedicatedServer::onDiscoveryDataReceived()
+{
+    bool discoveryRequested = false;
+    while (discoverySocket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(static_cast<int>(discoverySocket->pendingDatagramSize()));
+        if (discoverySocket->readDatagram(datagram.data(), datagram.size()) <= 0) {
+            continue;
+        }
+        const QJsonObject message = QJsonDocument::fromJson(datagram).object();
+        if (message["type"].toString() == "discover_hosts") {
+            discoveryRequested = true;
+        }
+    }
+
+    // 随机延迟后应答，延迟期间的查询合并为一次
+    if (discoveryRequested && !responseTimer->isActive()) {
+        responseTimer->start(QRandomGenerator::global()->bounded(MIN_RESPONSE_DELAY, MAX_RESPONSE_DELAY + 1));
+    }
+}
+
+void DedicatedServer::onAnnounceTimeout()
+{
+    announceRooms();
+    announceTimer->start(announceInterval);
+    announceInterval = qMin(announceInterval * 2, static_cast<int>(MAX_ANNOUNCE_INTERVAL));
+}
+
+void DedicatedServer::restartAnnouncements()
+{
+    if (!discoverySocket) {
+        return;
+    }
+    announceInterval = INITIAL_ANNOUNCE_INTERVAL;
+    announceTimer->start(0);
+}
+
+void DedicatedServer::announceRooms()
+{
+    const QString hostAddress = localIPv4Address();
+    if (hostAddress.isEmpty()) {
+        return;
+    }
+
+    // 消息格式与HotspotNetworkManager::broadcastHostInfo相同，每个房间发往组播组和子网广播各一个数据报
+    for (const QJsonObject& status : roomStatuses) {
+        if (status.isEmpty()) {
+            continue;
+        }
+        QJsonObject hostInfo;
+        hostInfo["type"] = "host_info";
+        hostInfo["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+        hostInfo["room_name"] = status["room"];
+        hostInfo["player_count"] = status["playerCount"];
+        hostInfo["max_players"] = status["maxPlayers"];
+        hostInfo["host_address"] = hostAddress;
+        hostInfo["port"] = status["port"];
+        hostInfo["state_port"] = status["statePort"];
+        const QByteArray data = QJsonDocument(hostInfo).toJson(QJsonDocument::Compact);
+        discoverySocket->writeDatagram(data, HotspotNetworkManager::discoveryGroupAddress(), HotspotNetworkManager::DISCOVERY_PORT);
+        discoverySocket->writeDatagram(data, QHostAddress::Broadcast, HotspotNetworkManager::DISCOVERY_PORT);
+    }
+}
+
+void DedicatedServer::stopWorkers()
+{
+    // 线程结束后房间随finished信号删除
+    for (QThread* worker : workers) {
+        worker->quit();
+    }
+    for (QThread* worker : workers) {
+        worker->wait();
+    }
+    workers.clear();
+    rooms.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef DEDICATEDSERVER_H
+#define DEDICATEDSERVER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QJsonObject>
+#include <QVector>
+
+class QLocalServer;
+class QThread;
+class QUdpSocket;
+class ServerRoom;
+
+/**
+ * 无界面专用服务器
+ * 只使用QtCore和QtNetwork，在一个进程内运行多个热点房间，服务器本身不参与游戏
+ * 特点：
+ * 1. 每个房间是一个ServerRoom，按轮转分配到固定数量的工作线程上，房间数可以随CPU核数扩展
+ * 2. 每个房间监听自己的TCP端口和状态通道端口，由服务器在发现组播组上统一通告所有房间
+ * 3. 房间状态（含每个房间的逻辑帧耗时）定期以一行JSON输出到标准输出，也可以通过本地套接字随时查询
+ */
+class DedicatedServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString roomName = "Snake Server";
+        int rooms = 1;
+        int threads = 0;              // 工作线程数，0表示按CPU核数
+        quint16 basePort = 24000;     // 第i个房间使用 basePort+2i (TCP) 和 basePort+2i+1 (状态通道UDP)
+        int maxPlayers = 4;
+        int gameSpeed = 100;          // 逻辑帧间隔(ms)
+        bool lockstep = false;
+        bool autoStart = true;
+        int statusInterval = 5;       // 状态输出间隔(秒)，0表示不输出
+        QString statusSocket;         // 本地套接字名，为空表示不开启
+    };
+
+    explicit DedicatedServer(const Options& options, QObject *parent = nullptr);
+    ~DedicatedServer();
+
+    bool start();
+    QJsonObject serverStatus() const;
+
+private slots:
+    void onStatusTimer();
+    void onStatusConnection();
+    void onDiscoveryDataReceived();
+    void onAnnounceTimeout();
+    void announceRooms();
+
+private:
+    void stopWorkers();
+    void restartAnnouncements();
+
+    Options options;
+    QVector<QThread*> workers;
+    QVector<ServerRoom*> rooms;
+    QVector<QJsonObject> roomStatuses;  // 各房间最近一次发布的状态，只在主线程访问
+    QTimer* statusTimer;
+    QTimer* announceTimer;   // 定期通告，间隔指数增长
+    QTimer* responseTimer;   // 查询应答的随机延迟
+    int announceInterval;
+    QUdpSocket* discoverySocket;
+    QLocalServer* statusServer;
+
+    static const int INITIAL_ANNOUNCE_INTERVAL = 1000;  // 启动或人数变化后的通告间隔(ms)，每次翻倍
+    static const int MAX_ANNOUNCE_INTERVAL = 16000;
+    static const int MIN_RESPONSE_DELAY = 20;           // 查询应答的随机延迟范围(ms)
+    static const int MAX_RESPONSE_DELAY = 150;
+};
+
+#endif // DEDICATEDSERVER_H
@@ -1,21 +1,28 @@
 #include "food.h"
 #include <QRandomGenerator>
 #include <QPixmap>
-#include <QPainter>
-#include <QSvgRenderer>
+#include <QGuiApplication>
 #include <QDebug>
+#include "svgrasterizer.h"
+
+namespace {
+const QString NORMAL_FOOD_SVG = QStringLiteral(":/images/krabby_patty.svg");
+const QString SPECIAL_FOOD_SVG = QStringLiteral(":/images/golden_spatula.svg");
+}
 
 Food::Food(QObject *parent)
     : QObject(parent)
     , position(0, 0)
     , special(false)
     , value(10)
-    , timer(new QTimer(this))
+    , timer(new FrameTimer(this))
+    , spriteSize(DEFAULT_SPRITE_SIZE)
+    , spriteDevicePixelRatio(qApp->devicePixelRatio())
 {
     loadFoodPixmaps();
     
     timer->setSingleShot(true);
-    connect(timer, &QTimer::timeout, this, &Food::onTimeout);
+    connect(timer, &FrameTimer::timeout, this, &Food::onTimeout);
 }
 
 void Food::generateFood(int width, int height, const QSet<Point>& occupiedPositions)
@@ -58,7 +65,22 @@ void Food::generateSpecialFood(int width, int height, const QSet<Point>& occupie
 
 QPixmap Food::getPixmap() const
 {
-    return special ? specialFoodPixmap : normalFoodPixmap;
+    // 目标尺寸未就绪时返回上一次的尺寸，加载失败时返回空位图由调用方备用绘制
+    return SvgRasterizer::instance()->pixmap(special ? SPECIAL_FOOD_SVG : NORMAL_FOOD_SVG,
+                                             QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
+}
+
+void Food::setSpriteSize(int logicalSize, qreal devicePixelRatio)
+{
+    if (logicalSize == spriteSize && qFuzzyCompare(devicePixelRatio, spriteDevicePixelRatio)) {
+        return;
+    }
+    
+    spriteSize = logicalSize;
+    spriteDevicePixelRatio = devicePixelRatio;
+    
+    SvgRasterizer::instance()->prefetch(NORMAL_FOOD_SVG, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
+    SvgRasterizer::instance()->prefetch(SPECIAL_FOOD_SVG, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
 }
 
 bool Food::isExpired() const
@@ -87,41 +109,14 @@ void Food::onTimeout()
 
 void Food::loadFoodPixmaps()
 {
-    // 使用QSvgRenderer加载SVG文件
-    QSvgRenderer normalRenderer;
-    QSvgRenderer specialRenderer;
-    normalRenderer.load(QString(":/images/krabby_patty.svg"));
-    specialRenderer.load(QString(":/images/golden_spatula.svg"));
+    // SVG由SvgRasterizer按物理像素尺寸栅格化，这里预热一次缓存
+    SvgRasterizer* rasterizer = SvgRasterizer::instance();
+    const QSize size(spriteSize, spriteSize);
     
-    if (normalRenderer.isValid()) {
-        qDebug() << "Successfully loaded normal food SVG";
-        normalFoodPixmap = QPixmap(20, 20);
-        normalFoodPixmap.fill(Qt::transparent);
-        QPainter painter(&normalFoodPixmap);
-        normalRenderer.render(&painter);
-    } else {
+    if (rasterizer->pixmap(NORMAL_FOOD_SVG, size, spriteDevicePixelRatio).isNull()) {
         qDebug() << "Failed to load normal food SVG";
-        normalFoodPixmap = QPixmap(20, 20);
-        QPainter painter(&normalFoodPixmap);
-        painter.fillRect(0, 0, 20, 20, Qt::red);
-        painter.setPen(Qt::darkRed);
-        painter.drawEllipse(2, 2, 16, 16);
     }
-    
-    if (specialRenderer.isValid()) {
-        qDebug() << "Successfully loaded special food SVG";
-        specialFoodPixmap = QPixmap(20, 20);
-        specialFoodPixmap.fill(Qt::transparent);
-        QPainter painter(&specialFoodPixmap);
-        specialRenderer.render(&painter);
-    } else {
+    if (rasterizer->pixmap(SPECIAL_FOOD_SVG, size, spriteDevicePixelRatio).isNull()) {
         qDebug() << "Failed to load special food SVG";
-        specialFoodPixmap = QPixmap(20, 20);
-        QPainter painter(&specialFoodPixmap);
-        painter.fillRect(0, 0, 20, 20, Qt::yellow);
-        painter.setPen(Qt::darkYellow);
-        painter.drawEllipse(2, 2, 16, 16);
-        painter.setPen(Qt::red);
-        painter.drawText(6, 14, "★");
     }
-}
\ No newline at end of file
+}
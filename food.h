@@ -4,7 +4,7 @@
 #include <QtCore>
 #include <QObject>
 #include <QPixmap>
-#include <QTimer>
+#include "framescheduler.h"
 #include "gamestate.h"
 
 class Food : public QObject
@@ -26,6 +26,9 @@ public:
     
     QPixmap getPixmap() const;
     
+    // 设置精灵的逻辑尺寸和设备像素比，新尺寸在后台栅格化
+    void setSpriteSize(int logicalSize, qreal devicePixelRatio);
+    
     bool isExpired() const;
     void startTimer();
     void stopTimer();
@@ -40,10 +43,12 @@ private:
     Point position;
     bool special;
     int value;
-    QTimer* timer;
+    FrameTimer* timer;
+    
+    int spriteSize;
+    qreal spriteDevicePixelRatio;
     
-    QPixmap normalFoodPixmap;
-    QPixmap specialFoodPixmap;
+    static const int DEFAULT_SPRITE_SIZE = 20;
     
     void loadFoodPixmaps();
 };
@@ -0,0 +1,198 @@
+#include "frameprofiler.h"
+#include "framescheduler.h"
+#include <QPainter>
+#include <QRect>
+#include <QFont>
+#include <QFontMetrics>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+FrameProfiler* FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return &profiler;
+}
+
+FrameProfiler::FrameProfiler()
+    : enabled(false)
+    , lastTickNs(-1)
+{
+    tickClock.start();
+}
+
+void FrameProfiler::setEnabled(bool enable)
+{
+    if (enabled == enable) {
+        return;
+    }
+    enabled = enable;
+    // 重新打开时从干净的数据开始，避免旧样本干扰判断
+    reset();
+}
+
+void FrameProfiler::reset()
+{
+    for (SampleRing& ring : rings) {
+        ring.next = 0;
+        ring.size = 0;
+    }
+    lastTickNs = -1;
+}
+
+void FrameProfiler::addSample(ProfilePhase phase, double milliseconds)
+{
+    if (!enabled) {
+        return;
+    }
+
+    SampleRing& ring = rings[static_cast<int>(phase)];
+    ring.samples[ring.next] = static_cast<float>(milliseconds);
+    ring.next = (ring.next + 1) % SAMPLE_COUNT;
+    ring.size = qMin(ring.size + 1, static_cast<int>(SAMPLE_COUNT));
+}
+
+void FrameProfiler::recordTick(int expectedIntervalMs)
+{
+    if (!enabled) {
+        return;
+    }
+
+    const qint64 now = tickClock.nsecsElapsed();
+    if (lastTickNs >= 0) {
+        const double actualMs = (now - lastTickNs) / 1000000.0;
+        addSample(ProfilePhase::TickJitter, std::fabs(actualMs - expectedIntervalMs));
+    }
+    lastTickNs = now;
+
+    addSample(ProfilePhase::EventLoopLag, FrameScheduler::instance()->lastWakeLag());
+}
+
+double FrameProfiler::average(ProfilePhase phase) const
+{
+    const SampleRing& ring = rings[static_cast<int>(phase)];
+    if (ring.size == 0) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < ring.size; ++i) {
+        sum += ring.samples[i];
+    }
+    return sum / ring.size;
+}
+
+double FrameProfiler::percentile(ProfilePhase phase, double fraction) const
+{
+    const SampleRing& ring = rings[static_cast<int>(phase)];
+    if (ring.size == 0) {
+        return 0.0;
+    }
+
+    // 只在绘制覆盖层时调用，拷贝一份做部分排序
+    QVector<float> sorted(ring.samples.begin(), ring.samples.begin() + ring.size);
+    const int index = qBound(0, static_cast<int>(std::ceil(fraction * ring.size)) - 1, ring.size - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+QString FrameProfiler::phaseName(ProfilePhase phase)
+{
+    switch (phase) {
+    case ProfilePhase::Simulation: return "simulation";
+    case ProfilePhase::Collision: return "collision";
+    case ProfilePhase::DrawGrid: return "drawGrid";
+    case ProfilePhase::DrawFood: return "drawFood";
+    case ProfilePhase::DrawWalls: return "drawWalls";
+    case ProfilePhase::DrawSnakes: return "drawSnakes";
+    case ProfilePhase::DrawMultiplayer: return "drawMultiplayer";
+    case ProfilePhase::DrawEffects: return "drawEffects";
+    case ProfilePhase::Background: return "background";
+    case ProfilePhase::FrameTotal: return "frame total";
+    case ProfilePhase::TickJitter: return "tick jitter";
+    case ProfilePhase::EventLoopLag: return "loop lag";
+    case ProfilePhase::Count: break;
+    }
+    return QString();
+}
+
+void FrameProfiler::drawOverlay(QPainter& painter, const QRect& area) const
+{
+    painter.save();
+
+    QFont font("Consolas", 9);
+    font.setStyleHint(QFont::Monospace);
+    painter.setFont(font);
+    const QFontMetrics metrics(font);
+    const int lineHeight = metrics.height();
+
+    const int phaseCount = static_cast<int>(ProfilePhase::Count);
+    const int histogramHeight = 60;
+    const QRect panel(area.x() + 10, area.y() + 10, 420,
+                      lineHeight * (phaseCount + 2) + histogramHeight + 20);
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 180));
+    painter.drawRect(panel);
+
+    painter.setPen(Qt::white);
+    int y = panel.y() + lineHeight;
+    painter.drawText(panel.x() + 8, y, QString("%1 %2 %3 %4 %5  (ms, F3 关闭)")
+                     .arg(QStringLiteral("phase"), -16).arg(QStringLiteral("avg"), 7).arg(QStringLiteral("p50"), 7)
+                     .arg(QStringLiteral("p95"), 7).arg(QStringLiteral("p99"), 7));
+
+    for (int i = 0; i < phaseCount; ++i) {
+        const ProfilePhase phase = static_cast<ProfilePhase>(i);
+        y += lineHeight;
+
+        // 超过一帧（16.7ms）的p99标红，一眼找到卡顿来源
+        const double p99 = percentile(phase, 0.99);
+        painter.setPen(p99 > 16.7 ? QColor(255, 99, 71) : QColor(Qt::white));
+        painter.drawText(panel.x() + 8, y, QString("%1 %2 %3 %4 %5")
+                         .arg(phaseName(phase), -16)
+                         .arg(average(phase), 7, 'f', 2)
+                         .arg(percentile(phase, 0.50), 7, 'f', 2)
+                         .arg(percentile(phase, 0.95), 7, 'f', 2)
+                         .arg(p99, 7, 'f', 2));
+    }
+
+    const QRect histogramArea(panel.x() + 8, y + lineHeight / 2, panel.width() - 16, histogramHeight);
+    drawHistogram(painter, histogramArea);
+
+    painter.restore();
+}
+
+void FrameProfiler::drawHistogram(QPainter& painter, const QRect& area) const
+{
+    // 帧耗时直方图：0-32ms，每1ms一个桶，最后一个桶收纳更慢的帧
+    const int bucketCount = 33;
+    std::array<int, bucketCount> buckets{};
+    const SampleRing& ring = rings[static_cast<int>(ProfilePhase::FrameTotal)];
+    for (int i = 0; i < ring.size; ++i) {
+        const int bucket = qBound(0, static_cast<int>(ring.samples[i]), bucketCount - 1);
+        ++buckets[bucket];
+    }
+
+    const int maxCount = qMax(1, *std::max_element(buckets.begin(), buckets.end()));
+    const double barWidth = static_cast<double>(area.width()) / bucketCount;
+
+    painter.setPen(QColor(255, 255, 255, 80));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(area);
+
+    painter.setPen(Qt::NoPen);
+    for (int i = 0; i < bucketCount; ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        const int barHeight = area.height() * buckets[i] / maxCount;
+        painter.setBrush(i >= 16 ? QColor(255, 99, 71) : QColor(100, 200, 120));
+        painter.drawRect(QRectF(area.x() + i * barWidth, area.bottom() - barHeight,
+                                qMax(1.0, barWidth - 1), barHeight));
+    }
+
+    // 16.7ms参考线
+    painter.setPen(QPen(QColor(255, 215, 0), 1, Qt::DashLine));
+    const int frameLineX = area.x() + static_cast<int>(16.7 * barWidth);
+    painter.drawLine(frameLineX, area.top(), frameLineX, area.bottom());
+}
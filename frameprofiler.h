@@ -0,0 +1,106 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QString>
+#include <array>
+
+class QPainter;
+class QRect;
+
+// 被统计的阶段
+enum class ProfilePhase {
+    Simulation = 0,   // 蛇移动等逻辑步进
+    Collision,        // 碰撞检测
+    DrawGrid,
+    DrawFood,
+    DrawWalls,
+    DrawSnakes,
+    DrawMultiplayer,
+    DrawEffects,
+    Background,       // OceanBackground 绘制
+    FrameTotal,       // GameWidget::paintEvent 总耗时
+    TickJitter,       // 实际tick间隔与设定间隔之差
+    EventLoopLag,     // 调度器唤醒相对计划时间的延迟
+    Count
+};
+
+/**
+ * 帧与tick性能分析器
+ * 记录各绘制阶段、逻辑步进、tick抖动和事件循环延迟，并在GameWidget上绘制覆盖层
+ * 特点：
+ * 1. 每个阶段保存最近 SAMPLE_COUNT 个样本的环形缓冲区
+ * 2. 覆盖层显示平均值和 p50/p95/p99，以及帧耗时的滚动直方图
+ * 3. 关闭时只有一次布尔判断，几乎没有开销
+ */
+class FrameProfiler
+{
+public:
+    static FrameProfiler* instance();
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool enable);
+
+    void addSample(ProfilePhase phase, double milliseconds);
+    void recordTick(int expectedIntervalMs);  // 每个游戏tick调用一次，统计抖动和事件循环延迟
+
+    // 统计结果（单位ms）
+    double average(ProfilePhase phase) const;
+    double percentile(ProfilePhase phase, double fraction) const;
+    int sampleCount(ProfilePhase phase) const { return rings[static_cast<int>(phase)].size; }
+
+    void drawOverlay(QPainter& painter, const QRect& area) const;
+    void reset();
+
+    static QString phaseName(ProfilePhase phase);
+
+    static const int SAMPLE_COUNT = 240;  // 约4秒（60fps）
+
+private:
+    FrameProfiler();
+
+    struct SampleRing {
+        std::array<float, SAMPLE_COUNT> samples;
+        int next = 0;
+        int size = 0;
+    };
+
+    void drawHistogram(QPainter& painter, const QRect& area) const;
+
+    bool enabled;
+    std::array<SampleRing, static_cast<int>(ProfilePhase::Count)> rings;
+    QElapsedTimer tickClock;
+    qint64 lastTickNs;
+};
+
+/**
+ * 作用域计时：构造时开始，析构时把耗时计入对应阶段
+ * 分析器关闭时不读取时钟
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfilePhase phase)
+        : phase(phase)
+        , active(FrameProfiler::instance()->isEnabled())
+    {
+        if (active) {
+            timer.start();
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (active) {
+            FrameProfiler::instance()->addSample(phase, timer.nsecsElapsed() / 1000000.0);
+        }
+    }
+
+private:
+    ProfilePhase phase;
+    bool active;
+    QElapsedTimer timer;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,223 @@
+#include "framescheduler.h"
+#include <QTimer>
+#include <QWidget>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QtMath>
+#include <QEvent>
+#include <QDebug>
+
+// FrameScheduler 实现
+FrameScheduler* FrameScheduler::instance()
+{
+    // 挂在应用对象上，随应用一起销毁
+    static FrameScheduler* scheduler = new FrameScheduler(QCoreApplication::instance());
+    return scheduler;
+}
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+    , wakeTimer(new QTimer(this))
+    , framePeriodMs(1000.0 / 60.0)
+    , plannedWakeTime(0)
+    , wakeLag(0)
+    , dispatching(false)
+{
+    clock.start();
+    updateFramePeriod();
+
+    // 唯一的唤醒源：单次、高精度，每次唤醒后按最早到期的订阅者重新安排
+    wakeTimer->setSingleShot(true);
+    wakeTimer->setTimerType(Qt::PreciseTimer);
+    connect(wakeTimer, &QTimer::timeout, this, &FrameScheduler::onWake);
+}
+
+void FrameScheduler::updateFramePeriod()
+{
+    QScreen* screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate = screen ? screen->refreshRate() : 60.0;
+    framePeriodMs = 1000.0 / (refreshRate > 1.0 ? refreshRate : 60.0);
+    qDebug() << "FrameScheduler frame period:" << framePeriodMs << "ms";
+}
+
+void FrameScheduler::addTimer(FrameTimer* timer)
+{
+    if (!activeTimers.contains(timer)) {
+        activeTimers.append(timer);
+    }
+    if (!dispatching) {
+        scheduleNextWake();
+    }
+}
+
+void FrameScheduler::removeTimer(FrameTimer* timer)
+{
+    activeTimers.removeOne(timer);
+    if (!dispatching && activeTimers.isEmpty()) {
+        wakeTimer->stop();
+    }
+}
+
+void FrameScheduler::scheduleNextWake()
+{
+    if (activeTimers.isEmpty()) {
+        wakeTimer->stop();
+        return;
+    }
+
+    qint64 earliest = activeTimers.first()->nextDue;
+    for (const FrameTimer* timer : activeTimers) {
+        earliest = qMin(earliest, timer->nextDue);
+    }
+
+    // 唤醒时间对齐到帧边界，让同一帧内到期的订阅者合并为一次唤醒
+    const qint64 now = clock.elapsed();
+    double wake = qCeil(earliest / framePeriodMs) * framePeriodMs;
+    if (wake < now) {
+        wake = now;
+    }
+
+    plannedWakeTime = static_cast<qint64>(wake);
+    wakeTimer->start(qMax(0, qRound(wake - now)));
+}
+
+void FrameScheduler::onWake()
+{
+    const qint64 now = clock.elapsed();
+    wakeLag = qMax<qint64>(0, now - plannedWakeTime);
+
+    // 本帧内（半帧容差）到期的订阅者一并触发
+    const qint64 horizon = now + static_cast<qint64>(framePeriodMs / 2.0);
+    QList<QPointer<FrameTimer>> dueTimers;
+    for (FrameTimer* timer : activeTimers) {
+        if (timer->nextDue <= horizon) {
+            dueTimers.append(timer);
+        }
+    }
+
+    dispatching = true;
+    for (const QPointer<FrameTimer>& timer : dueTimers) {
+        // 前面的回调可能停止、删除或重新启动其他定时器，重启后的到期时间不在本帧内时不能再触发
+        if (!timer || !timer->active || timer->nextDue > horizon) {
+            continue;
+        }
+
+        if (timer->isPaused()) {
+            // 界面不可见：推迟到下一次可见性检查，不触发回调
+            timer->nextDue = now + qMax(timer->intervalMs, static_cast<int>(PAUSED_POLL_INTERVAL));
+            continue;
+        }
+
+        if (timer->singleShotMode) {
+            timer->active = false;
+            activeTimers.removeOne(timer.data());
+        } else {
+            // 保持固定相位推进；落后太多时不补发，直接从当前时间重新计时
+            timer->nextDue += qMax(1, timer->intervalMs);
+            if (timer->nextDue <= now) {
+                timer->nextDue = now + qMax(1, timer->intervalMs);
+            }
+        }
+
+        emit timer->timeout();
+    }
+    dispatching = false;
+
+    scheduleNextWake();
+}
+
+// FrameTimer 实现
+FrameTimer::FrameTimer(QObject *parent)
+    : QObject(parent)
+    , intervalMs(0)
+    , singleShotMode(false)
+    , active(false)
+    , nextDue(0)
+    , hasExplicitWidget(false)
+{
+}
+
+FrameTimer::~FrameTimer()
+{
+    if (active) {
+        FrameScheduler::instance()->removeTimer(this);
+    }
+}
+
+void FrameTimer::start(int msec)
+{
+    intervalMs = msec;
+    start();
+}
+
+void FrameTimer::start()
+{
+    // 监听所属界面的显示和窗口状态变化，重新可见时立即恢复而不必等待轮询
+    QWidget* widget = resolveVisibilityWidget();
+    if (widget && widget != filteredWidget) {
+        if (filteredWidget) {
+            filteredWidget->removeEventFilter(this);
+            filteredWidget->window()->removeEventFilter(this);
+        }
+        widget->installEventFilter(this);
+        widget->window()->installEventFilter(this);
+        filteredWidget = widget;
+    }
+    
+    FrameScheduler* scheduler = FrameScheduler::instance();
+    active = true;
+    nextDue = scheduler->now() + qMax(0, intervalMs);
+    scheduler->addTimer(this);
+}
+
+void FrameTimer::stop()
+{
+    if (!active) {
+        return;
+    }
+    active = false;
+    FrameScheduler::instance()->removeTimer(this);
+}
+
+void FrameTimer::setInterval(int msec)
+{
+    intervalMs = msec;
+    // 与QTimer一致：运行中修改间隔会从现在重新计时
+    if (active) {
+        start();
+    }
+}
+
+bool FrameTimer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (active && (event->type() == QEvent::Show || event->type() == QEvent::WindowStateChange)) {
+        FrameScheduler* scheduler = FrameScheduler::instance();
+        nextDue = qMin(nextDue, scheduler->now() + qMax(0, intervalMs));
+        scheduler->addTimer(this);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+QWidget* FrameTimer::resolveVisibilityWidget() const
+{
+    if (hasExplicitWidget) {
+        return visibilityWidget.data();
+    }
+
+    // 默认使用最近的QWidget祖先决定是否可见
+    for (QObject* object = parent(); object; object = object->parent()) {
+        if (QWidget* widget = qobject_cast<QWidget*>(object)) {
+            return widget;
+        }
+    }
+    return nullptr;
+}
+
+bool FrameTimer::isPaused() const
+{
+    QWidget* widget = resolveVisibilityWidget();
+    if (!widget) {
+        return false;
+    }
+    return !widget->isVisible() || widget->window()->isMinimized();
+}
@@ -0,0 +1,103 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QWidget>
+
+class QTimer;
+class FrameTimer;
+
+/**
+ * 统一帧调度器
+ * 用一个与屏幕刷新率对齐的时钟驱动所有动画和游戏逻辑定时器
+ * 特点：
+ * 1. 所有订阅者共用一个唤醒源，唤醒时间对齐到帧边界，同一帧内到期的订阅者合并触发
+ * 2. 每个订阅者保留自己的间隔，按固定相位推进，不会因帧对齐而累积漂移
+ * 3. 所属界面不可见（隐藏或窗口最小化）的订阅者自动暂停
+ * 4. 没有活动订阅者时时钟完全停止
+ */
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FrameScheduler* instance();
+
+    qint64 now() const { return clock.elapsed(); }
+    double framePeriod() const { return framePeriodMs; }
+
+    // 最近一次唤醒相对计划时间的延迟（事件循环滞后），单位ms
+    qint64 lastWakeLag() const { return wakeLag; }
+
+private:
+    friend class FrameTimer;
+
+    explicit FrameScheduler(QObject *parent = nullptr);
+
+    void addTimer(FrameTimer* timer);
+    void removeTimer(FrameTimer* timer);
+    void scheduleNextWake();
+    void onWake();
+    void updateFramePeriod();
+
+    QTimer* wakeTimer;
+    QElapsedTimer clock;
+    QList<FrameTimer*> activeTimers;
+    double framePeriodMs;
+    qint64 plannedWakeTime;
+    qint64 wakeLag;
+    bool dispatching;
+
+    static const int PAUSED_POLL_INTERVAL = 500;  // 暂停的订阅者每500ms检查一次可见性
+};
+
+/**
+ * 由FrameScheduler驱动的定时器
+ * 接口与QTimer保持一致，可直接替换原有的QTimer成员
+ */
+class FrameTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameTimer(QObject *parent = nullptr);
+    ~FrameTimer();
+
+    void start(int msec);
+    void start();
+    void stop();
+
+    void setInterval(int msec);
+    int interval() const { return intervalMs; }
+    void setSingleShot(bool singleShot) { singleShotMode = singleShot; }
+    bool isSingleShot() const { return singleShotMode; }
+    bool isActive() const { return active; }
+
+    // 指定决定是否暂停的界面；默认使用最近的QWidget祖先
+    void setVisibilityWidget(QWidget* widget) { visibilityWidget = widget; hasExplicitWidget = true; }
+
+signals:
+    void timeout();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    friend class FrameScheduler;
+
+    QWidget* resolveVisibilityWidget() const;
+    bool isPaused() const;
+
+    int intervalMs;
+    bool singleShotMode;
+    bool active;
+    qint64 nextDue;
+    QPointer<QWidget> visibilityWidget;
+    QPointer<QWidget> filteredWidget;  // 已安装事件过滤器、用于在重新显示时立即恢复的界面
+    bool hasExplicitWidget;
+};
+
+#endif // FRAMESCHEDULER_H
@@ -9,6 +9,11 @@
 #include <QApplication>
 #include <QMetaObject>
 #include <QCoreApplication>
+#include <QWindow>
+#include <QScreen>
+#include <QtMath>
+#include "svgrasterizer.h"
+#include "frameprofiler.h"
 
 GameWidget::GameWidget(QWidget *parent)
     : QWidget(parent)
@@ -21,11 +26,11 @@ GameWidget::GameWidget(QWidget *parent)
     , player2Snake(new Snake(this))
     , food(new Food(this))
     , wall(new Wall())
-    , gameTimer(new QTimer(this))
-    , specialFoodTimer(new QTimer(this))
-    , countdownTimer(new QTimer(this))
-    , gridWidth(40)
-    , gridHeight(25)
+    , gameTimer(new FrameTimer(this))
+    , specialFoodTimer(new FrameTimer(this))
+    , countdownTimer(new FrameTimer(this))
+    , gridWidth(DEFAULT_GRID_WIDTH)
+    , gridHeight(DEFAULT_GRID_HEIGHT)
     , cellSize(20)
     , score(0)
     , level(1)
@@ -48,11 +53,15 @@ GameWidget::GameWidget(QWidget *parent)
     , player2Respawning(false)
     , player1RespawnTime(0)
     , player2RespawnTime(0)
-    , respawnTimer(new QTimer(this))
-    , gameTimeTimer(new QTimer(this))
+    , respawnTimer(new FrameTimer(this))
+    , gameTimeTimer(new FrameTimer(this))
     , totalGameTime(0)
     , settings(new QSettings("SnakeGame", "SpongeBobSnake", this))
     , specialFoodCounter(0)
+    , observedWindow(nullptr)
+    , effectParticles(MAX_EFFECT_PARTICLES)
+    , effectTimer(new FrameTimer(this))
+    , interpolationTimer(new FrameTimer(this))
 {
     qDebug() << "GameWidget constructor called";
     setupUI();
@@ -60,10 +69,16 @@ GameWidget::GameWidget(QWidget *parent)
     loadHighScores();
 
     // 连接信号
-    connect(gameTimer, &QTimer::timeout, this, &GameWidget::gameLoop);
+    connect(gameTimer, &FrameTimer::timeout, this, &GameWidget::gameLoop);
     connect(food, &Food::foodExpired, this, &GameWidget::onFoodExpired);
-    connect(countdownTimer, &QTimer::timeout, this, &GameWidget::updateCountdown);
+    connect(countdownTimer, &FrameTimer::timeout, this, &GameWidget::updateCountdown);
+    connect(effectTimer, &FrameTimer::timeout, this, &GameWidget::updateEffects);
+    connect(interpolationTimer, &FrameTimer::timeout, this, &GameWidget::updateInterpolation);
     
+    // 后台栅格化的新尺寸精灵就绪后重绘
+    connect(SvgRasterizer::instance(), &SvgRasterizer::pixmapReady, this, [this]() {
+        update();
+    });
 
     
     // 单人游戏管理器信号连接
@@ -197,15 +212,15 @@ void GameWidget::setupGame()
 {
     // 设置游戏计时器
     specialFoodTimer->setSingleShot(true);
-    connect(specialFoodTimer, &QTimer::timeout, [this]() {
+    connect(specialFoodTimer, &FrameTimer::timeout, [this]() {
         generateSpecialFood();
     });
     
     // 设置复活计时器
-    connect(respawnTimer, &QTimer::timeout, this, &GameWidget::updateRespawnTimer);
+    connect(respawnTimer, &FrameTimer::timeout, this, &GameWidget::updateRespawnTimer);
     
     // 设置游戏总时间计时器
-    connect(gameTimeTimer, &QTimer::timeout, this, &GameWidget::updateGameTimer);
+    connect(gameTimeTimer, &FrameTimer::timeout, this, &GameWidget::updateGameTimer);
 }
 
 void GameWidget::setCharacter(CharacterType character)
@@ -439,6 +454,8 @@ void GameWidget::resetGame()
     gameTimer->stop();
     specialFoodTimer->stop();
     countdownTimer->stop();  // 停止倒计时器
+    effectTimer->stop();
+    effectParticles.clear();
     
     // 隐藏时间标签
     if (timeLabel) {
@@ -491,23 +508,34 @@ void GameWidget::gameLoop()
         return;
     }
     
+    FrameProfiler::instance()->recordTick(currentSpeed);
+    
     if (isLocalCoop) {
         // 本地双人游戏模式
-        if (player1Alive) {
-            snake->move();
-        }
-        if (player2Alive && player2Snake) {
-            player2Snake->move();
+        {
+            ProfileScope profile(ProfilePhase::Simulation);
+            if (player1Alive) {
+                snake->move();
+            }
+            if (player2Alive && player2Snake) {
+                player2Snake->move();
+            }
         }
         
         checkLocalCoopCollisions();
     } else if (currentState == GameState::MULTIPLAYER_GAME) {
         // 旧多人游戏模式已移除，暂时保留状态检查
-        snake->move();
+        {
+            ProfileScope profile(ProfilePhase::Simulation);
+            snake->move();
+        }
         checkCollisions();
     } else {
         // 单人游戏模式
-        snake->move();
+        {
+            ProfileScope profile(ProfilePhase::Simulation);
+            snake->move();
+        }
         
         // AI蛇通过独立的定时器控制移动，不在这里调用
         
@@ -519,6 +547,8 @@ void GameWidget::gameLoop()
 
 void GameWidget::checkCollisions()
 {
+    ProfileScope profile(ProfilePhase::Collision);
+    
     if (!snake || !food) {
         qCritical() << "Collision check with null pointers! snake:" << snake << "food:" << food;
         return;
@@ -532,6 +562,7 @@ void GameWidget::checkCollisions()
     
     // 检查边界碰撞
     if (snake->checkBoundaryCollision(gridWidth, gridHeight)) {
+        spawnDeathEffect(head);
         currentState = GameState::GAME_OVER;
         gameTimer->stop();
         specialFoodTimer->stop();
@@ -549,6 +580,7 @@ void GameWidget::checkCollisions()
     
     // 检查自身碰撞
     if (snake->checkSelfCollision()) {
+        spawnDeathEffect(head);
         currentState = GameState::GAME_OVER;
         gameTimer->stop();
         specialFoodTimer->stop();
@@ -566,6 +598,7 @@ void GameWidget::checkCollisions()
     
     // 检查墙体碰撞
     if (wall && wall->hasWallAt(head)) {
+        spawnDeathEffect(head);
         currentState = GameState::GAME_OVER;
         gameTimer->stop();
         specialFoodTimer->stop();
@@ -591,6 +624,7 @@ void GameWidget::checkCollisions()
         const auto& aiSnakeBody = singlePlayerManager->getAISnake();
         for (const auto& aiSegment : aiSnakeBody) {
             if (head.x == aiSegment.x && head.y == aiSegment.y) {
+                spawnDeathEffect(head);
                 currentState = GameState::GAME_OVER;
                 gameTimer->stop();
                 specialFoodTimer->stop();
@@ -610,6 +644,7 @@ void GameWidget::checkCollisions()
     
     // 检查食物碰撞
     if (head == food->getPosition()) {
+        spawnFoodEffect(head, food->isSpecial());
         snake->grow();
         int points = food->getValue();
         updateScore(points);
@@ -675,6 +710,47 @@ void GameWidget::checkCollisions()
     }
 }
 
+void GameWidget::spawnEffectBurst(const Point& cell, int count, float minSpeed, float maxSpeed,
+                                  float lifetime, float gravity, QRgb color)
+{
+    // 从格子中心向四周随机方向喷射
+    const float centerX = cell.x + 0.5f;
+    const float centerY = cell.y + 0.5f;
+    for (int i = 0; i < count; ++i) {
+        const float angle = QRandomGenerator::global()->bounded(2.0 * M_PI);
+        const float speed = minSpeed + QRandomGenerator::global()->bounded(maxSpeed - minSpeed);
+        const float radius = 0.1f + QRandomGenerator::global()->bounded(0.15);
+        if (effectParticles.spawn(centerX, centerY, speed * qCos(angle), speed * qSin(angle),
+                                  radius, 1.0f, lifetime, color, gravity) < 0) {
+            break; // 粒子池已满，丢弃多余粒子
+        }
+    }
+    
+    if (!effectTimer->isActive()) {
+        effectTimer->start(EFFECT_UPDATE_INTERVAL);
+    }
+}
+
+void GameWidget::spawnFoodEffect(const Point& cell, bool special)
+{
+    spawnEffectBurst(cell, special ? 20 : 12, 2.0f, 5.0f, 0.5f, 0.0f,
+                     special ? qRgb(255, 215, 0) : qRgb(255, 140, 0));
+}
+
+void GameWidget::spawnDeathEffect(const Point& cell)
+{
+    spawnEffectBurst(cell, 24, 3.0f, 7.0f, 0.8f, 6.0f, qRgb(220, 20, 60));
+}
+
+void GameWidget::updateEffects()
+{
+    effectParticles.update(EFFECT_UPDATE_INTERVAL / 1000.0f);
+    if (effectParticles.isEmpty()) {
+        effectTimer->stop();
+    }
+    update();
+}
+
 void GameWidget::generateFood()
 {
     QSet<Point> occupiedPositions = getOccupiedPositions();
@@ -878,6 +954,19 @@ void GameWidget::paintEvent(QPaintEvent *event)
     Q_UNUSED(event)
     
     QPainter painter(this);
+    paintFrame(painter);
+    
+    // 性能分析覆盖层（F3切换），不计入帧耗时
+    if (FrameProfiler::instance()->isEnabled()) {
+        painter.setClipping(false);
+        FrameProfiler::instance()->drawOverlay(painter, rect());
+    }
+}
+
+void GameWidget::paintFrame(QPainter& painter)
+{
+    ProfileScope profile(ProfilePhase::FrameTotal);
+    
     painter.setRenderHint(QPainter::Antialiasing);
     
     // 计算游戏区域的实际位置 - 使用gameArea的位置和大小
@@ -893,22 +982,30 @@ void GameWidget::paintEvent(QPaintEvent *event)
         // 绘制网格（确保在背景之上）
         drawGrid(painter, gameRect);
         
-        // 绘制食物
-        drawFood(painter, gameRect);
-        
-        // 绘制墙体
-        drawWalls(painter, gameRect);
-        
-        // 绘制蛇
-        if (isLocalCoop) {
-            drawLocalCoopSnakes(painter, gameRect);
-        } else {
+        if (interpolationTimer->isActive()) {
+            // 热点对战客户端：主机模拟中没有墙，食物和本地蛇已同步为管理器的预测状态
+            drawFood(painter, gameRect);
+            drawHotspotSpecialFood(painter, gameRect);
             drawSnake(painter, gameRect);
-        }
-        
-        // 绘制其他玩家的蛇（多人游戏）或AI蛇（AI对战模式）
-        if (isMultiplayer || (singlePlayerManager && singlePlayerManager->getCurrentMode() == SinglePlayerMode::AI_BATTLE)) {
-            drawMultiplayerSnakes(painter, gameRect);
+            drawInterpolatedPlayers(painter, gameRect);
+        } else {
+            // 绘制食物
+            drawFood(painter, gameRect);
+            
+            // 绘制墙体
+            drawWalls(painter, gameRect);
+            
+            // 绘制蛇
+            if (isLocalCoop) {
+                drawLocalCoopSnakes(painter, gameRect);
+            } else {
+                drawSnake(painter, gameRect);
+            }
+            
+            // 绘制其他玩家的蛇（多人游戏）或AI蛇（AI对战模式）
+            if (isMultiplayer || (singlePlayerManager && singlePlayerManager->getCurrentMode() == SinglePlayerMode::AI_BATTLE)) {
+                drawMultiplayerSnakes(painter, gameRect);
+            }
         }
         
         // 恢复状态
@@ -929,6 +1026,14 @@ void GameWidget::paintEvent(QPaintEvent *event)
 
     }
     
+    // 绘制粒子特效（游戏结束后死亡特效仍需播放完）
+    if (!effectParticles.isEmpty()) {
+        painter.save();
+        painter.setClipRect(gameRect);
+        drawEffects(painter, gameRect);
+        painter.restore();
+    }
+    
     // 绘制UI覆盖层
     if (currentState == GameState::PAUSED) {
         drawPauseOverlay(painter, gameRect);
@@ -939,6 +1044,8 @@ void GameWidget::paintEvent(QPaintEvent *event)
 
 void GameWidget::drawGrid(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawGrid);
+    
     painter.setPen(QPen(QColor(100, 149, 237, 100), 1)); // 半透明网格线
     
     // 绘制垂直线
@@ -956,6 +1063,8 @@ void GameWidget::drawGrid(QPainter& painter, const QRect& gameRect)
 
 void GameWidget::drawSnake(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawSnakes);
+    
     const auto& body = snake->getBody();
     
     if (body.empty()) {
@@ -1001,6 +1110,8 @@ void GameWidget::drawSnake(QPainter& painter, const QRect& gameRect)
 
 void GameWidget::drawFood(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawFood);
+    
     Point foodPos = food->getPosition();
     
     QRect foodRect(gameRect.x() + foodPos.x * cellSize + 2, 
@@ -1023,6 +1134,8 @@ void GameWidget::drawFood(QPainter& painter, const QRect& gameRect)
 
 void GameWidget::drawWalls(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawWalls);
+    
     if (!wall) return;
     
     const QSet<Point>& wallPositions = wall->getWallPositions();
@@ -1051,6 +1164,8 @@ void GameWidget::drawWalls(QPainter& painter, const QRect& gameRect)
 
 void GameWidget::drawMultiplayerSnakes(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawMultiplayer);
+    
     // 绘制AI蛇（如果在AI对战模式中）
     if (singlePlayerManager && singlePlayerManager->getCurrentMode() == SinglePlayerMode::AI_BATTLE) {
         const auto& aiSnakeBody = singlePlayerManager->getAISnake();
@@ -1058,6 +1173,7 @@ void GameWidget::drawMultiplayerSnakes(QPainter& painter, const QRect& gameRect)
             // 使用Snake类来渲染AI蛇
             Snake aiSnakeRenderer(this);
             aiSnakeRenderer.setCharacter(singlePlayerManager->getAISnakeCharacter()); // 使用AI专属角色
+            aiSnakeRenderer.setSpriteSize(cellSize, devicePixelRatioF());
             aiSnakeRenderer.setBody(aiSnakeBody);
             // 设置AI蛇的当前方向，避免身体斜着显示
             aiSnakeRenderer.setCurrentDirection(singlePlayerManager->getAIDirection());
@@ -1163,6 +1279,24 @@ void GameWidget::drawMultiplayerSnakes(QPainter& painter, const QRect& gameRect)
     }
 }
 
+void GameWidget::drawEffects(QPainter& painter, const QRect& gameRect)
+{
+    ProfileScope profile(ProfilePhase::DrawEffects);
+    
+    // 粒子坐标以格子为单位，随格子大小缩放
+    painter.setPen(Qt::NoPen);
+    for (int i = 0; i < effectParticles.count(); ++i) {
+        QColor color = QColor::fromRgb(effectParticles.color(i));
+        color.setAlphaF(qBound(0.0f, effectParticles.fadedOpacity(i), 1.0f));
+        painter.setBrush(color);
+        
+        const qreal radius = effectParticles.radius(i) * cellSize;
+        painter.drawEllipse(QPointF(gameRect.x() + effectParticles.x(i) * cellSize,
+                                    gameRect.y() + effectParticles.y(i) * cellSize),
+                            radius, radius);
+    }
+}
+
 void GameWidget::drawPauseOverlay(QPainter& painter, const QRect& gameRect)
 {
     // 半透明背景
@@ -1209,6 +1343,13 @@ void GameWidget::keyPressEvent(QKeyEvent *event)
     bool handled = false;
     
     switch (event->key()) {
+    case Qt::Key_F3:
+        // 切换性能分析覆盖层，玩家反馈卡顿时首先查看这里
+        FrameProfiler::instance()->setEnabled(!FrameProfiler::instance()->isEnabled());
+        update();
+        handled = true;
+        break;
+        
     case Qt::Key_Up:
         if (isLocalCoop && player2Alive && player2Snake) {
             // 本地双人模式：方向键控制玩家2
@@ -1390,6 +1531,32 @@ void GameWidget::updateGameArea()
     cellSize = qMax(15, qMin(25, maxCellSize)); // 限制格子大小在15-25之间
     
     gameArea->setFixedSize(gridWidth * cellSize, gridHeight * cellSize);
+    updateSpriteSizes();
+}
+
+void GameWidget::updateSpriteSizes()
+{
+    // 按当前格子大小和屏幕像素比请求精灵，新尺寸就绪前继续使用旧尺寸
+    const qreal dpr = devicePixelRatioF();
+    snake->setSpriteSize(cellSize, dpr);
+    player2Snake->setSpriteSize(cellSize, dpr);
+    food->setSpriteSize(cellSize, dpr);
+}
+
+void GameWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    
+    // 窗口移动到不同像素比的屏幕时重新栅格化精灵
+    QWindow* window = this->window()->windowHandle();
+    if (window && window != observedWindow) {
+        observedWindow = window;
+        connect(window, &QWindow::screenChanged, this, [this](QScreen*) {
+            updateSpriteSizes();
+            update();
+        });
+    }
+    updateSpriteSizes();
 }
 
 void GameWidget::updateButtonPositions()
@@ -1497,12 +1664,15 @@ void GameWidget::startLocalCoopGame(SinglePlayerMode mode)
 
 void GameWidget::checkLocalCoopCollisions()
 {
+    ProfileScope profile(ProfilePhase::Collision);
+    
     // 检查玩家1的碰撞
     if (player1Alive) {
         Point head1 = snake->getHead();
         
         // 检查边界碰撞
         if (head1.x < 0 || head1.x >= gridWidth || head1.y < 0 || head1.y >= gridHeight) {
+            spawnDeathEffect(head1);
             player1Alive = false;
             player1Lives--;
             if (player1Lives > 0) {
@@ -1519,6 +1689,7 @@ void GameWidget::checkLocalCoopCollisions()
         auto body1 = snake->getBody();
         for (size_t i = 1; i < body1.size(); ++i) {
             if (head1 == body1[i]) {
+                spawnDeathEffect(head1);
                 player1Alive = false;
                 player1Lives--;
                 if (player1Lives > 0) {
@@ -1538,6 +1709,7 @@ void GameWidget::checkLocalCoopCollisions()
             auto body2 = player2Snake->getBody();
             for (const auto& segment : body2) {
                 if (head1 == segment) {
+                    spawnDeathEffect(head1);
                     player1Alive = false;
                     player1Lives--;
                     if (player1Lives > 0) {
@@ -1555,6 +1727,7 @@ void GameWidget::checkLocalCoopCollisions()
         
         // 检查墙体碰撞
         if (wall && wall->hasWallAt(head1)) {
+            spawnDeathEffect(head1);
             player1Alive = false;
             player1Lives--;
             if (player1Lives > 0) {
@@ -1573,6 +1746,7 @@ void GameWidget::checkLocalCoopCollisions()
         
         // 检查食物碰撞
         if (head1 == food->getPosition()) {
+            spawnFoodEffect(head1, food->isSpecial());
             snake->grow();
             if (food->isSpecial()) {
                 player1Score += 20;
@@ -1593,6 +1767,7 @@ void GameWidget::checkLocalCoopCollisions()
         
         // 检查边界碰撞
         if (head2.x < 0 || head2.x >= gridWidth || head2.y < 0 || head2.y >= gridHeight) {
+            spawnDeathEffect(head2);
             player2Alive = false;
             player2Lives--;
             if (player2Lives > 0) {
@@ -1609,6 +1784,7 @@ void GameWidget::checkLocalCoopCollisions()
         auto body2 = player2Snake->getBody();
         for (size_t i = 1; i < body2.size(); ++i) {
             if (head2 == body2[i]) {
+                spawnDeathEffect(head2);
                 player2Alive = false;
                 player2Lives--;
                 if (player2Lives > 0) {
@@ -1628,6 +1804,7 @@ void GameWidget::checkLocalCoopCollisions()
             auto body1 = snake->getBody();
             for (const auto& segment : body1) {
                 if (head2 == segment) {
+                    spawnDeathEffect(head2);
                     player2Alive = false;
                     player2Lives--;
                     if (player2Lives > 0) {
@@ -1645,6 +1822,7 @@ void GameWidget::checkLocalCoopCollisions()
         
         // 检查墙体碰撞
         if (wall && wall->hasWallAt(head2)) {
+            spawnDeathEffect(head2);
             player2Alive = false;
             player2Lives--;
             if (player2Lives > 0) {
@@ -1663,6 +1841,7 @@ void GameWidget::checkLocalCoopCollisions()
         
         // 检查食物碰撞
         if (head2 == food->getPosition()) {
+            spawnFoodEffect(head2, food->isSpecial());
             player2Snake->grow();
             if (food->isSpecial()) {
                 player2Score += 20;
@@ -1683,6 +1862,8 @@ void GameWidget::checkLocalCoopCollisions()
 
 void GameWidget::drawLocalCoopSnakes(QPainter& painter, const QRect& gameRect)
 {
+    ProfileScope profile(ProfilePhase::DrawSnakes);
+    
     // 绘制玩家1的蛇
     if (player1Alive && snake) {
         const auto& body1 = snake->getBody();
@@ -2019,5 +2200,127 @@ void GameWidget::drawPlayerStatusPanel(QPainter& painter)
 
 void GameWidget::setHotspotGameManager(HotspotGameManager* manager)
 {
+    if (hotspotGameManager) {
+        disconnect(hotspotGameManager, nullptr, this, nullptr);
+    }
+    
     hotspotGameManager = manager;
+    interpolationTimer->stop();
+    interpolatedPlayers.clear();
+    
+    if (hotspotGameManager) {
+        connect(hotspotGameManager, &HotspotGameManager::gameStateUpdated,
+                this, &GameWidget::onHotspotGameStateUpdated);
+        connect(hotspotGameManager, &HotspotGameManager::roomDestroyed, this, [this]() {
+            stopHotspotView();
+        });
+    }
+}
+
+void GameWidget::onHotspotGameStateUpdated(const HotspotGameState& state)
+{
+    if (!state.isGameStarted || hotspotGameManager->isHost()) {
+        if (interpolationTimer->isActive()) {
+            stopHotspotView();
+        }
+        return;
+    }
+    
+    // 地图大小以主机模拟为准，与单机默认值不同
+    const int hotspotWidth = hotspotGameManager->getGridWidth();
+    const int hotspotHeight = hotspotGameManager->getGridHeight();
+    if (gridWidth != hotspotWidth || gridHeight != hotspotHeight) {
+        gridWidth = hotspotWidth;
+        gridHeight = hotspotHeight;
+        updateGameArea();
+    }
+    
+    // 本地蛇取管理器中已包含本地预测的状态，而不是startMultiPlayerGame放置的占位蛇；观战时为空
+    const QString localPlayerName = hotspotGameManager->getLocalPlayerName();
+    snake->setBody(state.playerSnakes.value(localPlayerName));
+    snake->setCurrentDirection(state.playerDirections.value(localPlayerName, Direction::RIGHT));
+    food->setPosition(state.foodPosition);
+    food->setSpecial(false);
+    
+    // 快照到达频率低于显示刷新率，客户端对局期间由独立的定时器逐帧重绘
+    if (!interpolationTimer->isActive()) {
+        interpolationTimer->start(INTERPOLATION_UPDATE_INTERVAL);
+    }
+}
+
+void GameWidget::stopHotspotView()
+{
+    interpolationTimer->stop();
+    interpolatedPlayers.clear();
+    if (gridWidth != DEFAULT_GRID_WIDTH || gridHeight != DEFAULT_GRID_HEIGHT) {
+        gridWidth = DEFAULT_GRID_WIDTH;
+        gridHeight = DEFAULT_GRID_HEIGHT;
+        updateGameArea();
+    }
+    update();
+}
+
+void GameWidget::updateInterpolation()
+{
+    if (!hotspotGameManager || !hotspotGameManager->getInterpolatedSnakes(interpolatedPlayers)) {
+        interpolatedPlayers.clear();
+    }
+    update();
+}
+
+void GameWidget::drawHotspotSpecialFood(QPainter& painter, const QRect& gameRect)
+{
+    const HotspotGameState state = hotspotGameManager->getGameState();
+    if (!state.isSpecialFood) {
+        return;
+    }
+    
+    // 与drawFood中特殊食物的备用样式一致
+    QRect foodRect(gameRect.x() + state.specialFoodPosition.x * cellSize + 2,
+                   gameRect.y() + state.specialFoodPosition.y * cellSize + 2,
+                   cellSize - 4, cellSize - 4);
+    painter.fillRect(foodRect, Qt::yellow);
+    painter.setPen(Qt::red);
+    painter.drawText(foodRect, Qt::AlignCenter, "★");
+}
+
+void GameWidget::drawInterpolatedPlayers(QPainter& painter, const QRect& gameRect)
+{
+    for (auto it = interpolatedPlayers.constBegin(); it != interpolatedPlayers.constEnd(); ++it) {
+        const QVector<QPointF>& body = it.value();
+        if (body.isEmpty()) continue;
+        
+        CharacterType character = hotspotGameManager->getPlayerCharacter(it.key());
+        QColor playerColor;
+        switch (character) {
+        case CharacterType::SPONGEBOB: playerColor = Qt::yellow; break;
+        case CharacterType::PATRICK: playerColor = Qt::magenta; break;
+        case CharacterType::SQUIDWARD: playerColor = Qt::cyan; break;
+        case CharacterType::SANDY: playerColor = QColor(139, 69, 19); break;
+        case CharacterType::MR_KRABS: playerColor = Qt::red; break;
+        case CharacterType::PLANKTON: playerColor = Qt::green; break;
+        }
+        
+        // 与drawMultiplayerSnakes的样式一致，只是位置可以落在格子之间
+        int maxBodySize = (character == CharacterType::SPONGEBOB) ? 100 : 50;
+        int bodySize = qMin(maxBodySize, cellSize);
+        qreal bodyOffset = (cellSize - bodySize) / 2.0;
+        for (int i = body.size() - 1; i >= 0; --i) {
+            const QPointF& point = body[i];
+            QPointF topLeft(gameRect.x() + point.x() * cellSize, gameRect.y() + point.y() * cellSize);
+            if (i == 0) {
+                painter.fillRect(QRectF(topLeft, QSizeF(cellSize, cellSize)), playerColor.darker(120));
+            } else {
+                painter.fillRect(QRectF(topLeft + QPointF(bodyOffset, bodyOffset), QSizeF(bodySize, bodySize)), playerColor);
+            }
+        }
+        
+        const QPointF& head = body.front();
+        QRectF nameRect(gameRect.x() + head.x() * cellSize,
+                        gameRect.y() + head.y() * cellSize - 15,
+                        cellSize * 3, 15);
+        painter.setPen(Qt::black);
+        painter.setFont(QFont("华文彩云", 8));
+        painter.drawText(nameRect, Qt::AlignCenter, it.key());
+    }
 }
\ No newline at end of file
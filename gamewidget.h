@@ -17,6 +17,8 @@
 #include "snake.h"
 #include "food.h"
 #include "wall.h"
+#include "particlesystem.h"
+#include "framescheduler.h"
 
 #include "singleplayergamemanager.h"
 #include "hotspotgamemanager.h"
@@ -25,6 +27,9 @@
 class GameWidget : public QWidget
 {
     Q_OBJECT
+    
+    // 离屏渲染基准测试需要直接构造合成场景
+    friend class GameWidgetBenchmark;
 
 public:
     explicit GameWidget(QWidget *parent = nullptr);
@@ -67,6 +72,7 @@ protected:
     void paintEvent(QPaintEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
     
 private slots:
     void gameLoop();
@@ -74,11 +80,15 @@ private slots:
     void updateCountdown();  // 更新倒计时
     void updateRespawnTimer();  // 更新复活倒计时
     void updateGameTimer();     // 更新游戏总时间
+    void updateEffects();       // 推进粒子特效
+    void updateInterpolation(); // 按显示刷新率重绘热点对战的远端玩家
+    void onHotspotGameStateUpdated(const HotspotGameState& state);
     
 private:
     void setupUI();
     void setupGame();
     void updateGameArea();
+    void updateSpriteSizes();  // 按格子大小和像素比更新精灵尺寸
     void updateButtonPositions();
     void generateSpecialFood();
     void generateWalls();
@@ -88,12 +98,17 @@ private:
     void saveHighScore();
     void loadHighScores();
     void updateSpeed();
+    void paintFrame(QPainter& painter);  // 绘制一帧游戏画面（不含性能覆盖层）
     void drawGrid(QPainter& painter, const QRect& gameRect);
     void drawSnake(QPainter& painter, const QRect& gameRect);
     void drawLocalCoopSnakes(QPainter& painter, const QRect& gameRect);
     void drawFood(QPainter& painter, const QRect& gameRect);
     void drawWalls(QPainter& painter, const QRect& gameRect);
     void drawMultiplayerSnakes(QPainter& painter, const QRect& gameRect);
+    void drawInterpolatedPlayers(QPainter& painter, const QRect& gameRect);  // 热点对战客户端的远端玩家
+    void drawHotspotSpecialFood(QPainter& painter, const QRect& gameRect);   // 热点对战客户端的特殊食物
+    void stopHotspotView();  // 热点对战客户端对局结束：停止逐帧重绘并恢复默认地图大小
+    void drawEffects(QPainter& painter, const QRect& gameRect);
     void drawUI(QPainter& painter);
     void drawPlayerStatusPanel(QPainter& painter);  // 绘制玩家状态面板
     void drawPauseOverlay(QPainter& painter, const QRect& gameRect);
@@ -101,6 +116,12 @@ private:
     void respawnPlayer(int playerNum);  // 复活玩家
     void endTimeAttackGame();           // 结束时间挑战游戏
     void endLocalCoopGame();            // 结束本地双人游戏
+    
+    // 粒子特效（吃食物、死亡）
+    void spawnEffectBurst(const Point& cell, int count, float minSpeed, float maxSpeed,
+                          float lifetime, float gravity, QRgb color);
+    void spawnFoodEffect(const Point& cell, bool special);
+    void spawnDeathEffect(const Point& cell);
 
     
     QSet<Point> getOccupiedPositions() const;
@@ -131,13 +152,15 @@ private:
     Snake* player2Snake;  // 本地双人游戏的第二个玩家
     Food* food;
     Wall* wall;
-    QTimer* gameTimer;
-    QTimer* specialFoodTimer;
-    QTimer* countdownTimer;  // 时间挑战模式的倒计时器
+    FrameTimer* gameTimer;
+    FrameTimer* specialFoodTimer;
+    FrameTimer* countdownTimer;  // 时间挑战模式的倒计时器
     
     // 游戏参数
     int gridWidth;
-    int gridHeight;
+    int gridHeight;  // 热点对战客户端对局期间取主机模拟的地图大小，结束后恢复默认
+    static const int DEFAULT_GRID_WIDTH = 40;
+    static const int DEFAULT_GRID_HEIGHT = 25;
     int cellSize;
     int score;
     int level;
@@ -179,8 +202,8 @@ private:
     bool player2Respawning;
     int player1RespawnTime;
     int player2RespawnTime;
-    QTimer* respawnTimer;
-    QTimer* gameTimeTimer;  // 游戏总时间计时器
+    FrameTimer* respawnTimer;
+    FrameTimer* gameTimeTimer;  // 游戏总时间计时器
     int totalGameTime;      // 游戏总时间（秒）
     const int RESPAWN_TIME = 10;  // 复活时间（秒）
     const int TOTAL_GAME_TIME = 300;  // 游戏总时长（5分钟）
@@ -192,6 +215,20 @@ private:
     // 特殊食物计时器
     int specialFoodCounter;
     const int SPECIAL_FOOD_INTERVAL = 10; // 每10个普通食物生成一个特殊食物
+    
+    // 已监听屏幕切换的顶层窗口
+    QWindow* observedWindow;
+    
+    // 粒子特效：与背景气泡共用同一套粒子池实现，坐标以格子为单位
+    ParticleSystem effectParticles;
+    FrameTimer* effectTimer;  // 只在有存活粒子时运行
+    static const int MAX_EFFECT_PARTICLES = 256;
+    static const int EFFECT_UPDATE_INTERVAL = 16;  // ms
+    
+    // 热点对战客户端：本地蛇和食物跟随管理器的预测状态，远端玩家按抖动缓冲插值后的位置，坐标以格子为单位
+    QMap<QString, QVector<QPointF>> interpolatedPlayers;
+    FrameTimer* interpolationTimer;  // 只在客户端对局进行中运行，同时标志画面由热点状态驱动
+    static const int INTERPOLATION_UPDATE_INTERVAL = 16;  // ms
 };
 
 #endif // GAMEWIDGET_H
@@ -1,19 +1,51 @@
 #include "hotspotgamemanager.h"
-#include <QJsonDocument>
-#include <QJsonArray>
 #include <QRandomGenerator>
 #include <QDebug>
 #include <QDateTime>  // 新增：用于时间戳管理
+#include <QElapsedTimer>
 #include <algorithm>
 
+namespace {
+
+const HotspotProtocol::SnapshotBaseline* findBaseline(
+    const std::deque<HotspotProtocol::SnapshotBaseline>& history, quint32 sequence)
+{
+    if (sequence == 0) {
+        return nullptr;
+    }
+    for (auto it = history.rbegin(); it != history.rend(); ++it) {
+        if (it->sequence == sequence) {
+            return &(*it);
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
 HotspotGameManager::HotspotGameManager(QObject *parent)
     : QObject(parent)
+    , simulation(GRID_WIDTH, GRID_HEIGHT)
     , networkManager(nullptr)
     , gameTimer(new QTimer(this))
     , countdownTimer(new QTimer(this))
     , syncTimer(new QTimer(this))  // 新增：初始化同步定时器
+    , inputResendTimer(new QTimer(this))
+    , predictionTimer(new QTimer(this))
     , lastGameStateSyncTime(0)
     , hasStateChanged(false)
+    , rosterDirty(false)
+    , snapshotSequence(0)
+    , lastAppliedSequence(0)
+    , inputSequence(0)
+    , lastInputAck(0)
+    , predictedTick(0)
+    , snapshotDirection(Direction::RIGHT)
+    , inputRtt(100.0)
+    , lockstepMode(false)
+    , lockstepResyncPending(false)
+    , spectating(false)
+    , spectatorSequence(0)
 {
     // 设置游戏定时器
     gameTimer->setSingleShot(false);
@@ -23,6 +55,14 @@ HotspotGameManager::HotspotGameManager(QObject *parent)
     countdownTimer->setSingleShot(false);
     connect(countdownTimer, &QTimer::timeout, this, &HotspotGameManager::onCountdownTick);
     
+    // 设置输入重发定时器
+    inputResendTimer->setSingleShot(false);
+    connect(inputResendTimer, &QTimer::timeout, this, &HotspotGameManager::onInputResendTick);
+    
+    // 设置本地预测定时器
+    predictionTimer->setSingleShot(false);
+    connect(predictionTimer, &QTimer::timeout, this, &HotspotGameManager::onPredictionTick);
+    
     // 设置智能同步定时器
     setupSyncTimer();
     
@@ -35,7 +75,7 @@ HotspotGameManager::~HotspotGameManager()
     destroyRoom();
 }
 
-bool HotspotGameManager::createRoom(const QString& hostPlayerName, const QString& roomName)
+bool HotspotGameManager::createRoom(const QString& hostPlayerName, const QString& roomName, int maxPlayers)
 {
     if (!networkManager) {
         qWarning() << "Network manager not set";
@@ -43,7 +83,7 @@ bool HotspotGameManager::createRoom(const QString& hostPlayerName, const QString
     }
     
     // 启动热点主机
-    if (!networkManager->startHotspotHost(roomName)) {
+    if (!networkManager->startHotspotHost(roomName, maxPlayers)) {
         qWarning() << "Failed to start hotspot host";
         return false;
     }
@@ -52,18 +92,23 @@ bool HotspotGameManager::createRoom(const QString& hostPlayerName, const QString
     this->roomName = roomName;
     
     // 添加主机玩家
-    gameState.playerSnakes[hostPlayerName] = std::deque<Point>();
-    gameState.playerCharacters[hostPlayerName] = CharacterType::SPONGEBOB;
-    gameState.playerScores[hostPlayerName] = 0;
-    gameState.playerAliveStatus[hostPlayerName] = true;
-    gameState.playerDirections[hostPlayerName] = Direction::RIGHT;
-    gameState.playerReadyStatus[hostPlayerName] = false;
+    if (!hostPlayerName.isEmpty()) {
+        gameState.playerSnakes[hostPlayerName] = std::deque<Point>();
+        gameState.playerCharacters[hostPlayerName] = CharacterType::SPONGEBOB;
+        gameState.playerScores[hostPlayerName] = 0;
+        gameState.playerAliveStatus[hostPlayerName] = true;
+        gameState.playerDirections[hostPlayerName] = Direction::RIGHT;
+        gameState.playerReadyStatus[hostPlayerName] = false;
+        assignPlayerId(hostPlayerName);
+    }
     
     // 初始化食物位置
-    generateFood();
+    simulation.generateFood(gameState);
     
     emit roomCreated(roomName);
-    emit playerJoined(hostPlayerName);
+    if (!hostPlayerName.isEmpty()) {
+        emit playerJoined(hostPlayerName);
+    }
     
     // 广播初始游戏状态，确保后续连接的客户端能看到房主信息
     broadcastGameState();
@@ -72,25 +117,38 @@ bool HotspotGameManager::createRoom(const QString& hostPlayerName, const QString
     return true;
 }
 
-bool HotspotGameManager::joinRoom(const QString& playerName)
+bool HotspotGameManager::joinRoom(const QString& playerName, bool spectator)
 {
     if (!networkManager || !networkManager->isConnectedToHost()) {
         qWarning() << "Not connected to host";
         return false;
     }
     
-    // 添加玩家到本地游戏状态（客户端临时状态）
-    gameState.playerSnakes[playerName] = std::deque<Point>();
-    gameState.playerCharacters[playerName] = CharacterType::PATRICK;
-    gameState.playerScores[playerName] = 0;
-    gameState.playerAliveStatus[playerName] = true;
-    gameState.playerDirections[playerName] = Direction::RIGHT;
-    gameState.playerReadyStatus[playerName] = false;
+    // 添加玩家到本地游戏状态（客户端临时状态）；观战者不在玩家名单中，也没有本地预测
+    if (!spectator) {
+        gameState.playerSnakes[playerName] = std::deque<Point>();
+        gameState.playerCharacters[playerName] = CharacterType::PATRICK;
+        gameState.playerScores[playerName] = 0;
+        gameState.playerAliveStatus[playerName] = true;
+        gameState.playerDirections[playerName] = Direction::RIGHT;
+        gameState.playerReadyStatus[playerName] = false;
+    }
+    spectating = spectator;
+    receivedSnapshots.clear();
+    lastAppliedSequence = 0;
+    interpolator.clear();
+    pendingInputs.clear();
+    localPlayerName = spectator ? QString() : playerName;
+    inputSequence = 0;
+    lastInputAck = 0;
+    predictedTick = 0;
+    lockstepMode = false;
+    lockstepResyncPending = false;
+    inputResendTimer->stop();
+    predictionTimer->stop();
     
     // 发送加入消息到主机
-    QJsonObject joinMessage;
-    joinMessage["player_name"] = playerName;
-    networkManager->sendMessage("player_join", joinMessage);
+    networkManager->sendPlayerJoin(playerName, spectator);
     
     // 注意：不在这里发射playerJoined信号，等待主机确认后再更新界面
     // 主机会通过onNetworkPlayerConnected处理并广播游戏状态
@@ -107,9 +165,7 @@ void HotspotGameManager::leaveRoom(const QString& playerName)
     } else {
         // 客户端离开，发送离开消息
         if (networkManager && !isHost()) {
-            QJsonObject leaveMessage;
-            leaveMessage["player_name"] = playerName;
-            networkManager->sendMessage("player_leave", leaveMessage);
+            networkManager->sendPlayerLeave(playerName);
         }
         
         removePlayer(playerName);
@@ -144,6 +200,22 @@ void HotspotGameManager::destroyRoom()
     
     // 清理游戏状态
     gameState = HotspotGameState();
+    snapshotHistory.clear();
+    clientSyncStates.clear();
+    receivedSnapshots.clear();
+    lastAppliedSequence = 0;
+    interpolator.clear();
+    pendingInputs.clear();
+    localPlayerName.clear();
+    inputSequence = 0;
+    lastInputAck = 0;
+    predictedTick = 0;
+    lockstepMode = false;
+    lockstepResyncPending = false;
+    lockstepDirections.clear();
+    spectating = false;
+    inputResendTimer->stop();
+    predictionTimer->stop();
     hostPlayerName.clear();
     roomName.clear();
     
@@ -246,7 +318,7 @@ void HotspotGameManager::resetGame()
     }
     
     gameState.gameWinner.clear();
-    generateFood();
+    simulation.generateFood(gameState);
     
     broadcastGameState();
     emit gameReset();
@@ -289,30 +361,46 @@ void HotspotGameManager::updatePlayerDirection(const QString& playerName, Direct
     }
     
     // 防止反向移动
-    Direction currentDirection = gameState.playerDirections[playerName];
-    if ((currentDirection == Direction::UP && direction == Direction::DOWN) ||
-        (currentDirection == Direction::DOWN && direction == Direction::UP) ||
-        (currentDirection == Direction::LEFT && direction == Direction::RIGHT) ||
-        (currentDirection == Direction::RIGHT && direction == Direction::LEFT)) {
+    if (SnakeSimulation::isOppositeDirection(gameState.playerDirections[playerName], direction)) {
+        return;
+    }
+    
+    // 锁步模式下客户端的方向只能随输入包在对应帧生效，本地只发送输入
+    const bool lockstepClient = lockstepMode && !isHost();
+    if (lockstepClient && !pendingInputs.empty() && pendingInputs.back().input.direction == direction) {
         return;
     }
     
     Direction oldDirection = gameState.playerDirections[playerName];
-    gameState.playerDirections[playerName] = direction;
+    if (!lockstepClient) {
+        gameState.playerDirections[playerName] = direction;
+    }
     
     // 优化：方向变化立即同步，不等待游戏状态同步
     if (oldDirection != direction && networkManager) {
         if (isHost()) {
+            // 锁步模式下方向变化随下一帧的输入包下发
+            if (lockstepMode) {
+                return;
+            }
+            
             // 主机立即广播方向变化
-            QJsonObject directionData;
-            directionData["player_name"] = playerName;
-            directionData["direction"] = static_cast<int>(direction);
-            networkManager->sendMessage("player_direction", directionData);
+            networkManager->broadcastState(
+                HotspotProtocol::encodePlayerDirection(gameState.playerIds.value(playerName), direction));
         } else {
-            // 客户端立即发送方向变化
-            QJsonObject directionData;
-            directionData["direction"] = static_cast<int>(direction);
-            networkManager->sendPlayerData(playerName, directionData);
+            // 客户端：方向已在本地生效，下一次预测步进就能看到；
+            // 同时连同尚未确认的输入一起发给主机，丢包时由后续消息补齐
+            PendingInput pending;
+            pending.input.sequence = ++inputSequence;
+            pending.input.direction = direction;
+            pending.tick = predictedTick + 1;
+            pending.sentTime = QDateTime::currentMSecsSinceEpoch();
+            pendingInputs.push_back(pending);
+            while (pendingInputs.size() > static_cast<size_t>(MAX_PENDING_INPUTS)) {
+                pendingInputs.pop_front();
+            }
+            sendPendingInputs();
+            inputResendTimer->start(INPUT_RESEND_INTERVAL);
         }
     }
 }
@@ -325,6 +413,8 @@ void HotspotGameManager::removePlayer(const QString& playerName)
     gameState.playerAliveStatus.remove(playerName);
     gameState.playerDirections.remove(playerName);
     gameState.playerReadyStatus.remove(playerName);
+    gameState.playerIds.remove(playerName);
+    gameState.playerInputSequences.remove(playerName);
 }
 
 bool HotspotGameManager::isHost() const
@@ -343,14 +433,38 @@ void HotspotGameManager::setNetworkManager(HotspotNetworkManager* manager)
     
     if (networkManager) {
         // 连接网络信号
-        connect(networkManager, &HotspotNetworkManager::playerDataReceived,
-                this, &HotspotGameManager::onNetworkPlayerData);
+        connect(networkManager, &HotspotNetworkManager::playerUpdateReceived,
+                this, &HotspotGameManager::onNetworkPlayerUpdate);
+        connect(networkManager, &HotspotNetworkManager::rosterReceived,
+                this, &HotspotGameManager::onNetworkRoster);
         connect(networkManager, &HotspotNetworkManager::gameStateReceived,
                 this, &HotspotGameManager::onNetworkGameState);
+        connect(networkManager, &HotspotNetworkManager::playerDirectionReceived,
+                this, &HotspotGameManager::onNetworkPlayerDirection);
+        connect(networkManager, &HotspotNetworkManager::snapshotAckReceived,
+                this, &HotspotGameManager::onNetworkSnapshotAck);
+        connect(networkManager, &HotspotNetworkManager::keyframeRequested,
+                this, &HotspotGameManager::onNetworkKeyframeRequest);
+        connect(networkManager, &HotspotNetworkManager::playerInputReceived,
+                this, &HotspotGameManager::onNetworkPlayerInput);
+        connect(networkManager, &HotspotNetworkManager::inputAckReceived,
+                this, &HotspotGameManager::onNetworkInputAck);
+        connect(networkManager, &HotspotNetworkManager::lockstepStartReceived,
+                this, &HotspotGameManager::onNetworkLockstepStart);
+        connect(networkManager, &HotspotNetworkManager::inputBundleReceived,
+                this, &HotspotGameManager::onNetworkInputBundle);
         connect(networkManager, &HotspotNetworkManager::playerConnectedToHost,
                 this, &HotspotGameManager::onNetworkPlayerConnected);
         connect(networkManager, &HotspotNetworkManager::playerDisconnectedFromHost,
                 this, &HotspotGameManager::onNetworkPlayerDisconnected);
+        connect(networkManager, &HotspotNetworkManager::playerConnectionLost,
+                this, &HotspotGameManager::onNetworkPlayerConnectionLost);
+        connect(networkManager, &HotspotNetworkManager::playerReconnected,
+                this, &HotspotGameManager::onNetworkPlayerReconnected);
+        connect(networkManager, &HotspotNetworkManager::sessionResumed,
+                this, &HotspotGameManager::onNetworkSessionResumed);
+        connect(networkManager, &HotspotNetworkManager::spectatorJoined,
+                this, &HotspotGameManager::onNetworkSpectatorJoined);
     }
 }
 
@@ -360,8 +474,16 @@ void HotspotGameManager::onGameTick()
         return;
     }
     
+    QElapsedTimer tickClock;
+    tickClock.start();
+    
     updateGameLogic();
     
+    const qint64 elapsedUs = tickClock.nsecsElapsed() / 1000;
+    tickTiming.averageUs += (elapsedUs - tickTiming.averageUs) / (tickTiming.ticks == 0 ? 1.0 : 16.0);
+    tickTiming.peakUs = qMax(tickTiming.peakUs, elapsedUs);
+    ++tickTiming.ticks;
+    
     // 优化：标记状态已变化，但不立即广播
     hasStateChanged = true;
 }
@@ -385,550 +507,856 @@ void HotspotGameManager::onCountdownTick()
     }
 }
 
-void HotspotGameManager::onNetworkPlayerData(const QString& playerName, const QJsonObject& playerData)
+void HotspotGameManager::onNetworkPlayerUpdate(const QString& playerName, const HotspotProtocol::PlayerUpdate& update)
 {
     // 处理接收到的玩家数据
-    if (playerData.contains("direction")) {
-        Direction direction = static_cast<Direction>(playerData["direction"].toInt());
-        updatePlayerDirection(playerName, direction);
+    if (update.fields & HotspotProtocol::UpdateDirection) {
+        updatePlayerDirection(playerName, update.direction);
     }
     
-    if (playerData.contains("character")) {
-        CharacterType character = static_cast<CharacterType>(playerData["character"].toInt());
+    if (update.fields & HotspotProtocol::UpdateCharacter) {
         // 直接更新状态，避免循环调用syncPlayerData
         CharacterType oldCharacter = gameState.playerCharacters.value(playerName, CharacterType::SPONGEBOB);
-        if (oldCharacter != character) {
-            gameState.playerCharacters[playerName] = character;
-            emit playerCharacterChanged(playerName, character);
-            qDebug() << "Player" << playerName << "character updated from network:" << static_cast<int>(character);
+        if (oldCharacter != update.character) {
+            gameState.playerCharacters[playerName] = update.character;
+            rosterDirty = true;
+            emit playerCharacterChanged(playerName, update.character);
+            qDebug() << "Player" << playerName << "character updated from network:" << static_cast<int>(update.character);
         }
     }
     
-    if (playerData.contains("ready")) {
-        bool ready = playerData["ready"].toBool();
+    if (update.fields & HotspotProtocol::UpdateReady) {
         // 直接更新状态，避免循环调用syncPlayerData
         bool oldReady = gameState.playerReadyStatus.value(playerName, false);
-        if (oldReady != ready) {
-            gameState.playerReadyStatus[playerName] = ready;
-            emit playerReadyChanged(playerName, ready);
-            qDebug() << "Player" << playerName << "ready status updated from network:" << ready;
+        if (oldReady != update.ready) {
+            gameState.playerReadyStatus[playerName] = update.ready;
+            rosterDirty = true;
+            emit playerReadyChanged(playerName, update.ready);
+            qDebug() << "Player" << playerName << "ready status updated from network:" << update.ready;
         }
     }
 }
 
-void HotspotGameManager::onNetworkGameState(const QJsonObject& gameStateJson)
+void HotspotGameManager::onNetworkRoster(const QByteArray& payload)
 {
-    // 客户端接收游戏状态更新
-    if (!isHost()) {
-        // 保存旧的玩家列表
-        QStringList oldPlayers = gameState.playerSnakes.keys();
-        
-        gameStateFromJson(gameStateJson);
-        
-        // 检查是否有新玩家加入
-        QStringList newPlayers = gameState.playerSnakes.keys();
-        for (const QString& playerName : newPlayers) {
-            if (!oldPlayers.contains(playerName)) {
-                emit playerJoined(playerName);
-            }
+    // 客户端接收玩家名单
+    if (isHost()) {
+        return;
+    }
+    
+    // 保存旧的玩家列表
+    QStringList oldPlayers = gameState.playerSnakes.keys();
+    
+    HotspotProtocol::Reader reader(payload);
+    if (!HotspotProtocol::decodeRoster(reader, gameState, hostPlayerName)) {
+        qWarning() << "Malformed roster message ignored";
+        return;
+    }
+    
+    // 检查是否有新玩家加入
+    QStringList newPlayers = gameState.playerSnakes.keys();
+    for (const QString& playerName : newPlayers) {
+        if (!oldPlayers.contains(playerName)) {
+            emit playerJoined(playerName);
         }
-        
-        // 检查是否有玩家离开
-        for (const QString& playerName : oldPlayers) {
-            if (!newPlayers.contains(playerName)) {
-                emit playerLeft(playerName);
-            }
+    }
+    
+    // 检查是否有玩家离开
+    for (const QString& playerName : oldPlayers) {
+        if (!newPlayers.contains(playerName)) {
+            emit playerLeft(playerName);
         }
-        
-        emit gameStateUpdated(gameState);
     }
+    
+    emit gameStateUpdated(gameState);
 }
 
-void HotspotGameManager::onNetworkPlayerConnected(const QString& playerName)
+void HotspotGameManager::onNetworkGameState(const QByteArray& payload)
 {
-    if (isHost()) {
-        // 主机处理新玩家连接
-        if (!gameState.playerSnakes.contains(playerName)) {
-            gameState.playerSnakes[playerName] = std::deque<Point>();
-            gameState.playerCharacters[playerName] = CharacterType::PATRICK;
-            gameState.playerScores[playerName] = 0;
-            gameState.playerAliveStatus[playerName] = true;
-            gameState.playerDirections[playerName] = Direction::RIGHT;
-            gameState.playerReadyStatus[playerName] = false;
-            
-            emit playerJoined(playerName);
-            broadcastGameState();
+    // 客户端接收游戏状态更新
+    if (isHost() || !networkManager) {
+        return;
+    }
+    
+    HotspotProtocol::Reader reader(payload);
+    HotspotProtocol::SnapshotHeader header;
+    if (!HotspotProtocol::decodeSnapshotHeader(reader, header)) {
+        qWarning() << "Malformed game state message ignored";
+        return;
+    }
+    
+    // 序号不比已应用的新，说明是过期快照
+    if (lastAppliedSequence != 0 && header.sequence <= lastAppliedSequence) {
+        return;
+    }
+    
+    // 增量快照需要本地仍保留对应的基线，否则请求关键帧
+    const HotspotProtocol::SnapshotBaseline* baseline = nullptr;
+    if (header.baseSequence != 0) {
+        baseline = findBaseline(receivedSnapshots, header.baseSequence);
+        if (!baseline) {
+            qWarning() << "Missing snapshot baseline" << header.baseSequence << ", requesting keyframe";
+            networkManager->sendToHost(HotspotProtocol::encodeKeyframeRequest());
+            return;
         }
     }
+    
+    if (!HotspotProtocol::decodeGameState(reader, baseline, gameState)) {
+        qWarning() << "Malformed game state message, requesting keyframe";
+        networkManager->sendToHost(HotspotProtocol::encodeKeyframeRequest());
+        return;
+    }
+    
+    gameState.tick = header.tick;
+    lastAppliedSequence = header.sequence;
+    if (!gameState.isGameStarted) {
+        lockstepMode = false;
+    }
+    receivedSnapshots.push_back(HotspotProtocol::makeBaseline(gameState, header.sequence));
+    while (receivedSnapshots.size() > SNAPSHOT_HISTORY_SIZE) {
+        receivedSnapshots.pop_front();
+    }
+    if (!spectating) {
+        networkManager->sendStateToHost(HotspotProtocol::encodeSnapshotAck(header.sequence));
+    }
+    
+    // 远端玩家进入抖动缓冲，由渲染按帧号插值显示
+    if (gameState.isGameStarted) {
+        interpolator.addSnapshot(gameState, localPlayerName, QDateTime::currentMSecsSinceEpoch());
+    } else {
+        interpolator.clear();
+    }
+    
+    // 基线保存的是主机的权威状态，之后再叠加本地预测
+    reconcilePrediction();
+    
+    emit gameStateUpdated(gameState);
 }
 
-void HotspotGameManager::onNetworkPlayerDisconnected(const QString& playerName)
+void HotspotGameManager::onNetworkSnapshotAck(const QString& playerName, quint32 sequence)
 {
-    // 只有房主才处理玩家断开连接事件
-    if (isHost()) {
-        removePlayer(playerName);
-        emit playerLeft(playerName);
-        broadcastGameState();
-        
-        // 检查是否需要结束游戏
-        if (gameState.isGameStarted && getPlayerCount() < 2) {
-            endGame("Not enough players");
+    if (!isHost()) {
+        return;
+    }
+    
+    ClientSyncState& sync = clientSyncStates[playerName];
+    sync.lastAckedSequence = qMax(sync.lastAckedSequence, sequence);
+    
+    // 客户端确认每个应用的快照，排在被确认序号之前仍未确认的视为丢失
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!sync.unacked.empty() && sync.unacked.front().first <= sequence) {
+        const bool acked = sync.unacked.front().first == sequence;
+        if (acked) {
+            const double sample = now - sync.unacked.front().second;
+            sync.rtt = (sync.rtt == 0.0) ? sample : sync.rtt + (sample - sync.rtt) / 8.0;
+            sync.minRtt = (sync.minRtt == 0.0) ? sample : qMin(sync.minRtt, sample);
         }
+        sync.loss += ((acked ? 0.0 : 1.0) - sync.loss) / 16.0;
+        sync.unacked.pop_front();
     }
 }
 
-void HotspotGameManager::initializeGame()
+void HotspotGameManager::onNetworkKeyframeRequest(const QString& playerName)
 {
-    // 初始化蛇的位置
-    int playerIndex = 0;
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it, ++playerIndex) {
-        std::deque<Point>& snake = it.value();
-        snake.clear();
-        
-        // 根据玩家索引设置初始位置
-        int startX = 5 + (playerIndex % 2) * (GRID_WIDTH - 10);
-        int startY = 5 + (playerIndex / 2) * (GRID_HEIGHT - 10);
-        
-        for (int i = 0; i < INITIAL_SNAKE_LENGTH; ++i) {
-            snake.push_back(Point(startX - i, startY));
-        }
-        
-        gameState.playerAliveStatus[it.key()] = true;
-        gameState.playerScores[it.key()] = 0;
+    if (!isHost()) {
+        return;
     }
     
-    // 生成食物
-    generateFood();
+    if (lockstepMode && gameState.isGameStarted) {
+        // 锁步模式下客户端模拟出现分歧，单独为它重新同步
+        sendLockstepSync(QStringList() << playerName);
+    } else {
+        clientSyncStates[playerName].needsKeyframe = true;
+    }
 }
 
-void HotspotGameManager::updateGameLogic()
+void HotspotGameManager::onNetworkPlayerInput(const QString& playerName, const QList<HotspotProtocol::PlayerInput>& inputs)
 {
-    if (!isHost()) {
-        return; // 只有主机更新游戏逻辑
+    if (!isHost() || !gameState.playerSnakes.contains(playerName)) {
+        return;
     }
     
-    updatePlayerPositions();
-    checkCollisions();
-    checkWinCondition();
+    // 每条消息都带着最近几次输入，只应用序号比已应用的更新的部分
+    // 已应用的序号随快照下发，客户端据此判断哪些预测输入已体现在快照中
+    quint32& lastSequence = gameState.playerInputSequences[playerName];
+    for (const HotspotProtocol::PlayerInput& input : inputs) {
+        if (input.sequence > lastSequence) {
+            lastSequence = input.sequence;
+            updatePlayerDirection(playerName, input.direction);
+        }
+    }
     
-    // 优化：移除每次都广播状态，改为智能同步
-    emit gameStateUpdated(gameState);
+    networkManager->sendStateToPlayer(playerName, HotspotProtocol::encodeInputAck(lastSequence));
 }
 
-void HotspotGameManager::checkCollisions()
+void HotspotGameManager::onNetworkInputAck(quint32 sequence)
 {
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it) {
-        const QString& playerName = it.key();
-        
-        if (!gameState.playerAliveStatus[playerName]) {
-            continue;
+    if (isHost()) {
+        return;
+    }
+    
+    if (sequence <= lastInputAck) {
+        return;
+    }
+    lastInputAck = sequence;
+    
+    // 确认只停止重发；输入要等到快照体现后才能从预测中移除
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (PendingInput& pending : pendingInputs) {
+        if (pending.input.sequence > sequence) {
+            break;
         }
-        
-        // 检查各种碰撞
-        if (checkSelfCollision(playerName) || 
-            checkWallCollision(playerName) || 
-            checkPlayerCollision(playerName)) {
-            killPlayer(playerName);
-            continue;
+        if (pending.sentTime > 0) {
+            inputRtt += (static_cast<double>(now - pending.sentTime) - inputRtt) / 8.0;
+            pending.sentTime = 0;
         }
-        
-        // 检查食物碰撞
-        if (checkFoodCollision(playerName)) {
-            int points = gameState.isSpecialFood ? SPECIAL_FOOD_POINTS : FOOD_POINTS;
-            gameState.playerScores[playerName] += points;
-            
-            growSnake(playerName);
-            generateFood();
-            
-            emit foodEaten(playerName, points);
-            emit playerScoreChanged(playerName, gameState.playerScores[playerName]);
+    }
+    // 锁步模式没有预测需要重放，主机收到的输入即可丢弃
+    if (lockstepMode) {
+        while (!pendingInputs.empty() && pendingInputs.front().input.sequence <= sequence) {
+            pendingInputs.pop_front();
         }
     }
+    
+    if (pendingInputs.empty() || pendingInputs.back().input.sequence <= lastInputAck) {
+        inputResendTimer->stop();
+    }
 }
 
-void HotspotGameManager::updatePlayerPositions()
+void HotspotGameManager::onNetworkLockstepStart(quint32 tick, quint64 randomState)
 {
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it) {
-        const QString& playerName = it.key();
-        
-        if (!gameState.playerAliveStatus[playerName]) {
-            continue;
-        }
-        
-        std::deque<Point>& snake = it.value();
-        if (snake.empty()) {
-            continue;
-        }
-        
-        Point newHead = getNextHeadPosition(playerName);
-        snake.push_front(newHead);
-        snake.pop_back();
+    if (isHost()) {
+        return;
+    }
+    
+    // 关键帧先于本消息经TCP到达，此时本地状态应与主机在同一帧
+    if (gameState.tick != tick) {
+        qWarning() << "Lockstep start for tick" << tick << "but local state is at" << gameState.tick;
+        requestLockstepResync();
+        return;
     }
+    
+    // 关键帧到达时还未进入锁步，本地蛇已被预测推进了几帧，从关键帧开始模拟前要退回去，
+    // 否则第一个输入包的校验和必然不一致
+    discardPrediction();
+    lockstepMode = true;
+    lockstepResyncPending = false;
+    simulation.setRandomState(randomState);
+    
+    qDebug() << "Lockstep mode active from tick" << tick;
 }
 
-void HotspotGameManager::generateFood()
+void HotspotGameManager::onNetworkInputBundle(const QByteArray& payload)
 {
-    Point newFood;
-    QSet<Point> occupiedPositions = getAllOccupiedPositions();
+    if (isHost() || !lockstepMode || lockstepResyncPending) {
+        return;
+    }
+    
+    quint32 tick = 0;
+    quint32 checksum = 0;
+    QList<HotspotProtocol::LockstepInput> inputs;
+    HotspotProtocol::Reader reader(payload);
+    if (!HotspotProtocol::decodeInputBundle(reader, tick, checksum, inputs)) {
+        qWarning() << "Malformed input bundle, requesting resync";
+        requestLockstepResync();
+        return;
+    }
     
-    do {
-        newFood = generateRandomFoodPosition();
-    } while (occupiedPositions.contains(newFood));
+    // 重新同步之前发出的输入包已包含在关键帧中
+    if (tick <= gameState.tick) {
+        return;
+    }
+    if (tick != gameState.tick + 1) {
+        qWarning() << "Missing input bundles before tick" << tick << ", requesting resync";
+        requestLockstepResync();
+        return;
+    }
     
-    gameState.foodPosition = newFood;
+    // 主机已经检查过反向移动，这里直接应用
+    for (const HotspotProtocol::LockstepInput& input : inputs) {
+        for (auto it = gameState.playerIds.constBegin(); it != gameState.playerIds.constEnd(); ++it) {
+            if (it.value() == input.playerId) {
+                gameState.playerDirections[it.key()] = input.direction;
+                break;
+            }
+        }
+    }
     
-    // 随机生成特殊食物
-    gameState.isSpecialFood = (QRandomGenerator::global()->bounded(10) == 0);
+    SnakeSimulation::StepEvents events;
+    simulation.step(gameState, events);
     
-    if (gameState.isSpecialFood) {
-        do {
-            gameState.specialFoodPosition = generateRandomFoodPosition();
-        } while (occupiedPositions.contains(gameState.specialFoodPosition) || 
-                 gameState.specialFoodPosition == gameState.foodPosition);
+    if (simulation.checksum(gameState) != checksum) {
+        qWarning() << "Lockstep simulation diverged at tick" << tick << ", requesting resync";
+        requestLockstepResync();
     }
+    
+    interpolator.addSnapshot(gameState, localPlayerName, QDateTime::currentMSecsSinceEpoch());
+    
+    handleStepEvents(events);
+    emit gameStateUpdated(gameState);
 }
 
-void HotspotGameManager::checkWinCondition()
+bool HotspotGameManager::getInterpolatedSnakes(QMap<QString, QVector<QPointF>>& snakes) const
 {
-    QStringList alivePlayers;
-    for (auto it = gameState.playerAliveStatus.begin(); it != gameState.playerAliveStatus.end(); ++it) {
-        if (it.value()) {
-            alivePlayers.append(it.key());
-        }
+    // 主机直接显示权威状态，不需要缓冲
+    if (isHost()) {
+        return false;
     }
-    
-    if (alivePlayers.size() <= 1) {
-        QString winner = alivePlayers.isEmpty() ? "Draw" : alivePlayers.first();
-        endGame(winner);
+    return interpolator.sample(QDateTime::currentMSecsSinceEpoch(), snakes);
+}
+
+void HotspotGameManager::requestLockstepResync()
+{
+    lockstepResyncPending = true;
+    if (networkManager) {
+        networkManager->sendToHost(HotspotProtocol::encodeKeyframeRequest());
     }
 }
 
-void HotspotGameManager::broadcastGameState()
+void HotspotGameManager::setLockstepMode(bool enabled)
 {
-    if (networkManager && isHost()) {
-        QJsonObject gameStateJson = gameStateToJson();
-        networkManager->sendGameState(gameStateJson);
+    if (gameState.isGameStarted || countdownTimer->isActive()) {
+        qWarning() << "Network mode cannot be changed during a game";
+        return;
     }
+    lockstepMode = enabled;
 }
 
-void HotspotGameManager::syncPlayerData(const QString& playerName)
+QList<HotspotProtocol::LockstepInput> HotspotGameManager::collectLockstepInputs()
 {
-    if (networkManager) {
-        QJsonObject playerData = playerDataToJson(playerName);
-        networkManager->sendPlayerData(playerName, playerData);
+    QList<HotspotProtocol::LockstepInput> inputs;
+    for (auto it = gameState.playerIds.constBegin(); it != gameState.playerIds.constEnd(); ++it) {
+        const Direction direction = gameState.playerDirections.value(it.key(), Direction::RIGHT);
+        auto last = lockstepDirections.find(it.value());
+        if (last == lockstepDirections.end() || last.value() != direction) {
+            HotspotProtocol::LockstepInput input;
+            input.playerId = it.value();
+            input.direction = direction;
+            inputs.append(input);
+            lockstepDirections[it.value()] = direction;
+        }
     }
+    return inputs;
 }
 
-bool HotspotGameManager::checkSelfCollision(const QString& playerName)
+void HotspotGameManager::sendLockstepSync(const QStringList& players)
 {
-    const std::deque<Point>& snake = gameState.playerSnakes[playerName];
-    if (snake.size() < 2) {
-        return false;
+    if (!networkManager || !isHost() || players.isEmpty()) {
+        return;
     }
     
-    const Point& head = snake.front();
-    for (auto it = snake.begin() + 1; it != snake.end(); ++it) {
-        if (*it == head) {
-            return true;
-        }
+    ++snapshotSequence;
+    snapshotHistory.push_back(HotspotProtocol::makeBaseline(gameState, snapshotSequence));
+    while (snapshotHistory.size() > SNAPSHOT_HISTORY_SIZE) {
+        snapshotHistory.pop_front();
     }
     
-    return false;
+    QByteArray keyframe;
+    HotspotProtocol::encodeGameState(gameState, snapshotSequence, nullptr, keyframe);
+    const QByteArray start = HotspotProtocol::encodeLockstepStart(gameState.tick, simulation.getRandomState());
+    
+    for (const QString& playerName : players) {
+        // 关键帧和锁步开始消息都走TCP，保证在后续输入包之前按顺序到达
+        networkManager->sendToPlayer(playerName, keyframe);
+        networkManager->sendToPlayer(playerName, start);
+        
+        ClientSyncState& sync = clientSyncStates[playerName];
+        sync.lastKeyframeSequence = snapshotSequence;
+        sync.needsKeyframe = false;
+    }
 }
 
-bool HotspotGameManager::checkWallCollision(const QString& playerName)
+void HotspotGameManager::onInputResendTick()
 {
-    const std::deque<Point>& snake = gameState.playerSnakes[playerName];
-    if (snake.empty()) {
-        return false;
+    sendPendingInputs();
+}
+
+void HotspotGameManager::sendPendingInputs()
+{
+    // 只发送主机还没收到的输入，超过一条消息能携带的数量时最早的输入放弃补发
+    QList<HotspotProtocol::PlayerInput> unacked;
+    for (const PendingInput& pending : pendingInputs) {
+        if (pending.input.sequence > lastInputAck) {
+            unacked.append(pending.input);
+        }
     }
     
-    const Point& head = snake.front();
-    return head.x < 0 || head.x >= GRID_WIDTH || head.y < 0 || head.y >= GRID_HEIGHT;
+    if (!networkManager || unacked.isEmpty()) {
+        inputResendTimer->stop();
+        return;
+    }
+    networkManager->sendStateToHost(HotspotProtocol::encodePlayerInput(unacked));
 }
 
-bool HotspotGameManager::checkPlayerCollision(const QString& playerName)
+void HotspotGameManager::reconcilePrediction()
 {
-    const std::deque<Point>& currentSnake = gameState.playerSnakes[playerName];
-    if (currentSnake.empty()) {
-        return false;
+    // 锁步模式下各端运行同一模拟，不需要预测
+    if (lockstepMode || localPlayerName.isEmpty() || !gameState.playerSnakes.contains(localPlayerName)) {
+        return;
     }
     
-    const Point& head = currentSnake.front();
+    snapshotDirection = gameState.playerDirections.value(localPlayerName, Direction::RIGHT);
     
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it) {
-        if (it.key() == playerName || !gameState.playerAliveStatus[it.key()]) {
-            continue;
-        }
-        
-        const std::deque<Point>& otherSnake = it.value();
-        for (const Point& segment : otherSnake) {
-            if (segment == head) {
-                return true;
+    // 快照已体现的输入不再重放
+    const quint32 appliedSequence = gameState.playerInputSequences.value(localPlayerName, 0);
+    while (!pendingInputs.empty() && pendingInputs.front().input.sequence <= appliedSequence) {
+        pendingInputs.pop_front();
+    }
+    
+    predictedTick = gameState.tick;
+    if (!gameState.isGameStarted || gameState.isPaused ||
+        !gameState.playerAliveStatus.value(localPlayerName, false)) {
+        predictionTimer->stop();
+        return;
+    }
+    
+    // 现在发出的输入大约一个往返后才被主机应用，预测需要领先快照同样多的帧
+    const int gameSpeed = qMax(1, gameState.gameSpeed);
+    const int lead = qBound(1, qRound(inputRtt / gameSpeed), MAX_PREDICTION_LEAD);
+    
+    Direction& direction = gameState.playerDirections[localPlayerName];
+    auto next = pendingInputs.begin();
+    for (int i = 0; i < lead; ++i) {
+        ++predictedTick;
+        for (; next != pendingInputs.end() && next->tick <= predictedTick; ++next) {
+            if (!SnakeSimulation::isOppositeDirection(direction, next->input.direction)) {
+                direction = next->input.direction;
             }
         }
+        stepPredictedSnake();
+    }
+    // 预测时间线比原来短时，剩余的输入在下一次步进时生效
+    for (; next != pendingInputs.end(); ++next) {
+        if (!SnakeSimulation::isOppositeDirection(direction, next->input.direction)) {
+            direction = next->input.direction;
+        }
     }
     
-    return false;
+    if (!predictionTimer->isActive() || predictionTimer->interval() != gameSpeed) {
+        predictionTimer->start(gameSpeed);
+    }
 }
 
-bool HotspotGameManager::checkFoodCollision(const QString& playerName)
+void HotspotGameManager::discardPrediction()
 {
-    const std::deque<Point>& snake = gameState.playerSnakes[playerName];
-    if (snake.empty()) {
-        return false;
+    predictionTimer->stop();
+    predictedTick = gameState.tick;
+    if (localPlayerName.isEmpty() || receivedSnapshots.empty() || !gameState.playerIds.contains(localPlayerName)) {
+        return;
     }
     
-    const Point& head = snake.front();
-    return head == gameState.foodPosition || 
-           (gameState.isSpecialFood && head == gameState.specialFoodPosition);
+    // 预测只改动本地玩家的蛇和方向，其余状态仍是快照内容
+    const HotspotProtocol::SnapshotBaseline& baseline = receivedSnapshots.back();
+    const auto snake = baseline.snakes.constFind(gameState.playerIds.value(localPlayerName));
+    if (snake != baseline.snakes.constEnd()) {
+        gameState.playerSnakes[localPlayerName] = snake.value();
+        gameState.playerDirections[localPlayerName] = snapshotDirection;
+    }
 }
 
-Point HotspotGameManager::getNextHeadPosition(const QString& playerName)
+bool HotspotGameManager::stepPredictedSnake()
 {
-    const std::deque<Point>& snake = gameState.playerSnakes[playerName];
+    std::deque<Point>& snake = gameState.playerSnakes[localPlayerName];
     if (snake.empty()) {
-        return Point(0, 0);
+        return false;
     }
     
-    Point head = snake.front();
-    Direction direction = gameState.playerDirections[playerName];
-    
-    switch (direction) {
-        case Direction::UP:
-            head.y--;
-            break;
-        case Direction::DOWN:
-            head.y++;
-            break;
-        case Direction::LEFT:
-            head.x--;
-            break;
-        case Direction::RIGHT:
-            head.x++;
-            break;
+    // 撞墙和死亡由主机判定，预测停在墙前等待快照
+    const Point head = SnakeSimulation::nextHeadPosition(snake.front(), gameState.playerDirections.value(localPlayerName));
+    if (!simulation.isInsideGrid(head)) {
+        return false;
     }
     
-    return head;
+    snake.push_front(head);
+    snake.pop_back();
+    if (SnakeSimulation::isFoodAt(gameState, head)) {
+        snake.push_back(snake.back());
+    }
+    return true;
 }
 
-void HotspotGameManager::growSnake(const QString& playerName)
+void HotspotGameManager::onPredictionTick()
 {
-    std::deque<Point>& snake = gameState.playerSnakes[playerName];
-    if (!snake.empty()) {
-        snake.push_back(snake.back());
+    if (isHost() || lockstepMode || localPlayerName.isEmpty() || !gameState.isGameStarted || gameState.isPaused ||
+        !gameState.playerAliveStatus.value(localPlayerName, false)) {
+        predictionTimer->stop();
+        return;
+    }
+    
+    // 快照长时间没到时不再继续外推，避免与主机偏离过远
+    if (predictedTick >= gameState.tick + MAX_PREDICTION_TICKS) {
+        return;
+    }
+    
+    ++predictedTick;
+    if (stepPredictedSnake()) {
+        emit gameStateUpdated(gameState);
     }
 }
 
-void HotspotGameManager::killPlayer(const QString& playerName)
+void HotspotGameManager::onNetworkPlayerDirection(int playerId, Direction direction)
 {
-    gameState.playerAliveStatus[playerName] = false;
-    emit playerDied(playerName);
+    if (isHost()) {
+        return;
+    }
     
-    qDebug() << "Player died:" << playerName;
+    // 锁步模式下方向只随输入包生效
+    if (lockstepMode) {
+        return;
+    }
+    
+    // 直接写入本地状态，不经过updatePlayerDirection，避免回传给主机
+    // 自己的方向由本地预测决定，主机的回显可能比本地输入旧
+    for (auto it = gameState.playerIds.begin(); it != gameState.playerIds.end(); ++it) {
+        if (it.value() == playerId && it.key() != localPlayerName) {
+            gameState.playerDirections[it.key()] = direction;
+            break;
+        }
+    }
 }
 
-QSet<Point> HotspotGameManager::getAllOccupiedPositions() const
+void HotspotGameManager::onNetworkPlayerConnected(const QString& playerName)
 {
-    QSet<Point> positions;
-    
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it) {
-        if (gameState.playerAliveStatus[it.key()]) {
-            for (const Point& segment : it.value()) {
-                positions.insert(segment);
-            }
+    if (isHost()) {
+        // 主机处理新玩家连接
+        if (!gameState.playerSnakes.contains(playerName)) {
+            gameState.playerSnakes[playerName] = std::deque<Point>();
+            gameState.playerCharacters[playerName] = CharacterType::PATRICK;
+            gameState.playerScores[playerName] = 0;
+            gameState.playerAliveStatus[playerName] = true;
+            gameState.playerDirections[playerName] = Direction::RIGHT;
+            gameState.playerReadyStatus[playerName] = false;
+            assignPlayerId(playerName);
+            
+            emit playerJoined(playerName);
+            broadcastGameState();
         }
     }
-    
-    return positions;
 }
 
-Point HotspotGameManager::generateRandomFoodPosition()
+void HotspotGameManager::onNetworkSpectatorJoined(const QString& spectatorName)
 {
-    int x = QRandomGenerator::global()->bounded(GRID_WIDTH);
-    int y = QRandomGenerator::global()->bounded(GRID_HEIGHT);
-    return Point(x, y);
+    // 新观战者立即拿到名单和当前画面，不必等下一个观战快照
+    if (isHost()) {
+        broadcastRoster();
+        sendSpectatorSnapshot();
+        qDebug() << "Spectator watching:" << spectatorName;
+    }
 }
 
-QJsonObject HotspotGameManager::gameStateToJson() const
+void HotspotGameManager::onNetworkPlayerDisconnected(const QString& playerName)
 {
-    QJsonObject json;
-    
-    // 玩家蛇身
-    QJsonObject snakes;
-    for (auto it = gameState.playerSnakes.begin(); it != gameState.playerSnakes.end(); ++it) {
-        QJsonArray snakeArray;
-        for (const Point& segment : it.value()) {
-            QJsonObject pointObj;
-            pointObj["x"] = segment.x;
-            pointObj["y"] = segment.y;
-            snakeArray.append(pointObj);
+    // 只有房主才处理玩家断开连接事件
+    if (isHost()) {
+        removePlayer(playerName);
+        clientSyncStates.remove(playerName);
+        emit playerLeft(playerName);
+        broadcastGameState();
+        
+        // 检查是否需要结束游戏
+        if (gameState.isGameStarted && getPlayerCount() < 2) {
+            endGame("Not enough players");
         }
-        snakes[it.key()] = snakeArray;
     }
-    json["snakes"] = snakes;
-    
-    // 玩家角色
-    QJsonObject characters;
-    for (auto it = gameState.playerCharacters.begin(); it != gameState.playerCharacters.end(); ++it) {
-        characters[it.key()] = static_cast<int>(it.value());
+}
+
+void HotspotGameManager::onNetworkPlayerConnectionLost(const QString& playerName)
+{
+    // 断线玩家留在房间里，蛇按最后的方向继续前进；宽限期结束才按离开处理
+    if (isHost()) {
+        clientSyncStates.remove(playerName);
+        qDebug() << "Player" << playerName << "lost connection, waiting for reconnect";
+    }
+}
+
+void HotspotGameManager::onNetworkPlayerReconnected(const QString& playerName)
+{
+    if (!isHost() || !networkManager || !gameState.playerSnakes.contains(playerName)) {
+        return;
     }
-    json["characters"] = characters;
     
-    // 玩家分数
-    QJsonObject scores;
-    for (auto it = gameState.playerScores.begin(); it != gameState.playerScores.end(); ++it) {
-        scores[it.key()] = it.value();
+    // 重新同步只需要名单和一个关键帧，和主机的确认消息在同一轮写出
+    clientSyncStates[playerName] = ClientSyncState();
+    HotspotProtocol::encodeRoster(gameState, hostPlayerName, rosterBuffer);
+    networkManager->sendToPlayer(playerName, rosterBuffer);
+    if (lockstepMode && gameState.isGameStarted) {
+        sendLockstepSync(QStringList() << playerName);
+    } else {
+        sendSnapshots(false);
+    }
+    qDebug() << "Player" << playerName << "reconnected at tick" << gameState.tick;
+}
+
+void HotspotGameManager::onNetworkSessionResumed()
+{
+    if (isHost() || spectating) {
+        return;
     }
-    json["scores"] = scores;
     
-    // 玩家存活状态
-    QJsonObject aliveStatus;
-    for (auto it = gameState.playerAliveStatus.begin(); it != gameState.playerAliveStatus.end(); ++it) {
-        aliveStatus[it.key()] = it.value();
+    // 锁步模式下等主机重新发来的锁步开始消息，再接受输入包
+    lockstepResyncPending = lockstepMode;
+    
+    // 断线期间发出的输入主机没有收到，立即补发
+    if (!pendingInputs.empty() && pendingInputs.back().input.sequence > lastInputAck) {
+        sendPendingInputs();
+        inputResendTimer->start(INPUT_RESEND_INTERVAL);
+    }
+}
+
+void HotspotGameManager::initializeGame()
+{
+    // 每局使用新的随机数种子；锁步模式下随锁步开始消息下发给客户端
+    simulation.setRandomState(QRandomGenerator::global()->generate64());
+    simulation.initialize(gameState);
+}
+
+void HotspotGameManager::updateGameLogic()
+{
+    if (!isHost()) {
+        return; // 只有主机更新游戏逻辑
     }
-    json["alive_status"] = aliveStatus;
     
-    // 玩家方向
-    QJsonObject directions;
-    for (auto it = gameState.playerDirections.begin(); it != gameState.playerDirections.end(); ++it) {
-        directions[it.key()] = static_cast<int>(it.value());
+    // 锁步模式：先取出本帧生效的方向变化，和模拟后的校验和一起下发
+    QList<HotspotProtocol::LockstepInput> lockstepInputs;
+    if (lockstepMode) {
+        lockstepInputs = collectLockstepInputs();
     }
-    json["directions"] = directions;
     
-    // 玩家准备状态
-    QJsonObject readyStatus;
-    for (auto it = gameState.playerReadyStatus.begin(); it != gameState.playerReadyStatus.end(); ++it) {
-        readyStatus[it.key()] = it.value();
+    SnakeSimulation::StepEvents events;
+    simulation.step(gameState, events);
+    emit tickSimulated(gameState.tick);
+    
+    if (lockstepMode && networkManager) {
+        HotspotProtocol::encodeInputBundle(gameState.tick, simulation.checksum(gameState), lockstepInputs, bundleBuffer);
+        networkManager->broadcastToClients(bundleBuffer);
+    } else {
+        sendSnapshots(false);
+    }
+    if (gameState.tick % SPECTATOR_SNAPSHOT_INTERVAL == 0) {
+        sendSpectatorSnapshot();
     }
-    json["ready_status"] = readyStatus;
     
-    // 食物位置
-    QJsonObject food;
-    food["x"] = gameState.foodPosition.x;
-    food["y"] = gameState.foodPosition.y;
-    json["food"] = food;
+    handleStepEvents(events);
+    checkWinCondition();
     
-    // 特殊食物
-    json["is_special_food"] = gameState.isSpecialFood;
-    if (gameState.isSpecialFood) {
-        QJsonObject specialFood;
-        specialFood["x"] = gameState.specialFoodPosition.x;
-        specialFood["y"] = gameState.specialFoodPosition.y;
-        json["special_food"] = specialFood;
+    // 优化：移除每次都广播状态，改为智能同步
+    emit gameStateUpdated(gameState);
+}
+
+void HotspotGameManager::handleStepEvents(const SnakeSimulation::StepEvents& events)
+{
+    for (const QString& playerName : events.deaths) {
+        emit playerDied(playerName);
+        qDebug() << "Player died:" << playerName;
     }
     
-    // 游戏状态
-    json["game_speed"] = gameState.gameSpeed;
-    json["is_paused"] = gameState.isPaused;
-    json["is_game_started"] = gameState.isGameStarted;
-    json["game_winner"] = gameState.gameWinner;
-    json["countdown_timer"] = gameState.countdownTimer;
+    for (const auto& eaten : events.foodEaten) {
+        emit foodEaten(eaten.first, eaten.second);
+        emit playerScoreChanged(eaten.first, gameState.playerScores.value(eaten.first));
+    }
+}
+
+void HotspotGameManager::checkWinCondition()
+{
+    QStringList alivePlayers;
+    for (auto it = gameState.playerAliveStatus.begin(); it != gameState.playerAliveStatus.end(); ++it) {
+        if (it.value()) {
+            alivePlayers.append(it.key());
+        }
+    }
     
-    return json;
+    if (alivePlayers.size() <= 1) {
+        QString winner = alivePlayers.isEmpty() ? "Draw" : alivePlayers.first();
+        endGame(winner);
+    }
 }
 
-void HotspotGameManager::gameStateFromJson(const QJsonObject& json)
+void HotspotGameManager::broadcastGameState()
 {
-    // 解析玩家蛇身
-    QJsonObject snakes = json["snakes"].toObject();
-    gameState.playerSnakes.clear();
-    for (auto it = snakes.begin(); it != snakes.end(); ++it) {
-        std::deque<Point> snake;
-        QJsonArray snakeArray = it.value().toArray();
-        for (const QJsonValue& value : snakeArray) {
-            QJsonObject pointObj = value.toObject();
-            snake.push_back(Point(pointObj["x"].toInt(), pointObj["y"].toInt()));
+    if (networkManager && isHost()) {
+        // 名单在前，客户端解码快照时已经知道所有玩家ID
+        broadcastRoster();
+        
+        if (lockstepMode && gameState.isGameStarted) {
+            // 锁步模式下完整状态只在开局、暂停、有人加入等时刻可靠下发，之后每帧只发输入包
+            sendLockstepSync(networkManager->getConnectedPlayerNames());
+            lockstepDirections.clear();
+            for (auto it = gameState.playerIds.constBegin(); it != gameState.playerIds.constEnd(); ++it) {
+                lockstepDirections[it.value()] = gameState.playerDirections.value(it.key(), Direction::RIGHT);
+            }
+        } else {
+            sendSnapshots(true);
         }
-        gameState.playerSnakes[it.key()] = snake;
+        sendSpectatorSnapshot();
+    }
+}
+
+void HotspotGameManager::sendSpectatorSnapshot()
+{
+    if (!networkManager || !isHost() || networkManager->getSpectatorCount() == 0) {
+        return;
     }
     
-    // 解析玩家角色
-    QJsonObject characters = json["characters"].toObject();
-    gameState.playerCharacters.clear();
-    for (auto it = characters.begin(); it != characters.end(); ++it) {
-        gameState.playerCharacters[it.key()] = static_cast<CharacterType>(it.value().toInt());
+    HotspotProtocol::encodeGameState(gameState, ++spectatorSequence, nullptr, spectatorBuffer);
+    networkManager->broadcastToSpectators(spectatorBuffer);
+}
+
+void HotspotGameManager::sendSnapshots(bool force)
+{
+    if (!networkManager || !isHost()) {
+        return;
     }
     
-    // 解析玩家分数
-    QJsonObject scores = json["scores"].toObject();
-    gameState.playerScores.clear();
-    for (auto it = scores.begin(); it != scores.end(); ++it) {
-        gameState.playerScores[it.key()] = it.value().toInt();
+    // 每个客户端按自己的频率接收快照，本帧没有客户端需要时不生成新快照
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList clients;
+    for (const QString& playerName : networkManager->getConnectedPlayerNames()) {
+        ClientSyncState& sync = clientSyncStates[playerName];
+        updateClientRate(playerName, sync, now);
+        if (force || sync.needsKeyframe || sync.lastSentTick == 0 ||
+            gameState.tick - sync.lastSentTick >= static_cast<quint32>(sync.snapshotInterval)) {
+            clients.append(playerName);
+        }
+    }
+    if (clients.isEmpty()) {
+        return;
     }
     
-    // 解析玩家存活状态
-    QJsonObject aliveStatus = json["alive_status"].toObject();
-    gameState.playerAliveStatus.clear();
-    for (auto it = aliveStatus.begin(); it != aliveStatus.end(); ++it) {
-        gameState.playerAliveStatus[it.key()] = it.value().toBool();
+    ++snapshotSequence;
+    snapshotHistory.push_back(HotspotProtocol::makeBaseline(gameState, snapshotSequence));
+    while (snapshotHistory.size() > SNAPSHOT_HISTORY_SIZE) {
+        snapshotHistory.pop_front();
     }
     
-    // 解析玩家方向
-    QJsonObject directions = json["directions"].toObject();
-    gameState.playerDirections.clear();
-    for (auto it = directions.begin(); it != directions.end(); ++it) {
-        gameState.playerDirections[it.key()] = static_cast<Direction>(it.value().toInt());
+    // 确认了同一基线的客户端共用一次编码
+    QMap<quint32, QByteArray> encodedByBase;
+    for (const QString& playerName : clients) {
+        ClientSyncState& sync = clientSyncStates[playerName];
+        
+        // 需要关键帧、到了关键帧间隔、或确认的快照已不在历史中时发送关键帧
+        // 低频率的客户端带宽紧张，不再定期补发体积最大的关键帧；没有协商增量快照的客户端每次都收关键帧
+        const HotspotProtocol::SnapshotBaseline* baseline = nullptr;
+        const bool periodicKeyframe = sync.snapshotInterval < COARSE_SNAPSHOT_INTERVAL &&
+                                      snapshotSequence - sync.lastKeyframeSequence >= KEYFRAME_INTERVAL;
+        const bool keyframeDue = sync.needsKeyframe || periodicKeyframe;
+        const bool deltas = networkManager->getPeerProtocol(playerName).features & HotspotProtocol::FeatureDeltaSnapshots;
+        if (!keyframeDue && deltas) {
+            baseline = findBaseline(snapshotHistory, sync.lastAckedSequence);
+        }
+        
+        const quint32 baseSequence = baseline ? baseline->sequence : 0;
+        auto encoded = encodedByBase.find(baseSequence);
+        if (encoded == encodedByBase.end()) {
+            encoded = encodedByBase.insert(baseSequence, QByteArray());
+            HotspotProtocol::encodeGameState(gameState, snapshotSequence, baseline, encoded.value());
+        }
+        networkManager->sendStateToPlayer(playerName, encoded.value());
+        
+        if (!baseline) {
+            sync.lastKeyframeSequence = snapshotSequence;
+            sync.needsKeyframe = false;
+        }
+        sync.lastSentTick = gameState.tick;
+        sync.unacked.push_back(qMakePair(snapshotSequence, now));
+        while (sync.unacked.size() > SNAPSHOT_HISTORY_SIZE) {
+            sync.unacked.pop_front();
+        }
+    }
+}
+
+void HotspotGameManager::updateClientRate(const QString& playerName, ClientSyncState& sync, qint64 now)
+{
+    if (now - sync.lastRateUpdate < RATE_ADJUST_INTERVAL) {
+        return;
     }
+    sync.lastRateUpdate = now;
     
-    // 解析玩家准备状态
-    QJsonObject readyStatus = json["ready_status"].toObject();
-    gameState.playerReadyStatus.clear();
-    for (auto it = readyStatus.begin(); it != readyStatus.end(); ++it) {
-        gameState.playerReadyStatus[it.key()] = it.value().toBool();
+    // 长时间没有确认的快照计为丢失，客户端完全收不到时也能降频
+    while (!sync.unacked.empty() && now - sync.unacked.front().second > SNAPSHOT_ACK_TIMEOUT) {
+        sync.loss += (1.0 - sync.loss) / 16.0;
+        sync.unacked.pop_front();
     }
     
-    // 解析食物位置
-    QJsonObject food = json["food"].toObject();
-    gameState.foodPosition = Point(food["x"].toInt(), food["y"].toInt());
+    sync.backlog = networkManager->getPendingBytes(playerName);
+    const bool queueing = sync.minRtt > 0.0 && sync.rtt > sync.minRtt * 2 + RTT_QUEUE_MARGIN;
+    const bool congested = sync.backlog > MAX_CLIENT_BACKLOG || sync.loss > 0.05 || queueing;
     
-    // 解析特殊食物
-    gameState.isSpecialFood = json["is_special_food"].toBool();
-    if (gameState.isSpecialFood && json.contains("special_food")) {
-        QJsonObject specialFood = json["special_food"].toObject();
-        gameState.specialFoodPosition = Point(specialFood["x"].toInt(), specialFood["y"].toInt());
+    // 拥塞时成倍降频，恢复后逐帧提高，避免在临界点来回振荡
+    const int previousInterval = sync.snapshotInterval;
+    if (congested) {
+        sync.snapshotInterval = qMin(sync.snapshotInterval * 2, static_cast<int>(MAX_SNAPSHOT_INTERVAL));
+    } else if (sync.snapshotInterval > 1) {
+        --sync.snapshotInterval;
     }
     
-    // 解析游戏状态
-    gameState.gameSpeed = json["game_speed"].toInt();
-    gameState.isGameStarted = json["is_game_started"].toBool();
-    gameState.isPaused = json["is_paused"].toBool();
-    gameState.gameWinner = json["game_winner"].toString();
-    gameState.countdownTimer = json["countdown_timer"].toInt();
+    if (sync.snapshotInterval != previousInterval) {
+        qDebug() << "Snapshot interval for" << playerName << "now" << sync.snapshotInterval
+                 << "ticks (rtt" << sync.rtt << "ms, loss" << sync.loss << ", backlog" << sync.backlog << ")";
+    }
 }
 
-QJsonObject HotspotGameManager::playerDataToJson(const QString& playerName) const
+QMap<QString, HotspotGameManager::ClientLinkInfo> HotspotGameManager::getClientLinkInfo() const
 {
-    QJsonObject json;
-    
-    if (gameState.playerCharacters.contains(playerName)) {
-        json["character"] = static_cast<int>(gameState.playerCharacters[playerName]);
+    QMap<QString, ClientLinkInfo> result;
+    if (!isHost()) {
+        return result;
     }
     
-    if (gameState.playerDirections.contains(playerName)) {
-        json["direction"] = static_cast<int>(gameState.playerDirections[playerName]);
+    for (auto it = clientSyncStates.constBegin(); it != clientSyncStates.constEnd(); ++it) {
+        ClientLinkInfo info;
+        info.snapshotInterval = it.value().snapshotInterval;
+        info.rtt = qRound(it.value().rtt);
+        info.lossPercent = qRound(it.value().loss * 100);
+        info.backlog = networkManager ? networkManager->getPendingBytes(it.key()) : it.value().backlog;
+        result.insert(it.key(), info);
     }
-    
-    if (gameState.playerReadyStatus.contains(playerName)) {
-        json["ready"] = gameState.playerReadyStatus[playerName];
+    return result;
+}
+
+void HotspotGameManager::broadcastRoster()
+{
+    if (networkManager && isHost()) {
+        HotspotProtocol::encodeRoster(gameState, hostPlayerName, rosterBuffer);
+        networkManager->broadcastToClients(rosterBuffer);
+        networkManager->broadcastToSpectators(rosterBuffer);
+        rosterDirty = false;
     }
-    
-    return json;
 }
 
-void HotspotGameManager::playerDataFromJson(const QString& playerName, const QJsonObject& json)
+void HotspotGameManager::syncPlayerData(const QString& playerName)
 {
-    if (json.contains("character")) {
-        gameState.playerCharacters[playerName] = static_cast<CharacterType>(json["character"].toInt());
+    if (!networkManager) {
+        return;
+    }
+    
+    if (isHost()) {
+        // 主机的角色和准备状态随名单下发
+        broadcastRoster();
+        return;
     }
     
-    if (json.contains("direction")) {
-        gameState.playerDirections[playerName] = static_cast<Direction>(json["direction"].toInt());
+    HotspotProtocol::PlayerUpdate update;
+    update.fields = HotspotProtocol::UpdateCharacter | HotspotProtocol::UpdateDirection | HotspotProtocol::UpdateReady;
+    update.character = gameState.playerCharacters.value(playerName, CharacterType::SPONGEBOB);
+    update.direction = gameState.playerDirections.value(playerName, Direction::RIGHT);
+    update.ready = gameState.playerReadyStatus.value(playerName, false);
+    networkManager->sendPlayerUpdate(playerName, update);
+}
+
+int HotspotGameManager::assignPlayerId(const QString& playerName)
+{
+    if (gameState.playerIds.contains(playerName)) {
+        return gameState.playerIds.value(playerName);
     }
     
-    if (json.contains("ready")) {
-        gameState.playerReadyStatus[playerName] = json["ready"].toBool();
+    // 使用最小的空闲ID，保持varint编码只占一个字节
+    const QList<int> usedIds = gameState.playerIds.values();
+    int playerId = 0;
+    while (usedIds.contains(playerId)) {
+        ++playerId;
     }
+    gameState.playerIds[playerName] = playerId;
+    return playerId;
 }
 
 // 新增：智能同步方法实现
@@ -941,6 +1369,10 @@ void HotspotGameManager::setupSyncTimer()
 
 void HotspotGameManager::onSyncTick()
 {
+    if (isHost() && rosterDirty) {
+        broadcastRoster();
+    }
+    
     if (isHost() && hasStateChanged) {
         smartBroadcastGameState();
     }
@@ -952,6 +1384,12 @@ void HotspotGameManager::smartBroadcastGameState()
         return;
     }
     
+    // 对局中快照由updateGameLogic按各客户端的频率逐帧发送，锁步模式下客户端自己模拟
+    if (gameState.isGameStarted) {
+        hasStateChanged = false;
+        return;
+    }
+    
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
     
     // 检查是否需要同步（避免过于频繁的同步）
@@ -961,8 +1399,7 @@ void HotspotGameManager::smartBroadcastGameState()
     
     // 只有状态真正变化时才同步
     if (hasGameStateChanged()) {
-        QJsonObject gameStateJson = gameStateToJson();
-        networkManager->sendGameState(gameStateJson);
+        sendSnapshots(true);
         
         updateLastSyncedState();
         lastGameStateSyncTime = currentTime;
@@ -3,11 +3,12 @@
 
 #include <QObject>
 #include <QTimer>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QByteArray>
 #include <deque>
 #include "gamestate.h"
 #include "hotspotnetworkmanager.h"
+#include "snakesimulation.h"
+#include "snapshotinterpolator.h"
 
 /**
  * 热点游戏状态结构体
@@ -20,6 +21,9 @@ struct HotspotGameState {
     QMap<QString, bool> playerAliveStatus;
     QMap<QString, Direction> playerDirections;
     QMap<QString, bool> playerReadyStatus;
+    QMap<QString, int> playerIds;  // 房主分配的协议玩家ID，快照中用它代替名字
+    QMap<QString, quint32> playerInputSequences;  // 主机已应用的各玩家最大输入序号，客户端据此核对预测
+    quint32 tick;                  // 游戏逻辑帧号，随快照下发
     Point foodPosition;
     Point specialFoodPosition;
     bool isSpecialFood;
@@ -30,7 +34,8 @@ struct HotspotGameState {
     int countdownTimer;
     
     HotspotGameState() 
-        : isSpecialFood(false)
+        : tick(0)
+        , isSpecialFood(false)
         , gameSpeed(100)  // 优化：提高游戏更新频率，从200ms降低到100ms
         , isPaused(false)
         , isGameStarted(false)
@@ -55,8 +60,8 @@ public:
     ~HotspotGameManager();
     
     // 游戏房间管理
-    bool createRoom(const QString& hostPlayerName, const QString& roomName);
-    bool joinRoom(const QString& playerName);
+    bool createRoom(const QString& hostPlayerName, const QString& roomName, int maxPlayers = 4);  // 房主名为空时主机不参与游戏（专用服务器）
+    bool joinRoom(const QString& playerName, bool spectator = false);  // 观战者不占玩家名额，只接收低频快照
     void leaveRoom(const QString& playerName);
     void destroyRoom();
     
@@ -76,19 +81,55 @@ public:
     // 游戏状态
     HotspotGameState getGameState() const { return gameState; }
     bool isHost() const;
+    bool isSpectating() const { return spectating; }
     bool isGameActive() const { return gameState.isGameStarted && !gameState.isPaused; }
     int getPlayerCount() const { return gameState.playerSnakes.size(); }
     QStringList getPlayerNames() const { return gameState.playerSnakes.keys(); }
     QString getHostPlayerName() const { return hostPlayerName; }
+    QString getLocalPlayerName() const { return localPlayerName; }  // 客户端：本机玩家，观战时为空
+    CharacterType getPlayerCharacter(const QString& playerName) const { return gameState.playerCharacters.value(playerName, CharacterType::PATRICK); }
+    
+    // 客户端：按显示时刻插值后的远端玩家蛇身（不含本地玩家），供渲染每帧调用
+    bool getInterpolatedSnakes(QMap<QString, QVector<QPointF>>& snakes) const;
+    int getInterpolationDelay() const { return interpolator.getBufferDelay(); }
+    
+    // 主机：各客户端当前的快照频率和链路状况，供大厅显示
+    struct ClientLinkInfo {
+        int snapshotInterval = 1;  // 每隔几个逻辑帧一个快照
+        int rtt = 0;               // ms
+        int lossPercent = 0;
+        qint64 backlog = 0;        // 字节
+    };
+    QMap<QString, ClientLinkInfo> getClientLinkInfo() const;
+    
+    // 主机：逻辑帧耗时（模拟加快照编码和入队），专用服务器按房间上报
+    struct TickTiming {
+        double averageUs = 0.0;  // 平滑后的单帧耗时(微秒)
+        qint64 peakUs = 0;       // 上次resetTickPeak之后的最大单帧耗时
+        quint64 ticks = 0;
+    };
+    TickTiming getTickTiming() const { return tickTiming; }
+    void resetTickPeak() { tickTiming.peakUs = 0; }
     
     // 网络管理
     void setNetworkManager(HotspotNetworkManager* manager);
     HotspotNetworkManager* getNetworkManager() const { return networkManager; }
     
+    // 锁步模式：主机只下发每帧的方向变化和随机数状态，各端运行同一确定性模拟
+    // 带宽与蛇长和地图大小无关，适合大地图和信号弱的热点；须在开始游戏前设置
+    void setLockstepMode(bool enabled);
+    bool isLockstepMode() const { return lockstepMode; }
+    
     // 游戏配置
     void setGameSpeed(int speed) { gameState.gameSpeed = speed; }
     int getGameSpeed() const { return gameState.gameSpeed; }
     
+    // 地图大小不随协议下发，主机和所有客户端须设置相同的值；默认 GRID_WIDTH x GRID_HEIGHT
+    void setGridSize(int width, int height) { simulation.setGridSize(width, height); }
+    int getGridWidth() const { return simulation.getGridWidth(); }
+    int getGridHeight() const { return simulation.getGridHeight(); }
+    int getMaxSpawnPlayers() const { return simulation.spawnCapacity(); }
+    
 signals:
     // 房间事件
     void roomCreated(const QString& roomName);
@@ -111,6 +152,7 @@ signals:
     
     // 游戏状态事件
     void gameStateUpdated(const HotspotGameState& state);
+    void tickSimulated(quint32 tick);  // 主机：一个逻辑帧模拟完成、尚未向客户端下发时发出，供延迟测量取时间戳
     void foodEaten(const QString& playerName, int points);
     void countdownUpdated(int seconds);
     
@@ -118,20 +160,45 @@ private slots:
     void onGameTick();
     void onCountdownTick();
     void onSyncTick();  // 新增：智能同步定时器槽函数
-    void onNetworkPlayerData(const QString& playerName, const QJsonObject& playerData);
-    void onNetworkGameState(const QJsonObject& gameState);
+    void onInputResendTick();
+    void onPredictionTick();
+    void onNetworkPlayerUpdate(const QString& playerName, const HotspotProtocol::PlayerUpdate& update);
+    void onNetworkRoster(const QByteArray& payload);
+    void onNetworkGameState(const QByteArray& payload);
+    void onNetworkPlayerDirection(int playerId, Direction direction);
+    void onNetworkSnapshotAck(const QString& playerName, quint32 sequence);
+    void onNetworkKeyframeRequest(const QString& playerName);
+    void onNetworkPlayerInput(const QString& playerName, const QList<HotspotProtocol::PlayerInput>& inputs);
+    void onNetworkInputAck(quint32 sequence);
+    void onNetworkLockstepStart(quint32 tick, quint64 randomState);
+    void onNetworkInputBundle(const QByteArray& payload);
     void onNetworkPlayerConnected(const QString& playerName);
     void onNetworkPlayerDisconnected(const QString& playerName);
+    void onNetworkPlayerConnectionLost(const QString& playerName);
+    void onNetworkPlayerReconnected(const QString& playerName);
+    void onNetworkSessionResumed();
+    void onNetworkSpectatorJoined(const QString& spectatorName);
     
 private:
     void initializeGame();
     void updateGameLogic();
-    void checkCollisions();
-    void updatePlayerPositions();
-    void generateFood();
+    void handleStepEvents(const SnakeSimulation::StepEvents& events);
     void checkWinCondition();
     void broadcastGameState();
+    void broadcastRoster();
+    void sendSnapshots(bool force);     // 按各客户端确认的基线发送关键帧或增量快照；force为false时按各自频率跳过
+    void sendSpectatorSnapshot();       // 编码一次关键帧发给所有观战者
     void syncPlayerData(const QString& playerName);
+    void sendPendingInputs();
+    void reconcilePrediction();         // 客户端：以快照为准重放尚未被主机应用的输入
+    void discardPrediction();           // 客户端：丢弃预测，回到最近一次快照的权威状态
+    bool stepPredictedSnake();
+    int assignPlayerId(const QString& playerName);
+    
+    // 锁步模式
+    QList<HotspotProtocol::LockstepInput> collectLockstepInputs();  // 主机：本帧相对上一帧变化的方向
+    void sendLockstepSync(const QStringList& players);               // 主机：关键帧 + 锁步开始消息，用于开局和重新同步
+    void requestLockstepResync();
     
     // 新增：优化的同步方法
     void smartBroadcastGameState();     // 智能游戏状态广播
@@ -139,31 +206,15 @@ private:
     void updateLastSyncedState();       // 更新上次同步状态
     void setupSyncTimer();              // 设置同步定时器
     
-    // 碰撞检测
-    bool checkSelfCollision(const QString& playerName);
-    bool checkWallCollision(const QString& playerName);
-    bool checkPlayerCollision(const QString& playerName);
-    bool checkFoodCollision(const QString& playerName);
-    
-    // 游戏逻辑辅助
-    Point getNextHeadPosition(const QString& playerName);
-    void growSnake(const QString& playerName);
-    void killPlayer(const QString& playerName);
-    QSet<Point> getAllOccupiedPositions() const;
-    Point generateRandomFoodPosition();
-    
-    // 数据序列化
-    QJsonObject gameStateToJson() const;
-    void gameStateFromJson(const QJsonObject& json);
-    QJsonObject playerDataToJson(const QString& playerName) const;
-    void playerDataFromJson(const QString& playerName, const QJsonObject& json);
-    
     // 成员变量
     HotspotGameState gameState;
+    SnakeSimulation simulation;  // 主机模拟、客户端预测和锁步模拟共用的规则
     HotspotNetworkManager* networkManager;
     QTimer* gameTimer;
     QTimer* countdownTimer;
     QTimer* syncTimer;  // 新增：数据同步定时器
+    QTimer* inputResendTimer;  // 客户端：输入未被确认前定期重发
+    QTimer* predictionTimer;   // 客户端：按游戏速度推进自己蛇的本地预测
     QString hostPlayerName;
     QString roomName;
     
@@ -171,14 +222,67 @@ private:
     HotspotGameState lastSyncedState;  // 上次同步的游戏状态
     qint64 lastGameStateSyncTime;      // 上次游戏状态同步时间
     bool hasStateChanged;              // 状态是否发生变化
+    bool rosterDirty;                  // 玩家名单（角色、准备状态）需要重新广播
+    QByteArray rosterBuffer;
+    
+    // 增量快照：每个客户端相对自己最后确认的快照接收增量
+    struct ClientSyncState {
+        quint32 lastAckedSequence = 0;
+        quint32 lastKeyframeSequence = 0;
+        bool needsKeyframe = true;
+        
+        // 自适应发送频率：按快照确认测得的往返时间、丢失率和TCP积压调整
+        int snapshotInterval = 1;                       // 每隔几个逻辑帧发送一次快照
+        quint32 lastSentTick = 0;
+        std::deque<QPair<quint32, qint64>> unacked;     // 已发出未确认的快照序号和发送时间
+        double rtt = 0.0;                               // 平滑后的往返时间(ms)，0表示尚无样本
+        double minRtt = 0.0;                            // 观测到的最小往返时间，作为无排队时的基准
+        double loss = 0.0;                              // 平滑后的快照丢失率(0~1)
+        qint64 backlog = 0;                             // 上次评估时TCP尚未写出的字节数
+        qint64 lastRateUpdate = 0;
+    };
+    quint32 snapshotSequence;
+    std::deque<HotspotProtocol::SnapshotBaseline> snapshotHistory;    // 主机：最近发出的快照
+    QMap<QString, ClientSyncState> clientSyncStates;                  // 主机：按玩家名
+    void updateClientRate(const QString& playerName, ClientSyncState& sync, qint64 now);
+    std::deque<HotspotProtocol::SnapshotBaseline> receivedSnapshots;  // 客户端：最近应用的快照
+    quint32 lastAppliedSequence;                                      // 客户端：丢弃序号不更新的快照
+    
+    // 客户端预测：自己的蛇在本地立即响应输入，快照到达后以快照为准重放主机尚未应用的输入
+    struct PendingInput {
+        HotspotProtocol::PlayerInput input;
+        quint32 tick = 0;       // 预测中该输入生效的帧号
+        qint64 sentTime = 0;    // 首次发送时间，收到确认后清零，用于估算输入往返时间
+    };
+    std::deque<PendingInput> pendingInputs;  // 主机尚未应用到快照中的输入
+    QString localPlayerName;
+    quint32 inputSequence;                   // 最近一次输入的序号
+    quint32 lastInputAck;                    // 主机已收到的最大输入序号，之后的输入需要重发
+    quint32 predictedTick;                   // 本地预测推进到的帧号
+    Direction snapshotDirection;             // 最近一次快照中本地玩家的方向，预测会改写 gameState 中的值
+    double inputRtt;                         // 平滑后的输入往返时间(ms)，决定预测领先主机的帧数
+    
+    // 锁步模式
+    bool lockstepMode;                       // 主机：房间设置；客户端：收到锁步开始消息后进入
+    bool lockstepResyncPending;              // 客户端：已请求重新同步，在此之前忽略输入包
+    QMap<int, Direction> lockstepDirections; // 主机：上一个输入包之后各玩家的方向
+    QByteArray bundleBuffer;
+    
+    // 远端玩家显示
+    SnapshotInterpolator interpolator;       // 客户端：远端玩家快照的抖动缓冲
+    
+    TickTiming tickTiming;
+    
+    // 观战：主机每 SPECTATOR_SNAPSHOT_INTERVAL 帧编码一次关键帧，所有观战者共用；
+    // 不建立基线、不等待确认，观战者数量不影响模拟和玩家快照
+    bool spectating;                         // 客户端：以观战者身份加入
+    quint32 spectatorSequence;               // 主机：观战快照单独编号，不影响玩家的基线和关键帧间隔
+    QByteArray spectatorBuffer;
     
     // 游戏配置
     static const int GRID_WIDTH = 40;
     static const int GRID_HEIGHT = 30;
-    static const int INITIAL_SNAKE_LENGTH = 3;
     static const int COUNTDOWN_SECONDS = 3;
-    static const int FOOD_POINTS = 10;
-    static const int SPECIAL_FOOD_POINTS = 50;
     
     // 网络配置 - 优化网络参数以减少延迟
     static const quint16 DEFAULT_PORT = 23456;
@@ -190,6 +294,19 @@ private:
     // 新增：数据同步优化参数
     static const int GAME_STATE_SYNC_INTERVAL = 300;  // 游戏状态同步间隔(ms) - 降低同步频率减少卡顿
     static const int PLAYER_INPUT_SYNC_INTERVAL = 100; // 玩家输入同步间隔(ms) - 降低输入同步频率
+    static const int SNAPSHOT_HISTORY_SIZE = 32;       // 保留的快照基线数量，确认落后更多时改发关键帧
+    static const int KEYFRAME_INTERVAL = 20;           // 每个客户端至少每20个快照收到一次关键帧
+    static const int INPUT_RESEND_INTERVAL = 50;       // 输入重发间隔(ms)，状态通道丢包时补发
+    static const int MAX_PENDING_INPUTS = 32;          // 等待快照确认的输入上限
+    static const int MAX_PREDICTION_LEAD = 6;          // 快照到达后预测最多领先的帧数
+    static const int MAX_PREDICTION_TICKS = 12;        // 快照中断时最多向前预测的帧数，之后等待主机
+    static const int RATE_ADJUST_INTERVAL = 1000;      // 每个客户端的快照频率每秒评估一次
+    static const int MAX_SNAPSHOT_INTERVAL = 8;        // 拥塞时最低每8帧发送一次快照
+    static const int COARSE_SNAPSHOT_INTERVAL = 4;     // 频率降到每4帧以下时不再定期补发关键帧
+    static const int SNAPSHOT_ACK_TIMEOUT = 1000;      // 超过该时间仍未确认的快照计为丢失(ms)
+    static const int RTT_QUEUE_MARGIN = 50;            // 往返时间超过基准两倍再加该余量视为排队(ms)
+    static const int MAX_CLIENT_BACKLOG = 8 * 1024;    // TCP积压超过8KB视为带宽不足
+    static const int SPECTATOR_SNAPSHOT_INTERVAL = 5;  // 观战者每5帧收到一次关键帧
 };
 
 #endif // HOTSPOTGAMEMANAGER_H
\ No newline at end of file
@@ -68,18 +68,16 @@ HotspotLobby::HotspotLobby(QWidget *parent)
     , currentWidget(nullptr)
     , isHost(false)
     , isInRoom(false)
-    , refreshTimer(new QTimer(this))
+    , roomDirectory(new RoomDirectory(this))
     , networkStatusTimer(new QTimer(this))
     , statusMessageTimer(new QTimer(this))
 {
     setupUI();
     
     // 设置定时器
-    refreshTimer->setSingleShot(false);
     networkStatusTimer->setSingleShot(false);
     statusMessageTimer->setSingleShot(true);
     
-    connect(refreshTimer, &QTimer::timeout, this, &HotspotLobby::onRefreshTimer);
     connect(networkStatusTimer, &QTimer::timeout, this, &HotspotLobby::onNetworkStatusTimer);
     connect(statusMessageTimer, &QTimer::timeout, [this]() {
         statusLabel->setText("");
@@ -123,6 +121,12 @@ void HotspotLobby::setNetworkManager(HotspotNetworkManager* manager)
                 this, &HotspotLobby::onConnectedToHost);
         connect(networkManager, &HotspotNetworkManager::disconnectedFromHost,
                 this, &HotspotLobby::onDisconnectedFromHost);
+        connect(networkManager, &HotspotNetworkManager::connectionInterrupted,
+                this, &HotspotLobby::onConnectionInterrupted);
+        connect(networkManager, &HotspotNetworkManager::sessionResumed,
+                this, &HotspotLobby::onSessionResumed);
+        connect(networkManager, &HotspotNetworkManager::playerConnectionLost,
+                this, &HotspotLobby::onPlayerConnectionLost);
         connect(networkManager, &HotspotNetworkManager::networkError,
                 this, &HotspotLobby::onNetworkError);
     }
@@ -197,10 +201,9 @@ void HotspotLobby::showClientMode()
     mainLayout->addWidget(currentWidget);
     currentWidget->show();
     
-    // 开始搜索房间
+    // 开始搜索房间；网络管理器按退避自动重发查询，不需要定时重新开始
     if (networkManager) {
         networkManager->startHostDiscovery();
-        refreshTimer->start(3000);
     }
     
     updateNetworkStatus();
@@ -229,15 +232,15 @@ void HotspotLobby::resetLobby()
     isInRoom = false;
     currentPlayerName.clear();
     
-    refreshTimer->stop();
-    
     if (networkManager) {
         networkManager->stopHostDiscovery();
     }
     
-    availableRoomsList->clear();
+    roomDirectory->clear();
     playerListWidget->clear();
     chatDisplay->clear();
+    characterSelectionCombo->setEnabled(true);
+    readyCheckBox->setEnabled(true);
     
     showModeSelection();
 }
@@ -340,6 +343,10 @@ void HotspotLobby::setupHostModeUI()
     maxPlayersCombo->setCurrentText("4");
     settingsLayout->addWidget(maxPlayersCombo, 2, 1);
     
+    lockstepCheckBox = new QCheckBox("锁步模式（只同步输入，适合弱信号热点）");
+    lockstepCheckBox->setToolTip("各设备运行同一模拟，每帧只传输方向变化；所有玩家都需要较稳定的连接");
+    settingsLayout->addWidget(lockstepCheckBox, 3, 0, 1, 2);
+    
     layout->addWidget(roomSettingsGroup);
     
     // 按钮
@@ -382,13 +389,20 @@ void HotspotLobby::setupClientModeUI()
     connect(clientPlayerNameEdit, &QLineEdit::textChanged, this, &HotspotLobby::onPlayerNameChanged);
     playerLayout->addWidget(clientPlayerNameEdit);
     
+    spectateCheckBox = new QCheckBox("观战");
+    spectateCheckBox->setToolTip("不占玩家名额，可以加入已满或正在进行的房间，画面更新频率较低");
+    playerLayout->addWidget(spectateCheckBox);
+    
     layout->addWidget(playerGroup);
     
     // 可用房间
     QGroupBox* roomsGroup = new QGroupBox("可用房间");
     QVBoxLayout* roomsLayout = new QVBoxLayout(roomsGroup);
     
-    availableRoomsList = new QListWidget();
+    availableRoomsList = new QListView();
+    availableRoomsList->setModel(roomDirectory);
+    availableRoomsList->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    availableRoomsList->setSelectionMode(QAbstractItemView::SingleSelection);
     availableRoomsList->setMinimumHeight(200);
     roomsLayout->addWidget(availableRoomsList);
     
@@ -529,12 +543,16 @@ void HotspotLobby::setupNetworkStatusUI()
     ipAddressLabel = new QLabel("未知");
     statusLayout->addWidget(ipAddressLabel, 2, 1);
     
-    statusLayout->addWidget(new QLabel("信号强度:"), 3, 0);
+    statusLayout->addWidget(new QLabel("链路质量:"), 3, 0);
     signalStrengthBar = new QProgressBar();
     signalStrengthBar->setRange(0, 100);
     signalStrengthBar->setValue(0);
     statusLayout->addWidget(signalStrengthBar, 3, 1);
     
+    statusLayout->addWidget(new QLabel("延迟/丢包:"), 4, 0);
+    linkStatsLabel = new QLabel("未测量");
+    statusLayout->addWidget(linkStatsLabel, 4, 1);
+    
     // 将网络状态组添加到主布局的底部
     mainLayout->addWidget(networkStatusGroup);
 }
@@ -563,7 +581,10 @@ void HotspotLobby::onCreateRoomClicked()
     isHost = true;
     
     // 创建房间
-    if (gameManager && gameManager->createRoom(playerName, roomName)) {
+    if (gameManager) {
+        gameManager->setLockstepMode(lockstepCheckBox->isChecked());
+    }
+    if (gameManager && gameManager->createRoom(playerName, roomName, maxPlayersCombo->currentText().toInt())) {
         showStatusMessage("正在创建房间...");
     } else {
         showStatusMessage("创建房间失败");
@@ -572,8 +593,8 @@ void HotspotLobby::onCreateRoomClicked()
 
 void HotspotLobby::onJoinRoomClicked()
 {
-    QListWidgetItem* selectedItem = availableRoomsList->currentItem();
-    if (!selectedItem) {
+    const QModelIndex selectedRoom = availableRoomsList->currentIndex();
+    if (!selectedRoom.isValid()) {
         showStatusMessage("请选择一个房间");
         return;
     }
@@ -584,7 +605,7 @@ void HotspotLobby::onJoinRoomClicked()
         return;
     }
     
-    QString hostAddress = selectedItem->data(Qt::UserRole).toString();
+    QString hostAddress = selectedRoom.data(RoomDirectory::HostAddressRole).toString();
     if (hostAddress.isEmpty()) {
         showStatusMessage("无效的房间地址");
         return;
@@ -593,8 +614,11 @@ void HotspotLobby::onJoinRoomClicked()
     currentPlayerName = playerName;
     isHost = false;
     
+    quint16 port = static_cast<quint16>(selectedRoom.data(RoomDirectory::HostPortRole).toUInt());
+    quint16 statePort = static_cast<quint16>(selectedRoom.data(RoomDirectory::HostStatePortRole).toUInt());
+    
     // 连接到主机
-    if (networkManager && networkManager->connectToHost(hostAddress)) {
+    if (networkManager && networkManager->connectToHost(hostAddress, port, statePort)) {
         showStatusMessage("正在连接到房间...");
     } else {
         showStatusMessage("连接失败");
@@ -603,7 +627,7 @@ void HotspotLobby::onJoinRoomClicked()
 
 void HotspotLobby::onRefreshRoomsClicked()
 {
-    availableRoomsList->clear();
+    roomDirectory->clear();
     if (networkManager) {
         networkManager->startHostDiscovery();
         showStatusMessage("正在搜索房间...");
@@ -672,14 +696,6 @@ void HotspotLobby::onSendChatMessage()
     chatInput->clear();
 }
 
-void HotspotLobby::onRefreshTimer()
-{
-    // 定期刷新房间列表
-    if (networkManager && currentWidget == clientModeWidget) {
-        networkManager->startHostDiscovery();
-    }
-}
-
 void HotspotLobby::onNetworkStatusTimer()
 {
     updateNetworkStatus();
@@ -698,23 +714,11 @@ void HotspotLobby::onHostStopped()
     showStatusMessage("房间已关闭");
 }
 
-void HotspotLobby::onHostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers)
+void HotspotLobby::onHostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers,
+                                    quint16 port, quint16 statePort)
 {
-    // 检查房间是否已存在
-    for (int i = 0; i < availableRoomsList->count(); ++i) {
-        QListWidgetItem* item = availableRoomsList->item(i);
-        if (item->data(Qt::UserRole).toString() == hostAddress) {
-            // 更新已有房间信息
-            item->setText(QString("%1 (%2/%3)").arg(roomName).arg(playerCount).arg(maxPlayers));
-            return;
-        }
-    }
-    
-    // 新增房间条目
-    QString itemText = QString("%1 (%2/%3)").arg(roomName).arg(playerCount).arg(maxPlayers);
-    QListWidgetItem* item = new QListWidgetItem(itemText);
-    item->setData(Qt::UserRole, hostAddress);
-    availableRoomsList->addItem(item);
+    // 重复通告由房间目录吸收，列表只在房间信息真正变化时更新
+    roomDirectory->updateRoom(hostAddress, roomName, playerCount, maxPlayers, port, statePort);
 }
 
 void HotspotLobby::onConnectedToHost(const QString& hostAddress)
@@ -725,9 +729,15 @@ void HotspotLobby::onConnectedToHost(const QString& hostAddress)
     roomInfoLabel->setText(QString("已连接到: %1").arg(hostAddress));
     showStatusMessage("成功连接到主机");
     
-    // 自动发送加入请求
+    // 自动发送加入请求；观战者不能选择角色和准备
+    const bool spectate = spectateCheckBox->isChecked();
+    characterSelectionCombo->setEnabled(!spectate);
+    readyCheckBox->setEnabled(!spectate);
     if (gameManager && !currentPlayerName.isEmpty()) {
-        gameManager->joinRoom(currentPlayerName);
+        gameManager->joinRoom(currentPlayerName, spectate);
+        if (spectate) {
+            showStatusMessage("已以观战者身份加入");
+        }
     }
 }
 
@@ -737,6 +747,21 @@ void HotspotLobby::onDisconnectedFromHost()
     showStatusMessage("与主机断开连接");
 }
 
+void HotspotLobby::onConnectionInterrupted()
+{
+    showStatusMessage("连接中断，正在重新连接...", 10000);
+}
+
+void HotspotLobby::onSessionResumed()
+{
+    showStatusMessage("已恢复连接");
+}
+
+void HotspotLobby::onPlayerConnectionLost(const QString& playerName)
+{
+    addChatMessage(QString("玩家 %1 连接中断，等待重新连接").arg(playerName));
+}
+
 void HotspotLobby::onNetworkError(const QString& errorMessage)
 {
     showStatusMessage(QString("网络错误: %1").arg(errorMessage));
@@ -819,6 +844,7 @@ void HotspotLobby::updatePlayerList()
     QStringList playerNames = gameManager->getPlayerNames();
     HotspotGameState gameState = gameManager->getGameState();
     QString hostPlayerName = gameManager->getHostPlayerName();
+    const QMap<QString, HotspotGameManager::ClientLinkInfo> syncInfo = gameManager->getClientLinkInfo();
     
     // 确保房主信息在列表中（如果房主不在playerNames中，则添加）
     if (!hostPlayerName.isEmpty() && !playerNames.contains(hostPlayerName)) {
@@ -846,6 +872,17 @@ void HotspotLobby::updatePlayerList()
             itemText += " (我)";
         }
         
+        // 房主可以看到每个客户端的链路质量、当前的快照频率和发送积压
+        auto sync = syncInfo.constFind(playerName);
+        if (sync != syncInfo.constEnd() && networkManager) {
+            const HotspotNetworkManager::LinkStats stats = networkManager->getLinkStats(playerName);
+            itemText += QString(" [%1ms 丢包%2% 每%3帧快照 积压%4KB]")
+                            .arg(stats.rtt)
+                            .arg(stats.lossPercent)
+                            .arg(sync.value().snapshotInterval)
+                            .arg(sync.value().backlog / 1024.0, 0, 'f', 1);
+        }
+        
         QListWidgetItem* item = new QListWidgetItem(itemText);
         if (gameState.playerReadyStatus.value(playerName, false)) {
             item->setBackground(QBrush(QColor(200, 255, 200)));
@@ -867,6 +904,7 @@ void HotspotLobby::updateNetworkStatus()
         networkTypeLabel->setText("未知");
         ipAddressLabel->setText("未知");
         signalStrengthBar->setValue(0);
+        linkStatsLabel->setText("未测量");
         return;
     }
     
@@ -889,15 +927,48 @@ void HotspotLobby::updateNetworkStatus()
         
         QString localIP = networkManager->getLocalIPAddress();
         ipAddressLabel->setText(localIP);
-        
-        // 模拟信号强度
-        signalStrengthBar->setValue(85);
     } else {
         networkTypeLabel->setText("非热点网络");
         networkTypeLabel->setStyleSheet("QLabel { color: orange; }");
         ipAddressLabel->setText("未知");
+    }
+    
+    updateLinkQuality();
+}
+
+void HotspotLobby::updateLinkQuality()
+{
+    // 客户端显示到主机的链路；房主显示最差的一个客户端
+    HotspotNetworkManager::LinkStats stats;
+    if (networkManager->isHosting()) {
+        for (const QString& playerName : networkManager->getConnectedPlayerNames()) {
+            const HotspotNetworkManager::LinkStats peer = networkManager->getLinkStats(playerName);
+            if (peer.samples > 0 && (stats.samples == 0 || peer.rtt + peer.jitter > stats.rtt + stats.jitter ||
+                                     peer.lossPercent > stats.lossPercent)) {
+                stats = peer;
+            }
+        }
+    } else if (networkManager->isConnectedToHost()) {
+        stats = networkManager->getLinkStats();
+    }
+    
+    if (stats.samples == 0) {
+        linkStatsLabel->setText("未测量");
         signalStrengthBar->setValue(0);
+        return;
     }
+    
+    if (stats.rtt < 0) {
+        linkStatsLabel->setText(QString("无响应 丢包%1%").arg(stats.lossPercent));
+    } else {
+        linkStatsLabel->setText(QString("%1ms 抖动%2ms 丢包%3%")
+                                    .arg(stats.rtt).arg(stats.jitter).arg(stats.lossPercent));
+    }
+    
+    // 每5ms往返、每2ms抖动、每1%丢包各扣一分，局域网热点正常应在90分以上
+    const int rttPenalty = stats.rtt < 0 ? 100 : stats.rtt / 5;
+    const int quality = 100 - rttPenalty - stats.jitter / 2 - stats.lossPercent;
+    signalStrengthBar->setValue(qBound(0, quality, 100));
 }
 
 void HotspotLobby::updateGameControls()
@@ -9,6 +9,7 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QListWidget>
+#include <QListView>
 #include <QComboBox>
 #include <QProgressBar>
 #include <QTimer>
@@ -18,6 +19,7 @@
 #include "hotspotnetworkmanager.h"
 #include "hotspotgamemanager.h"
 #include "gamestate.h"
+#include "roomdirectory.h"
 
 /**
  * 热点多人游戏大厅
@@ -56,9 +58,13 @@ private slots:
     // 网络事件
     void onHostStarted(const QString& roomName, const QString& ipAddress);
     void onHostStopped();
-    void onHostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers);
+    void onHostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers,
+                          quint16 port, quint16 statePort);
     void onConnectedToHost(const QString& hostAddress);
     void onDisconnectedFromHost();
+    void onConnectionInterrupted();
+    void onSessionResumed();
+    void onPlayerConnectionLost(const QString& playerName);
     void onNetworkError(const QString& errorMessage);
     
     // 玩家事件
@@ -86,7 +92,6 @@ private slots:
     void onSendChatMessage();
     
     // 定时器事件
-    void onRefreshTimer();
     void onNetworkStatusTimer();
     
 private:
@@ -100,6 +105,7 @@ private:
     
     void updatePlayerList();
     void updateNetworkStatus();
+    void updateLinkQuality();
     void updateGameControls();
     void addChatMessage(const QString& message);
     void showStatusMessage(const QString& message, int timeout = 3000);
@@ -126,13 +132,16 @@ private:
     QLineEdit* roomNameEdit;
     QLineEdit* hostPlayerNameEdit;
     QComboBox* maxPlayersCombo;
+    QCheckBox* lockstepCheckBox;
     QPushButton* createRoomButton;
     QPushButton* backFromHostButton;
     
     // 客户端模式界面
     QWidget* clientModeWidget;
     QLineEdit* clientPlayerNameEdit;
-    QListWidget* availableRoomsList;
+    QCheckBox* spectateCheckBox;
+    QListView* availableRoomsList;
+    RoomDirectory* roomDirectory;    // 房间列表的数据模型，负责去重和过期
     QPushButton* joinRoomButton;
     QPushButton* refreshRoomsButton;
     QPushButton* backFromClientButton;
@@ -158,12 +167,12 @@ private:
     QLabel* networkTypeLabel;
     QLabel* ipAddressLabel;
     QProgressBar* signalStrengthBar;
+    QLabel* linkStatsLabel;
     
     // 状态栏
     QLabel* statusLabel;
     
     // 定时器
-    QTimer* refreshTimer;
     QTimer* networkStatusTimer;
     QTimer* statusMessageTimer;
     
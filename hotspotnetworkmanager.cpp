@@ -5,6 +5,7 @@
 #include <QJsonArray>
 #include <QDebug>
 #include <random>
+#include <limits>
 #include <QRandomGenerator>
 
 HotspotNetworkManager::HotspotNetworkManager(QObject *parent)
@@ -12,21 +13,47 @@ HotspotNetworkManager::HotspotNetworkManager(QObject *parent)
     , tcpServer(nullptr)
     , tcpClient(nullptr)
     , udpSocket(nullptr)
+    , stateSocket(nullptr)
     , discoveryTimer(new QTimer(this))
     , heartbeatTimer(new QTimer(this))
     , broadcastTimer(new QTimer(this))
+    , responseTimer(new QTimer(this))
+    , flushTimer(new QTimer(this))
+    , localFeatures(HotspotProtocol::SUPPORTED_FEATURES)
+    , sessionTimer(new QTimer(this))
+    , sessionToken(0)
+    , reconnectTimer(new QTimer(this))
+    , reconnectDeadline(0)
+    , queryInterval(INITIAL_QUERY_INTERVAL)
+    , announceInterval(INITIAL_ANNOUNCE_INTERVAL)
     , maxPlayers(4)
     , isHost(false)
+    , dedicatedServer(false)
+    , discoveryEnabled(true)
+    , hostPort(DEFAULT_PORT)
+    , hostStatePort(STATE_PORT)
+    , stateChannelReady(false)
 {
     // 设置定时器
-    discoveryTimer->setSingleShot(false);
+    discoveryTimer->setSingleShot(true);
     heartbeatTimer->setSingleShot(false);
-    broadcastTimer->setSingleShot(false);
+    broadcastTimer->setSingleShot(true);
+    responseTimer->setSingleShot(true);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(0);
+    sessionTimer->setSingleShot(true);
+    reconnectTimer->setSingleShot(false);
     
     // 连接定时器信号
     connect(discoveryTimer, &QTimer::timeout, this, &HotspotNetworkManager::processHostDiscovery);
     connect(heartbeatTimer, &QTimer::timeout, this, &HotspotNetworkManager::onHeartbeatTimeout);
-    connect(broadcastTimer, &QTimer::timeout, this, &HotspotNetworkManager::broadcastHostInfo);
+    connect(broadcastTimer, &QTimer::timeout, this, &HotspotNetworkManager::onAnnounceTimeout);
+    connect(responseTimer, &QTimer::timeout, this, &HotspotNetworkManager::broadcastHostInfo);
+    connect(flushTimer, &QTimer::timeout, this, &HotspotNetworkManager::flushOutboundQueues);
+    connect(sessionTimer, &QTimer::timeout, this, &HotspotNetworkManager::onSessionExpiryTimeout);
+    connect(reconnectTimer, &QTimer::timeout, this, &HotspotNetworkManager::onReconnectTimeout);
+    
+    linkClock.start();
 }
 
 HotspotNetworkManager::~HotspotNetworkManager()
@@ -45,8 +72,8 @@ bool HotspotNetworkManager::startHotspotHost(const QString& roomName, int maxPla
         return false;
     }
     
-    // 检查是否在热点网络中
-    if (!isInHotspotNetwork()) {
+    // 检查是否在热点网络中；专用服务器通常接在有线网络上，不做检查
+    if (!dedicatedServer && !isInHotspotNetwork()) {
         QString error = "Not connected to a hotspot network";
         qWarning() << error;
         emit networkError(error);
@@ -60,7 +87,7 @@ bool HotspotNetworkManager::startHotspotHost(const QString& roomName, int maxPla
     connect(tcpServer, &QTcpServer::newConnection, this, &HotspotNetworkManager::onNewClientConnection);
     
     // 启动服务器
-    if (!tcpServer->listen(QHostAddress::Any, DEFAULT_PORT)) {
+    if (!tcpServer->listen(QHostAddress::Any, hostPort)) {
         qWarning() << "Failed to start TCP server:" << tcpServer->errorString();
         delete tcpServer;
         tcpServer = nullptr;
@@ -68,26 +95,33 @@ bool HotspotNetworkManager::startHotspotHost(const QString& roomName, int maxPla
     }
     
     // 创建UDP套接字用于广播
-    udpSocket = new QUdpSocket(this);
-    if (!udpSocket->bind(QHostAddress::Any, DISCOVERY_PORT)) {
-        qWarning() << "Failed to bind UDP socket:" << udpSocket->errorString();
+    if (discoveryEnabled) {
+        udpSocket = new QUdpSocket(this);
+        if (!bindDiscoverySocket(DISCOVERY_PORT)) {
+            qWarning() << "Failed to bind UDP socket:" << udpSocket->errorString();
+        }
+        connect(udpSocket, &QUdpSocket::readyRead, this, &HotspotNetworkManager::onUdpDataReceived);
     }
-    connect(udpSocket, &QUdpSocket::readyRead, this, &HotspotNetworkManager::onUdpDataReceived);
+    
+    // 状态通道绑定失败时快照和输入继续走TCP，不影响开房
+    openStateChannel(hostStatePort);
     
     // 设置房间信息
     currentRoomName = roomName;
     this->maxPlayers = maxPlayers;
     isHost = true;
     
-    // 立即广播一次房间信息，然后开始定期广播
-    QTimer::singleShot(500, this, &HotspotNetworkManager::broadcastHostInfo); // 延迟500ms确保初始化完成
-    broadcastTimer->start(BROADCAST_INTERVAL);
+    // 开房后立即通告，之后按指数退避定期通告
+    restartAnnouncements();
+    
+    // 主机也向每个客户端发心跳，测量各自的链路质量
+    setupHeartbeat();
     
     QString localIP = getLocalIPAddress();
     emit hostStarted(roomName, localIP);
     
-    qDebug() << "Hotspot host started:" << roomName << "on" << localIP << ":" << DEFAULT_PORT;
-    qDebug() << "Host will start broadcasting in 500ms to ensure full initialization";
+    qDebug() << "Hotspot host started:" << roomName << "on" << localIP << ":" << hostPort;
+    qDebug() << "Host answers discovery queries and re-announces with backoff";
     return true;
 }
 
@@ -99,7 +133,9 @@ void HotspotNetworkManager::stopHotspotHost()
     
     // 停止定时器
     broadcastTimer->stop();
+    responseTimer->stop();
     heartbeatTimer->stop();
+    sessionTimer->stop();
     
     // 断开所有客户端
     for (QTcpSocket* client : connectedClients) {
@@ -109,6 +145,17 @@ void HotspotNetworkManager::stopHotspotHost()
     connectedClients.clear();
     clientPlayerNames.clear();
     playerSockets.clear();
+    spectatorNames.clear();
+    receiveParsers.clear();
+    outboundQueues.clear();
+    peerProtocols.clear();
+    compressionSource.clear();
+    compressionResult.clear();
+    stateEndpoints.clear();
+    peerLinks.clear();
+    sessionTokens.clear();
+    suspendedSessions.clear();
+    closeStateChannel();
     
     // 关闭服务器
     if (tcpServer) {
@@ -154,21 +201,8 @@ void HotspotNetworkManager::startHostDiscovery()
         qDebug() << "Creating UDP socket for discovery";
         udpSocket = new QUdpSocket(this);
         
-        // 尝试绑定到发现端口，如果失败则尝试其他端口
-        bool bindSuccess = false;
-        QList<quint16> portsToTry = {DISCOVERY_PORT, DISCOVERY_PORT + 1, DISCOVERY_PORT + 2, 0}; // 0表示系统分配
-        
-        for (quint16 port : portsToTry) {
-            if (udpSocket->bind(QHostAddress::Any, port)) {
-                qDebug() << "UDP socket bound to port" << udpSocket->localPort();
-                bindSuccess = true;
-                break;
-            } else {
-                qDebug() << "Failed to bind to port" << port << ":" << udpSocket->errorString();
-            }
-        }
-        
-        if (!bindSuccess) {
+        // 发现端口以共享方式绑定；实在失败时用系统分配的端口，仍可发送查询，但收不到组播通告
+        if (!bindDiscoverySocket(DISCOVERY_PORT) && !udpSocket->bind(QHostAddress::AnyIPv4, 0)) {
             qWarning() << "Failed to bind UDP socket to any port";
             emit networkError(QString("Failed to bind UDP socket: %1").arg(udpSocket->errorString()));
             udpSocket->deleteLater();
@@ -181,13 +215,11 @@ void HotspotNetworkManager::startHostDiscovery()
         qDebug() << "Using existing UDP socket for discovery, bound to port" << udpSocket->localPort();
     }
     
-    // 开始定期发现主机
-    discoveryTimer->start(DISCOVERY_INTERVAL);
+    // 立即查询一次，之后按指数退避重发
+    queryInterval = INITIAL_QUERY_INTERVAL;
+    processHostDiscovery();
     
-    qDebug() << "Started host discovery with interval" << DISCOVERY_INTERVAL << "ms";
-    
-    // 延迟执行第一次发现，确保网络状态稳定
-    QTimer::singleShot(200, this, &HotspotNetworkManager::processHostDiscovery);
+    qDebug() << "Started host discovery on port" << udpSocket->localPort();
 }
 
 void HotspotNetworkManager::stopHostDiscovery()
@@ -196,38 +228,84 @@ void HotspotNetworkManager::stopHostDiscovery()
     qDebug() << "Stopped host discovery";
 }
 
-bool HotspotNetworkManager::connectToHost(const QString& hostAddress)
+bool HotspotNetworkManager::connectToHost(const QString& hostAddress, quint16 port, quint16 statePort)
 {
     if (isConnectedToHost()) {
         qWarning() << "Already connected to a host";
         return false;
     }
     
-    // 创建TCP客户端
+    // 放弃上一次尚未恢复的会话
+    reconnectTimer->stop();
+    sessionToken = 0;
+    discardClientSocket();
+    
+    this->hostAddress = hostAddress;
+    hostPort = port;
+    hostStatePort = statePort;
+    openClientSocket();
+    
+    qDebug() << "Attempting to connect to host:" << hostAddress;
+    return true;
+}
+
+void HotspotNetworkManager::openClientSocket()
+{
     tcpClient = new QTcpSocket(this);
+    prepareSocket(tcpClient);
     connect(tcpClient, &QTcpSocket::connected, this, &HotspotNetworkManager::onClientConnected);
     connect(tcpClient, &QTcpSocket::disconnected, this, &HotspotNetworkManager::onClientDisconnected);
     connect(tcpClient, &QTcpSocket::readyRead, this, &HotspotNetworkManager::onDataReceived);
     connect(tcpClient, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
             this, &HotspotNetworkManager::onSocketError);
-    
-    // 连接到主机
-    tcpClient->connectToHost(hostAddress, DEFAULT_PORT);
-    this->hostAddress = hostAddress;
-    
-    qDebug() << "Attempting to connect to host:" << hostAddress;
-    return true;
+    tcpClient->connectToHost(hostAddress, hostPort);
+}
+
+void HotspotNetworkManager::discardClientSocket()
+{
+    if (!tcpClient) {
+        return;
+    }
+    // 先断开信号，关闭过程中不再进入onClientDisconnected
+    QTcpSocket* socket = tcpClient;
+    tcpClient = nullptr;
+    disconnect(socket, nullptr, this, nullptr);
+    receiveParsers.remove(socket);
+    outboundQueues.remove(socket);
+    peerProtocols.remove(socket);
+    socket->abort();
+    socket->deleteLater();
 }
 
 void HotspotNetworkManager::disconnectFromHost()
 {
+    // 主动离开，不再尝试恢复会话
+    reconnectTimer->stop();
+    sessionToken = 0;
+    
     if (tcpClient) {
-        tcpClient->disconnectFromHost();
-        tcpClient->deleteLater();
+        QTcpSocket* socket = tcpClient;
         tcpClient = nullptr;
+        disconnect(socket, nullptr, this, nullptr);
+        
+        // 队列中的离开消息要先写出，主机才会把这次断开当作主动离开而不是等待重连
+        const QByteArray pending = outboundQueues.value(socket).data;
+        if (!pending.isEmpty() && socket->state() == QAbstractSocket::ConnectedState) {
+            socket->write(pending);
+        }
+        receiveParsers.remove(socket);
+        outboundQueues.remove(socket);
+        peerProtocols.remove(socket);
+        socket->disconnectFromHost();
+        socket->deleteLater();
     }
+    hostPort = DEFAULT_PORT;
+    hostStatePort = STATE_PORT;
     
     heartbeatTimer->stop();
+    closeStateChannel();
+    peerLinks.clear();
+    localPlayerName.clear();
     hostAddress.clear();
     
     emit disconnectedFromHost();
@@ -239,75 +317,283 @@ bool HotspotNetworkManager::isConnectedToHost() const
     return tcpClient && tcpClient->state() == QAbstractSocket::ConnectedState;
 }
 
-void HotspotNetworkManager::sendPlayerData(const QString& playerName, const QJsonObject& playerData)
+void HotspotNetworkManager::sendPlayerJoin(const QString& playerName, bool spectator)
 {
-    QJsonObject message = createMessage("player_data");
-    message["player_name"] = playerName;
-    message["data"] = playerData;
+    // 令牌随主机的JoinAccepted到达，观战者没有令牌
+    sessionToken = 0;
+    sendToHost(HotspotProtocol::encodePlayerJoin(playerName, spectator ? HotspotProtocol::JoinAsSpectator : 0, 0, localFeatures));
     
-    if (isHosting()) {
-        broadcastToClients(message);
-    } else if (isConnectedToHost()) {
-        QJsonDocument doc(message);
-        tcpClient->write(doc.toJson(QJsonDocument::Compact) + "\n");
+    // 观战者只走TCP，不登记状态通道
+    if (spectator) {
+        localPlayerName.clear();
+        return;
     }
+    
+    // 主机先通过TCP认识这个名字，再接受同名的状态通道登记
+    localPlayerName = playerName;
+    sendStateHello();
 }
 
-void HotspotNetworkManager::sendGameState(const QJsonObject& gameState)
+void HotspotNetworkManager::sendPlayerLeave(const QString& playerName)
 {
-    QJsonObject message = createMessage("game_state");
-    message["state"] = gameState;
+    sendToHost(HotspotProtocol::encodePlayerLeave(playerName));
+}
+
+void HotspotNetworkManager::sendPlayerUpdate(const QString& playerName, const HotspotProtocol::PlayerUpdate& update)
+{
+    sendToHost(HotspotProtocol::encodePlayerUpdate(playerName, update));
+}
+
+void HotspotNetworkManager::sendChatMessage(const QString& playerName, const QString& message)
+{
+    QByteArray encoded = HotspotProtocol::encodeChatMessage(playerName, message);
     
     if (isHosting()) {
-        broadcastToClients(message);
+        broadcastToClients(encoded);
+    } else {
+        sendToHost(encoded);
     }
 }
 
-void HotspotNetworkManager::sendChatMessage(const QString& playerName, const QString& message)
+void HotspotNetworkManager::sendToHost(const QByteArray& message)
+{
+    if (isConnectedToHost()) {
+        queueFrame(tcpClient, message);
+    }
+}
+
+void HotspotNetworkManager::sendToPlayer(const QString& playerName, const QByteArray& message)
 {
-    QJsonObject msg = createMessage("chat_message");
-    msg["player_name"] = playerName;
-    msg["message"] = message;
+    QTcpSocket* socket = playerSockets.value(playerName);
+    if (isHosting() && socket && socket->state() == QAbstractSocket::ConnectedState) {
+        queueFrame(socket, message);
+    }
+}
+
+qint64 HotspotNetworkManager::getPendingBytes(const QString& playerName) const
+{
+    QTcpSocket* socket = playerSockets.value(playerName);
+    if (!socket) {
+        return 0;
+    }
+    return socket->bytesToWrite() + outboundQueues.value(socket).data.size();
+}
+
+void HotspotNetworkManager::broadcastToClients(const QByteArray& message)
+{
+    if (!isHosting()) {
+        return;
+    }
     
-    if (isHosting()) {
-        broadcastToClients(msg);
-    } else if (isConnectedToHost()) {
-        QJsonDocument doc(msg);
-        tcpClient->write(doc.toJson(QJsonDocument::Compact) + "\n");
+    for (QTcpSocket* client : connectedClients) {
+        if (client->state() == QAbstractSocket::ConnectedState && !spectatorNames.contains(client)) {
+            queueFrame(client, message);
+        }
     }
 }
 
-void HotspotNetworkManager::sendMessage(const QString& type, const QJsonObject& data)
+void HotspotNetworkManager::broadcastToSpectators(const QByteArray& message)
 {
-    QJsonObject message = createMessage(type, data);
+    if (!isHosting() || spectatorNames.isEmpty()) {
+        return;
+    }
     
-    if (isHosting()) {
-        broadcastToClients(message);
-    } else if (isConnectedToHost()) {
-        QJsonDocument doc(message);
-        tcpClient->write(doc.toJson(QJsonDocument::Compact) + "\n");
+    // 所有观战者共用同一份编码；慢速观战者的队列中只保留最新快照，每人带宽不超过快照频率
+    const bool snapshot = static_cast<HotspotProtocol::Opcode>(static_cast<quint8>(message.at(0))) == HotspotProtocol::Opcode::GameState;
+    for (auto it = spectatorNames.constBegin(); it != spectatorNames.constEnd(); ++it) {
+        if (it.key()->state() == QAbstractSocket::ConnectedState) {
+            queueFrame(it.key(), message, snapshot);
+        }
     }
 }
 
-void HotspotNetworkManager::broadcastToClients(const QJsonObject& message)
+void HotspotNetworkManager::sendStateToHost(const QByteArray& message)
+{
+    if (!isConnectedToHost()) {
+        return;
+    }
+    
+    if (stateSocket && stateChannelReady && message.size() <= HotspotProtocol::MAX_DATAGRAM_SIZE) {
+        stateSocket->writeDatagram(message, tcpClient->peerAddress(), hostStatePort);
+        traffic.udpBytesSent += static_cast<quint64>(message.size());
+    } else {
+        queueFrame(tcpClient, message);
+    }
+}
+
+void HotspotNetworkManager::sendStateToPlayer(const QString& playerName, const QByteArray& message)
 {
     if (!isHosting()) {
         return;
     }
     
-    QJsonDocument doc(message);
-    QByteArray data = doc.toJson(QJsonDocument::Compact) + "\n";
+    auto endpoint = stateEndpoints.constFind(playerName);
+    if (stateSocket && endpoint != stateEndpoints.constEnd() &&
+        message.size() <= HotspotProtocol::MAX_DATAGRAM_SIZE) {
+        stateSocket->writeDatagram(message, endpoint->address, endpoint->port);
+        traffic.udpBytesSent += static_cast<quint64>(message.size());
+    } else {
+        // 关键帧等大消息走TCP，可靠送达后作为后续增量的基线；积压时可被更新的快照取代
+        QTcpSocket* socket = playerSockets.value(playerName);
+        if (socket && socket->state() == QAbstractSocket::ConnectedState) {
+            const bool snapshot = static_cast<HotspotProtocol::Opcode>(static_cast<quint8>(message.at(0))) == HotspotProtocol::Opcode::GameState;
+            queueFrame(socket, message, snapshot);
+        }
+    }
+}
+
+void HotspotNetworkManager::broadcastState(const QByteArray& message)
+{
+    if (!isHosting()) {
+        return;
+    }
     
-    for (QTcpSocket* client : connectedClients) {
-        if (client->state() == QAbstractSocket::ConnectedState) {
-            client->write(data);
+    for (auto it = playerSockets.constBegin(); it != playerSockets.constEnd(); ++it) {
+        sendStateToPlayer(it.key(), message);
+    }
+}
+
+bool HotspotNetworkManager::openStateChannel(quint16 port)
+{
+    closeStateChannel();
+    
+    stateSocket = new QUdpSocket(this);
+    if (!stateSocket->bind(QHostAddress::Any, port)) {
+        qWarning() << "Failed to bind state channel, falling back to TCP:" << stateSocket->errorString();
+        stateSocket->deleteLater();
+        stateSocket = nullptr;
+        return false;
+    }
+    connect(stateSocket, &QUdpSocket::readyRead, this, &HotspotNetworkManager::onStateDataReceived);
+    
+    qDebug() << "State channel bound to UDP port" << stateSocket->localPort();
+    return true;
+}
+
+void HotspotNetworkManager::closeStateChannel()
+{
+    if (stateSocket) {
+        stateSocket->close();
+        stateSocket->deleteLater();
+        stateSocket = nullptr;
+    }
+    stateChannelReady = false;
+}
+
+void HotspotNetworkManager::sendStateHello()
+{
+    // 主机不支持状态通道时不会回复，快照和输入一直走TCP
+    if (!stateSocket || localPlayerName.isEmpty() || !isConnectedToHost() ||
+        !(localFeatures & HotspotProtocol::FeatureStateChannel)) {
+        return;
+    }
+    stateSocket->writeDatagram(HotspotProtocol::encodeStateHello(localPlayerName),
+                               tcpClient->peerAddress(), hostStatePort);
+}
+
+void HotspotNetworkManager::writeFrame(QTcpSocket* socket, const QByteArray& message)
+{
+    if (message.isEmpty() || message.size() > HotspotProtocol::MAX_FRAME_SIZE) {
+        qWarning() << "Message size not allowed in a frame, dropped:" << message.size() << "bytes";
+        return;
+    }
+    
+    // 帧头和消息拼成一次写入，避免产生只含帧头的小分段
+    QByteArray frame;
+    frame.reserve(message.size() + 4);
+    HotspotProtocol::appendFrame(frame, message);
+    socket->write(frame);
+}
+
+void HotspotNetworkManager::queueFrame(QTcpSocket* socket, const QByteArray& message, bool replaceableSnapshot)
+{
+    if (message.isEmpty() || message.size() > HotspotProtocol::MAX_FRAME_SIZE) {
+        qWarning() << "Message size not allowed in a frame, dropped:" << message.size() << "bytes";
+        return;
+    }
+    
+    OutboundQueue& queue = outboundQueues[socket];
+    
+    // 还没写出的旧快照已被新快照取代，直接从队列中删除
+    if (replaceableSnapshot && queue.snapshotOffset >= 0) {
+        queue.data.remove(queue.snapshotOffset, queue.snapshotSize);
+        queue.snapshotOffset = -1;
+    }
+    
+    const int offset = queue.data.size();
+    HotspotProtocol::appendFrame(queue.data, compressForPeer(socket, message));
+    if (replaceableSnapshot) {
+        queue.snapshotOffset = offset;
+        queue.snapshotSize = queue.data.size() - offset;
+    }
+    
+    if (queue.data.size() > MAX_QUEUED_BYTES) {
+        // 对端长时间不接收数据，继续排队只会占用内存；断开放到事件循环中，避免在调用方遍历连接时修改列表
+        qWarning() << "Send queue overflow for" << socket->peerAddress().toString() << ", closing connection";
+        outboundQueues.remove(socket);
+        QTimer::singleShot(0, socket, [socket]() { socket->abort(); });
+        return;
+    }
+    
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+QByteArray HotspotNetworkManager::compressForPeer(QTcpSocket* socket, const QByteArray& message)
+{
+    if (message.size() < HotspotProtocol::COMPRESSION_THRESHOLD ||
+        !(peerProtocols.value(socket).features & HotspotProtocol::FeatureCompression)) {
+        return message;
+    }
+    
+    // 广播时同一个QByteArray依次发给各连接，共享同一块数据；持有它的引用保证地址不会被别的消息复用
+    if (message.constData() != compressionSource.constData() || message.size() != compressionSource.size()) {
+        compressionSource = message;
+        compressionResult = HotspotProtocol::encodeCompressed(message);
+    }
+    return compressionResult.size() < message.size() ? compressionResult : message;
+}
+
+void HotspotNetworkManager::flushOutboundQueues()
+{
+    for (auto it = outboundQueues.begin(); it != outboundQueues.end(); ++it) {
+        QTcpSocket* socket = it.key();
+        OutboundQueue& queue = it.value();
+        if (queue.data.isEmpty() || socket->state() != QAbstractSocket::ConnectedState) {
+            continue;
+        }
+        
+        // 套接字积压过多时先不写入，等bytesWritten后再写，期间新快照可以取代队列中的旧快照
+        if (socket->bytesToWrite() > MAX_SOCKET_BACKLOG) {
+            continue;
         }
+        
+        socket->write(queue.data);
+        traffic.tcpBytesSent += static_cast<quint64>(queue.data.size());
+        queue.data.resize(0);  // 保留容量，下一轮复用
+        queue.snapshotOffset = -1;
     }
 }
 
+void HotspotNetworkManager::prepareSocket(QTcpSocket* socket)
+{
+    // 消息已经按轮合并，关闭Nagle算法避免再被延迟等待
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    
+    connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() {
+        auto queue = outboundQueues.constFind(socket);
+        if (queue != outboundQueues.constEnd() && !queue->data.isEmpty() && !flushTimer->isActive()) {
+            flushTimer->start();
+        }
+    });
+}
+
 int HotspotNetworkManager::getConnectedPlayersCount() const
 {
-    return connectedClients.size() + (isHosting() ? 1 : 0);
+    // 断线等待重连的玩家仍占着名额
+    return connectedClients.size() - spectatorNames.size() + suspendedSessions.size() +
+           (isHosting() && !dedicatedServer ? 1 : 0);
 }
 
 QStringList HotspotNetworkManager::getConnectedPlayerNames() const
@@ -411,17 +697,18 @@ void HotspotNetworkManager::onNewClientConnection()
     while (tcpServer->hasPendingConnections()) {
         QTcpSocket* client = tcpServer->nextPendingConnection();
         
-        if (connectedClients.size() >= maxPlayers - 1) {
+        // 玩家名额在收到加入消息时检查，这里只限制连接总数
+        const int playerSlots = dedicatedServer ? maxPlayers : maxPlayers - 1;
+        if (connectedClients.size() >= playerSlots + MAX_SPECTATORS) {
             // 房间已满
-            QJsonObject message = createMessage("room_full");
-            QJsonDocument doc(message);
-            client->write(doc.toJson(QJsonDocument::Compact) + "\n");
+            writeFrame(client, HotspotProtocol::encodeJoinRejected(HotspotProtocol::RejectReason::RoomFull));
             client->disconnectFromHost();
             client->deleteLater();
             continue;
         }
         
         connectedClients.append(client);
+        prepareSocket(client);
         
         connect(client, &QTcpSocket::readyRead, this, &HotspotNetworkManager::onDataReceived);
         connect(client, &QTcpSocket::disconnected, this, &HotspotNetworkManager::onClientDisconnected);
@@ -435,7 +722,19 @@ void HotspotNetworkManager::onNewClientConnection()
 void HotspotNetworkManager::onClientConnected()
 {
     if (tcpClient) {
+        // 连接建立前套接字选项不会生效，这里补设
+        tcpClient->setSocketOption(QAbstractSocket::LowDelayOption, 1);
         setupHeartbeat();
+        // 客户端状态通道使用系统分配的端口，由登记消息告知主机
+        openStateChannel(0);
+        
+        if (isReconnecting()) {
+            // 恢复请求和状态通道登记一起发出，主机在同一轮回复确认、名单和关键帧，一个往返后即可继续操作
+            sendToHost(HotspotProtocol::encodePlayerJoin(localPlayerName, HotspotProtocol::JoinResume, sessionToken, localFeatures));
+            sendStateHello();
+            qDebug() << "Reconnected to host, resuming session for" << localPlayerName;
+            return;
+        }
         emit connectedToHost(hostAddress);
         qDebug() << "Connected to host:" << hostAddress;
     }
@@ -446,22 +745,50 @@ void HotspotNetworkManager::onClientDisconnected()
     QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
     if (!socket) return;
     
+    receiveParsers.remove(socket);
+    outboundQueues.remove(socket);
+    peerProtocols.remove(socket);
+    
     if (socket == tcpClient) {
         // 客户端断开连接
         tcpClient = nullptr;
+        socket->deleteLater();
         heartbeatTimer->stop();
+        closeStateChannel();
+        peerLinks.clear();
+        
+        // 持有会话令牌时先在宽限期内重连，游戏和界面保持原状
+        if (sessionToken != 0 && !localPlayerName.isEmpty()) {
+            if (!isReconnecting()) {
+                reconnectDeadline = linkClock.elapsed() + SESSION_GRACE_PERIOD;
+                reconnectTimer->start(RECONNECT_INTERVAL);
+                emit connectionInterrupted();
+                qDebug() << "Connection to host lost, trying to resume session";
+            }
+            openClientSocket();
+            return;
+        }
+        
+        hostPort = DEFAULT_PORT;
+        hostStatePort = STATE_PORT;
         emit disconnectedFromHost();
         qDebug() << "Disconnected from host";
     } else {
         // 服务器端客户端断开连接
+        removeSpectator(socket);
         QString playerName = clientPlayerNames.value(socket);
         connectedClients.removeAll(socket);
         clientPlayerNames.remove(socket);
         playerSockets.remove(playerName);
+        stateEndpoints.remove(playerName);
+        peerLinks.remove(playerName);
         
         if (!playerName.isEmpty()) {
-            emit playerDisconnectedFromHost(playerName);
-            qDebug() << "Player disconnected:" << playerName;
+            // 主动离开时名字已经在PlayerLeave中移除，走到这里都是意外断线，保留位置等待重连
+            suspendedSessions[playerName] = linkClock.elapsed() + SESSION_GRACE_PERIOD;
+            scheduleSessionExpiry();
+            emit playerConnectionLost(playerName);
+            qDebug() << "Player connection lost, holding slot for" << SESSION_GRACE_PERIOD << "ms:" << playerName;
         }
         
         socket->deleteLater();
@@ -473,15 +800,41 @@ void HotspotNetworkManager::onDataReceived()
     QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
     if (!socket) return;
     
-    QByteArray data = socket->readAll();
-    QStringList messages = QString::fromUtf8(data).split("\n", Qt::SkipEmptyParts);
+    QSharedPointer<HotspotProtocol::FrameParser>& slot = receiveParsers[socket];
+    if (!slot) {
+        slot.reset(new HotspotProtocol::FrameParser);
+    }
+    // 持有一份引用：处理消息时连接可能被关闭并从表中移除，解析器的缓冲区仍需有效
+    const QSharedPointer<HotspotProtocol::FrameParser> parser = slot;
     
-    for (const QString& messageStr : messages) {
-        QJsonParseError error;
-        QJsonDocument doc = QJsonDocument::fromJson(messageStr.toUtf8(), &error);
+    while (socket->bytesAvailable() > 0) {
+        // 直接读入解析器缓冲区，不经过临时QByteArray
+        const int available = static_cast<int>(qMin<qint64>(socket->bytesAvailable(), 64 * 1024));
+        const qint64 bytesRead = socket->read(parser->reserve(available), available);
+        if (bytesRead <= 0) {
+            break;
+        }
+        traffic.tcpBytesReceived += static_cast<quint64>(bytesRead);
+        parser->commit(static_cast<int>(bytesRead));
         
-        if (error.error == QJsonParseError::NoError && doc.isObject()) {
-            processMessage(doc.object(), socket);
+        // 切出所有完整的帧，不完整的尾部留在缓冲区等待后续数据
+        const char* frame = nullptr;
+        int frameSize = 0;
+        HotspotProtocol::FrameParser::Status status;
+        while ((status = parser->nextFrame(frame, frameSize)) == HotspotProtocol::FrameParser::Status::FrameReady) {
+            processMessage(frame, frameSize, socket);
+            
+            // 处理消息时连接可能已被关闭
+            if (receiveParsers.value(socket) != parser) {
+                return;
+            }
+        }
+        
+        if (status == HotspotProtocol::FrameParser::Status::Error) {
+            qWarning() << "Invalid frame from" << socket->peerAddress().toString() << ", closing connection";
+            receiveParsers.remove(socket);
+            socket->abort();
+            return;
         }
     }
 }
@@ -490,10 +843,16 @@ void HotspotNetworkManager::onSocketError(QAbstractSocket::SocketError error)
 {
     QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
     if (socket) {
+        // 重连过程中的失败由重连定时器处理，不打扰界面
+        if (socket == tcpClient && isReconnecting()) {
+            qDebug() << "Reconnect attempt failed:" << socket->errorString();
+            return;
+        }
+        
         // 检查是否为优雅断开连接（玩家主动离开）
         if (error == QAbstractSocket::RemoteHostClosedError) {
             // 检查是否为已知的玩家连接
-            QString playerName = clientPlayerNames.value(socket);
+            QString playerName = clientPlayerNames.value(socket, spectatorNames.value(socket));
             if (!playerName.isEmpty()) {
                 qDebug() << "Player" << playerName << "gracefully disconnected";
                 return; // 不显示错误，这是正常的玩家离开
@@ -515,102 +874,131 @@ void HotspotNetworkManager::onDiscoveryTimeout()
 
 void HotspotNetworkManager::onHeartbeatTimeout()
 {
-    if (isConnectedToHost()) {
-        QJsonObject heartbeat = createMessage("heartbeat");
-        QJsonDocument doc(heartbeat);
-        tcpClient->write(doc.toJson(QJsonDocument::Compact) + "\n");
+    if (isHosting()) {
+        for (auto it = playerSockets.constBegin(); it != playerSockets.constEnd(); ++it) {
+            sendHeartbeat(it.key());
+        }
+        return;
     }
+    
+    sendHeartbeat(QString());
+    
+    // 重复登记：首个登记丢失时补上，也让NAT映射保持有效
+    sendStateHello();
 }
 
-void HotspotNetworkManager::processHostDiscovery()
+void HotspotNetworkManager::sendHeartbeat(const QString& playerName)
 {
-    if (!udpSocket) {
-        qWarning() << "UDP socket is null in processHostDiscovery";
-        return;
+    // 心跳和快照走同一条通道，测得的往返时间和丢包率反映快照实际经历的链路
+    PeerLink& link = peerLinks[playerName];
+    PingRecord record;
+    record.sequence = link.nextSequence++;
+    record.sentTime = linkClock.elapsed();
+    link.pings.push_back(record);
+    while (link.pings.size() > static_cast<size_t>(PING_WINDOW_SIZE)) {
+        link.pings.pop_front();
     }
     
-    // 检查网络状态
-    QString networkBase = getLocalIPAddress();
-    if (networkBase.isEmpty() || networkBase == "127.0.0.1") {
-        qWarning() << "Invalid network base for discovery:" << networkBase;
+    const QByteArray message = HotspotProtocol::encodeHeartbeat(record.sequence, static_cast<quint32>(record.sentTime));
+    if (playerName.isEmpty()) {
+        sendStateToHost(message);
+    } else {
+        sendStateToPlayer(playerName, message);
+    }
+}
+
+void HotspotNetworkManager::recordHeartbeatReply(const QString& playerName, quint32 sequence, quint32 timestamp)
+{
+    auto link = peerLinks.find(playerName);
+    if (link == peerLinks.end()) {
         return;
     }
     
-    qDebug() << "Starting host discovery from IP:" << networkBase;
-    
-    // 发送发现请求
-    QJsonObject discoveryRequest = createMessage("discover_hosts");
-    QJsonDocument doc(discoveryRequest);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
-    
-    qDebug() << "Discovery request data:" << data;
-    
-    // 首先尝试广播
-    qint64 broadcastBytes = udpSocket->writeDatagram(data, QHostAddress::Broadcast, DISCOVERY_PORT);
-    qDebug() << "Sent broadcast discovery request, bytes written:" << broadcastBytes;
-    
-    // 扫描多个可能的网络段
-    QStringList networkPrefixes = {
-        "192.168.43.",   // Android热点
-        "192.168.137.",  // Windows热点
-        "172.20.",       // iOS热点
-        "10.0.0.",       // 通用热点
-        "192.168.1.",    // 常见路由器
-        "192.168.0.",    // 常见路由器
-        "10.0.1.",       // 扩展热点段
-        "172.16.",       // 私有网络段
-    };
-    
-    bool foundMatchingSegment = false;
-    
-    // 首先扫描当前网络段
-    for (const QString& prefix : networkPrefixes) {
-        if (networkBase.startsWith(prefix)) {
-            qDebug() << "Scanning current network segment:" << prefix << "*";
-            int sentCount = 0;
-            for (int i = 1; i < 255; ++i) {
-                QString targetIP = prefix + QString::number(i);
-                if (targetIP != networkBase) { // 不发送给自己
-                    qint64 bytes = udpSocket->writeDatagram(data, QHostAddress(targetIP), DISCOVERY_PORT);
-                    if (bytes > 0) sentCount++;
-                }
+    // 时间戳是本端发出的，直接与本端时钟相减；按32位回绕计算
+    const quint32 rtt = static_cast<quint32>(linkClock.elapsed()) - timestamp;
+    for (PingRecord& record : link->pings) {
+        if (record.sequence == sequence) {
+            if (record.rtt < 0 && rtt <= static_cast<quint32>(PING_TIMEOUT)) {
+                record.rtt = static_cast<int>(rtt);
             }
-            qDebug() << "Sent discovery requests to" << sentCount << "addresses in current segment" << prefix << "*";
-            foundMatchingSegment = true;
             break;
         }
     }
+}
+
+HotspotNetworkManager::LinkStats HotspotNetworkManager::getLinkStats(const QString& playerName) const
+{
+    LinkStats stats;
+    auto link = peerLinks.constFind(playerName);
+    if (link == peerLinks.constEnd()) {
+        return stats;
+    }
     
-    // 如果当前网络段不匹配，扫描常见的热点网络段
-    if (!foundMatchingSegment) {
-        qDebug() << "Current network segment not recognized, scanning common hotspot segments";
-        QStringList commonHotspotPrefixes = {"192.168.43.", "172.20.", "192.168.137."};
-        
-        for (const QString& prefix : commonHotspotPrefixes) {
-            qDebug() << "Scanning hotspot segment:" << prefix << "*";
-            int sentCount = 0;
-            for (int i = 1; i < 255; ++i) {
-                QString targetIP = prefix + QString::number(i);
-                qint64 bytes = udpSocket->writeDatagram(data, QHostAddress(targetIP), DISCOVERY_PORT);
-                if (bytes > 0) sentCount++;
+    const qint64 now = linkClock.elapsed();
+    int answered = 0;
+    int lost = 0;
+    qint64 rttSum = 0;
+    qint64 jitterSum = 0;
+    int previousRtt = -1;
+    for (const PingRecord& record : link->pings) {
+        if (record.rtt >= 0) {
+            ++answered;
+            rttSum += record.rtt;
+            if (previousRtt >= 0) {
+                jitterSum += qAbs(record.rtt - previousRtt);
             }
-            qDebug() << "Sent discovery requests to" << sentCount << "addresses in hotspot segment" << prefix << "*";
+            previousRtt = record.rtt;
+        } else if (now - record.sentTime > PING_TIMEOUT) {
+            ++lost;
         }
+        // 还在等待回复的心跳不计入统计
     }
+    
+    stats.samples = answered + lost;
+    if (answered > 0) {
+        stats.rtt = static_cast<int>(rttSum / answered);
+    }
+    if (answered > 1) {
+        stats.jitter = static_cast<int>(jitterSum / (answered - 1));
+    }
+    if (stats.samples > 0) {
+        stats.lossPercent = lost * 100 / stats.samples;
+    }
+    return stats;
+}
+
+HotspotNetworkManager::PeerProtocol HotspotNetworkManager::getPeerProtocol(const QString& playerName) const
+{
+    QTcpSocket* socket = isHosting() ? playerSockets.value(playerName) : tcpClient;
+    return peerProtocols.value(socket);
+}
+
+void HotspotNetworkManager::processHostDiscovery()
+{
+    if (!udpSocket) {
+        qWarning() << "UDP socket is null in processHostDiscovery";
+        return;
+    }
+    
+    // 一次查询只发两个数据报：组播组，以及组播被过滤时的子网广播
+    const QByteArray data = QJsonDocument(createMessage("discover_hosts")).toJson(QJsonDocument::Compact);
+    udpSocket->writeDatagram(data, discoveryGroupAddress(), DISCOVERY_PORT);
+    udpSocket->writeDatagram(data, QHostAddress::Broadcast, DISCOVERY_PORT);
+    
+    // 主机启动和人数变化时会主动通告，查询只需越来越稀疏地兜底
+    discoveryTimer->start(queryInterval);
+    queryInterval = qMin(queryInterval * 2, static_cast<int>(MAX_QUERY_INTERVAL));
 }
 
 void HotspotNetworkManager::broadcastHostInfo()
 {
     if (!isHosting() || !udpSocket) {
-        qDebug() << "Cannot broadcast: isHosting=" << isHosting() << ", udpSocket=" << (udpSocket != nullptr);
         return;
     }
     
     QString localIP = getLocalIPAddress();
     if (localIP == "127.0.0.1" || localIP.isEmpty()) {
-        qWarning() << "Invalid local IP for broadcasting:" << localIP << ", retrying IP detection...";
-        // 重新检测IP地址
-        QTimer::singleShot(1000, this, &HotspotNetworkManager::broadcastHostInfo);
+        qWarning() << "Invalid local IP for broadcasting:" << localIP;
         return;
     }
     
@@ -619,41 +1007,59 @@ void HotspotNetworkManager::broadcastHostInfo()
     hostInfo["player_count"] = getConnectedPlayersCount();
     hostInfo["max_players"] = maxPlayers;
     hostInfo["host_address"] = localIP;
+    hostInfo["port"] = hostPort;
+    hostInfo["state_port"] = hostStatePort;
     
-    QJsonDocument doc(hostInfo);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
-    
-    // 多种方式广播主机信息
-    int successfulBroadcasts = 0;
-    
-    // 1. 标准广播
-    qint64 broadcastBytes = udpSocket->writeDatagram(data, QHostAddress::Broadcast, DISCOVERY_PORT);
-    if (broadcastBytes > 0) {
-        successfulBroadcasts++;
-        qDebug() << "Standard broadcast successful, bytes:" << broadcastBytes;
-    }
-    
-    // 2. 向常见热点网络段广播
-    QStringList hotspotPrefixes = {"192.168.43.", "172.20.", "192.168.137.", "192.168.1.", "192.168.0."};
-    for (const QString& prefix : hotspotPrefixes) {
-        if (localIP.startsWith(prefix)) {
-            // 向同网段的广播地址发送
-            QString broadcastAddr = prefix + "255";
-            qint64 bytes = udpSocket->writeDatagram(data, QHostAddress(broadcastAddr), DISCOVERY_PORT);
-            if (bytes > 0) {
-                successfulBroadcasts++;
-                qDebug() << "Segment broadcast to" << broadcastAddr << "successful, bytes:" << bytes;
-            }
-            break;
-        }
-    }
-    
-    qDebug() << "Broadcasting host info:" << currentRoomName << "on IP:" << localIP 
-             << "successful broadcasts:" << successfulBroadcasts << "data size:" << data.size();
+    const QByteArray data = QJsonDocument(hostInfo).toJson(QJsonDocument::Compact);
+    udpSocket->writeDatagram(data, discoveryGroupAddress(), DISCOVERY_PORT);
+    udpSocket->writeDatagram(data, QHostAddress::Broadcast, DISCOVERY_PORT);
     
-    if (successfulBroadcasts == 0) {
-        qWarning() << "All broadcast attempts failed, will retry in next interval";
+    qDebug() << "Announced host info:" << currentRoomName << "on IP:" << localIP;
+}
+
+void HotspotNetworkManager::onAnnounceTimeout()
+{
+    // 定期通告按指数退避逐渐稀疏，新客户端主要靠查询应答发现房间
+    broadcastHostInfo();
+    broadcastTimer->start(announceInterval);
+    announceInterval = qMin(announceInterval * 2, static_cast<int>(MAX_ANNOUNCE_INTERVAL));
+}
+
+void HotspotNetworkManager::restartAnnouncements()
+{
+    if (!isHosting() || !udpSocket) {
+        return;
     }
+    announceInterval = INITIAL_ANNOUNCE_INTERVAL;
+    scheduleResponse();
+    broadcastTimer->start(announceInterval);
+}
+
+void HotspotNetworkManager::scheduleResponse()
+{
+    // 随机延迟后应答，多个客户端同时查询、多个主机同时应答时错开发送；
+    // 延迟期间的查询合并为一次应答
+    if (!responseTimer->isActive()) {
+        responseTimer->start(QRandomGenerator::global()->bounded(MIN_RESPONSE_DELAY, MAX_RESPONSE_DELAY + 1));
+    }
+}
+
+QHostAddress HotspotNetworkManager::discoveryGroupAddress()
+{
+    return QHostAddress(QStringLiteral("239.255.43.21"));
+}
+
+bool HotspotNetworkManager::bindDiscoverySocket(quint16 port)
+{
+    // 同一台机器上的主机和客户端共享发现端口，都能收到组播
+    if (!udpSocket->bind(QHostAddress::AnyIPv4, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        return false;
+    }
+    if (!udpSocket->joinMulticastGroup(discoveryGroupAddress())) {
+        qWarning() << "Failed to join discovery multicast group, falling back to broadcast:" << udpSocket->errorString();
+    }
+    udpSocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);  // 只在本网段内传播
+    return true;
 }
 
 void HotspotNetworkManager::onUdpDataReceived()
@@ -683,13 +1089,7 @@ void HotspotNetworkManager::onUdpDataReceived()
         qDebug() << "Received UDP datagram" << processedCount << "from" << sender.toString() << ":" << senderPort 
                  << "size:" << bytesRead;
         
-        // 忽略来自自己的消息
-        QString localIP = getLocalIPAddress();
-        if (sender.toString() == localIP) {
-            qDebug() << "Ignoring message from self:" << sender.toString();
-            continue;
-        }
-        
+        // 自己发出的组播也会回环收到，按消息类型和当前角色过滤即可，不必逐个数据报查询本机地址
         QJsonParseError error;
         QJsonDocument doc = QJsonDocument::fromJson(datagram, &error);
         
@@ -720,6 +1120,9 @@ void HotspotNetworkManager::onUdpDataReceived()
             QString roomName = message["room_name"].toString();
             int playerCount = message["player_count"].toInt();
             int maxPlayers = message["max_players"].toInt();
+            // 旧版本主机不携带端口，使用默认端口
+            quint16 port = static_cast<quint16>(message["port"].toInt(DEFAULT_PORT));
+            quint16 statePort = static_cast<quint16>(message["state_port"].toInt(STATE_PORT));
             
             // 验证主机信息的有效性
             if (hostAddr.isEmpty() || roomName.isEmpty() || maxPlayers <= 0) {
@@ -730,13 +1133,11 @@ void HotspotNetworkManager::onUdpDataReceived()
             
             qDebug() << "Discovered valid host:" << roomName << "at" << hostAddr 
                      << "players:" << playerCount << "/" << maxPlayers;
-            emit hostDiscovered(hostAddr, roomName, playerCount, maxPlayers);
+            emit hostDiscovered(hostAddr, roomName, playerCount, maxPlayers, port, statePort);
             
         } else if (type == "discover_hosts" && isHosting()) {
-            qDebug() << "Received discovery request from" << sender.toString() 
-                     << ", responding with host info";
-            // 延迟响应，避免网络拥塞
-            QTimer::singleShot(100 + QRandomGenerator::global()->bounded(200), this, &HotspotNetworkManager::broadcastHostInfo);
+            qDebug() << "Received discovery request from" << sender.toString();
+            scheduleResponse();
             
         } else {
             qDebug() << "Ignoring UDP message type:" << type << "(isHosting:" << isHosting() << ")";
@@ -746,46 +1147,412 @@ void HotspotNetworkManager::onUdpDataReceived()
     qDebug() << "Processed" << processedCount << "UDP datagrams";
 }
 
-void HotspotNetworkManager::processMessage(const QJsonObject& message, QTcpSocket* sender)
+void HotspotNetworkManager::processMessage(const char* data, int size, QTcpSocket* sender)
 {
-    QString type = message["type"].toString();
+    using namespace HotspotProtocol;
     
-    if (type == "player_join") {
-        QString playerName = message["player_name"].toString();
-        if (sender && isHosting()) {
+    Reader reader(data, size);
+    quint8 opcode = 0;
+    if (!reader.readU8(opcode)) {
+        return;
+    }
+    
+    // 负载视图：直接引用接收缓冲区，不复制
+    const QByteArray payload = QByteArray::fromRawData(data + 1, size - 1);
+    
+    if (static_cast<Opcode>(opcode) == Opcode::Compressed) {
+        QByteArray message;
+        if (!decodeCompressed(payload, message) ||
+            static_cast<Opcode>(static_cast<quint8>(message.at(0))) == Opcode::Compressed) {
+            qWarning() << "Invalid compressed message dropped";
+            return;
+        }
+        processMessage(message.constData(), message.size(), sender);
+        return;
+    }
+    
+    if (sender && spectatorNames.contains(sender)) {
+        processSpectatorMessage(static_cast<Opcode>(opcode), reader, sender);
+        return;
+    }
+    
+    switch (static_cast<Opcode>(opcode)) {
+    case Opcode::PlayerJoin: {
+        quint8 version = 0;
+        QString playerName;
+        quint8 joinFlags = 0;
+        quint32 features = 0;
+        quint64 token = 0;
+        const bool decoded = decodePlayerJoin(reader, version, playerName, joinFlags, features, token);
+        if (!sender || !isHosting() || version == 0) {
+            break;
+        }
+        // 更早的版本字段布局不同，只读版本号就拒绝；更新的版本按本端版本通信
+        if (version < MIN_PROTOCOL_VERSION) {
+            qWarning() << "Rejecting player with protocol version" << version;
+            writeFrame(sender, encodeJoinRejected(RejectReason::VersionMismatch));
+            sender->disconnectFromHost();
+            break;
+        }
+        if (!decoded || clientPlayerNames.contains(sender)) {
+            break;
+        }
+        PeerProtocol protocol;
+        protocol.version = qMin(version, PROTOCOL_VERSION);
+        protocol.features = features & localFeatures;
+        peerProtocols[sender] = protocol;
+        qDebug() << "Negotiated protocol version" << protocol.version << "features" << protocol.features << "with" << playerName;
+        
+        if (joinFlags & JoinResume) {
+            if (token == 0 || sessionTokens.value(playerName) != token) {
+                writeFrame(sender, encodeJoinRejected(RejectReason::SessionExpired));
+                sender->disconnectFromHost();
+                break;
+            }
+            
+            // 主机可能还没察觉旧连接已断开，直接由新连接接替
+            QTcpSocket* oldSocket = playerSockets.value(playerName);
+            if (oldSocket) {
+                disconnect(oldSocket, nullptr, this, nullptr);
+                connectedClients.removeAll(oldSocket);
+                clientPlayerNames.remove(oldSocket);
+                receiveParsers.remove(oldSocket);
+                outboundQueues.remove(oldSocket);
+                peerProtocols.remove(oldSocket);
+                oldSocket->abort();
+                oldSocket->deleteLater();
+            }
+            suspendedSessions.remove(playerName);
+            scheduleSessionExpiry();
+            
             clientPlayerNames[sender] = playerName;
             playerSockets[playerName] = sender;
-            emit playerConnectedToHost(playerName);
+            stateEndpoints.remove(playerName);
+            peerLinks.remove(playerName);
+            queueFrame(sender, encodeJoinAccepted(token, protocol.version, protocol.features));
+            emit playerReconnected(playerName);
+            qDebug() << "Player resumed session:" << playerName;
+            break;
+        }
+        
+        const bool spectator = joinFlags & JoinAsSpectator;
+        const int playerSlots = dedicatedServer ? maxPlayers : maxPlayers - 1;
+        if (spectator ? spectatorNames.size() >= MAX_SPECTATORS
+                      : playerSockets.size() + suspendedSessions.size() >= playerSlots) {
+            writeFrame(sender, encodeJoinRejected(RejectReason::RoomFull));
+            sender->disconnectFromHost();
+            break;
+        }
+        if (!spectator && sessionTokens.contains(playerName)) {
+            writeFrame(sender, encodeJoinRejected(RejectReason::NameInUse));
+            sender->disconnectFromHost();
+            break;
+        }
+        if (spectator) {
+            spectatorNames[sender] = playerName;
+            queueFrame(sender, encodeJoinAccepted(0, protocol.version, protocol.features));
+            emit spectatorJoined(playerName);
+            qDebug() << "Spectator joined:" << playerName;
+            break;
+        }
+        
+        // 令牌取自系统随机源，其他玩家无法猜出并冒用断线玩家的位置
+        token = 0;
+        while (token == 0) {
+            token = QRandomGenerator::system()->generate64();
         }
-    } else if (type == "player_leave") {
-        QString playerName = message["player_name"].toString();
+        sessionTokens[playerName] = token;
+        
+        clientPlayerNames[sender] = playerName;
+        playerSockets[playerName] = sender;
+        queueFrame(sender, encodeJoinAccepted(token, protocol.version, protocol.features));
+        emit playerConnectedToHost(playerName);
+        restartAnnouncements();
+        break;
+    }
+    case Opcode::PlayerLeave: {
         if (sender && isHosting()) {
             // 标记为优雅离开，避免显示连接错误
             QString socketPlayerName = clientPlayerNames.value(sender);
             if (!socketPlayerName.isEmpty()) {
                 clientPlayerNames.remove(sender);
                 playerSockets.remove(socketPlayerName);
+                stateEndpoints.remove(socketPlayerName);
+                peerLinks.remove(socketPlayerName);
+                sessionTokens.remove(socketPlayerName);
                 connectedClients.removeOne(sender);
                 emit playerDisconnectedFromHost(socketPlayerName);
+                restartAnnouncements();
                 
-                // 优雅关闭连接
+                // 优雅关闭连接：不等待未发完的数据，同一线程上还有其他房间在运行；
+                // 断开后由onClientDisconnected回收队列和解析器并释放socket
                 sender->disconnectFromHost();
-                if (sender->state() != QAbstractSocket::UnconnectedState) {
-                    sender->waitForDisconnected(1000);
-                }
             }
         }
-    } else if (type == "player_data") {
-        QString playerName = message["player_name"].toString();
-        QJsonObject playerData = message["data"].toObject();
-        emit playerDataReceived(playerName, playerData);
-    } else if (type == "game_state") {
-        QJsonObject gameState = message["state"].toObject();
-        emit gameStateReceived(gameState);
-    } else if (type == "chat_message") {
-        QString playerName = message["player_name"].toString();
-        QString chatMessage = message["message"].toString();
-        emit chatMessageReceived(playerName, chatMessage);
+        break;
+    }
+    case Opcode::PlayerUpdate: {
+        QString playerName;
+        PlayerUpdate update;
+        if (!sender || !decodePlayerUpdate(reader, playerName, update)) {
+            break;
+        }
+        // 消息里的名字由客户端填写，与PlayerInput一样以连接对应的玩家为准，不能替别人改方向或角色
+        const QString socketPlayerName = clientPlayerNames.value(sender);
+        if (socketPlayerName.isEmpty() || socketPlayerName != playerName) {
+            qWarning() << "Dropping player update for" << playerName << "from connection of"
+                       << (socketPlayerName.isEmpty() ? QString("unjoined client") : socketPlayerName);
+            break;
+        }
+        emit playerUpdateReceived(socketPlayerName, update);
+        break;
+    }
+    case Opcode::JoinRejected: {
+        quint8 reason = 0;
+        if (reader.readU8(reason)) {
+            // 恢复被拒绝时不再重连，主机随后关闭连接，按普通断开处理
+            reconnectTimer->stop();
+            sessionToken = 0;
+            emit networkError(rejectReasonText(static_cast<RejectReason>(reason)));
+        }
+        break;
+    }
+    case Opcode::JoinAccepted: {
+        quint64 token = 0;
+        PeerProtocol protocol;
+        if (isHosting() || !tcpClient || !decodeJoinAccepted(reader, token, protocol.version, protocol.features)) {
+            break;
+        }
+        // 主机已按双方共同支持的特性裁剪过，这里再与本端取交集，兼容不做裁剪的旧主机
+        protocol.features &= localFeatures;
+        peerProtocols[tcpClient] = protocol;
+        qDebug() << "Negotiated protocol version" << protocol.version << "features" << protocol.features;
+        sessionToken = token;
+        if (isReconnecting()) {
+            reconnectTimer->stop();
+            emit sessionResumed();
+            qDebug() << "Session resumed";
+        }
+        break;
+    }
+    case Opcode::Roster:
+        emit rosterReceived(payload);
+        break;
+    case Opcode::ChatMessage: {
+        QString playerName;
+        QString chatMessage;
+        if (decodeChatMessage(reader, playerName, chatMessage)) {
+            emit chatMessageReceived(playerName, chatMessage);
+        }
+        break;
+    }
+    case Opcode::KeyframeRequest: {
+        const QString playerName = clientPlayerNames.value(sender);
+        if (sender && !playerName.isEmpty()) {
+            emit keyframeRequested(playerName);
+        }
+        break;
+    }
+    case Opcode::LockstepStart: {
+        // 锁步消息必须按顺序送达，只走TCP
+        quint32 tick = 0;
+        quint64 randomState = 0;
+        if (decodeLockstepStart(reader, tick, randomState)) {
+            emit lockstepStartReceived(tick, randomState);
+        }
+        break;
+    }
+    case Opcode::InputBundle:
+        emit inputBundleReceived(payload);
+        break;
+    default:
+        // 状态通道不可用时，快照和输入也会经TCP到达
+        if (!processStateMessage(static_cast<Opcode>(opcode), reader, payload, clientPlayerNames.value(sender))) {
+            qWarning() << "Unknown message opcode:" << opcode;
+        }
+        break;
+    }
+}
+
+void HotspotNetworkManager::onStateDataReceived()
+{
+    if (!stateSocket) {
+        return;
+    }
+    
+    while (stateSocket && stateSocket->hasPendingDatagrams()) {
+        const qint64 pendingSize = stateSocket->pendingDatagramSize();
+        datagramBuffer.resize(static_cast<int>(qMax<qint64>(pendingSize, 1)));
+        
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        const qint64 bytesRead = stateSocket->readDatagram(datagramBuffer.data(), datagramBuffer.size(),
+                                                           &sender, &senderPort);
+        if (bytesRead <= 0) {
+            continue;
+        }
+        traffic.udpBytesReceived += static_cast<quint64>(bytesRead);
+        processDatagram(datagramBuffer.constData(), static_cast<int>(bytesRead), sender, senderPort);
+    }
+}
+
+void HotspotNetworkManager::processDatagram(const char* data, int size, const QHostAddress& sender, quint16 senderPort)
+{
+    using namespace HotspotProtocol;
+    
+    Reader reader(data, size);
+    quint8 value = 0;
+    if (!reader.readU8(value)) {
+        return;
+    }
+    const Opcode opcode = static_cast<Opcode>(value);
+    const QByteArray payload = QByteArray::fromRawData(data + 1, size - 1);
+    
+    if (isHosting()) {
+        if (opcode == Opcode::StateHello) {
+            // 只接受与该玩家TCP连接来自同一地址的登记，防止冒名顶替
+            QString playerName;
+            if (!reader.readString(playerName)) {
+                return;
+            }
+            QTcpSocket* socket = playerSockets.value(playerName);
+            if (!socket || !socket->peerAddress().isEqual(sender, QHostAddress::TolerantConversion) ||
+                !(peerProtocols.value(socket).features & FeatureStateChannel)) {
+                return;
+            }
+            
+            StateEndpoint& endpoint = stateEndpoints[playerName];
+            if (endpoint.port != senderPort || endpoint.address != sender) {
+                qDebug() << "State channel registered for" << playerName << "at" << sender.toString() << ":" << senderPort;
+            }
+            endpoint.address = sender;
+            endpoint.port = senderPort;
+            stateSocket->writeDatagram(data, size, sender, senderPort);
+            return;
+        }
+        
+        // 其余数据报按登记的地址找到玩家，未登记的来源直接丢弃
+        for (auto it = stateEndpoints.constBegin(); it != stateEndpoints.constEnd(); ++it) {
+            if (it->port == senderPort && it->address == sender) {
+                processStateMessage(opcode, reader, payload, it.key());
+                return;
+            }
+        }
+        return;
+    }
+    
+    // 客户端只接受来自所连主机的数据报
+    if (!isConnectedToHost() || !tcpClient->peerAddress().isEqual(sender, QHostAddress::TolerantConversion)) {
+        return;
+    }
+    
+    if (opcode == Opcode::StateHello) {
+        if (!stateChannelReady) {
+            qDebug() << "State channel to host is ready";
+        }
+        stateChannelReady = true;
+        return;
+    }
+    processStateMessage(opcode, reader, payload, QString());
+}
+
+void HotspotNetworkManager::processSpectatorMessage(HotspotProtocol::Opcode opcode, HotspotProtocol::Reader& reader,
+                                                    QTcpSocket* sender)
+{
+    using namespace HotspotProtocol;
+    
+    // 观战者不能影响游戏，只处理心跳和离开
+    switch (opcode) {
+    case Opcode::Heartbeat: {
+        quint32 sequence = 0;
+        quint32 timestamp = 0;
+        if (decodeHeartbeat(reader, sequence, timestamp)) {
+            queueFrame(sender, encodeHeartbeatReply(sequence, timestamp));
+        }
+        break;
+    }
+    case Opcode::PlayerLeave:
+        sender->disconnectFromHost();
+        break;
+    default:
+        break;
+    }
+}
+
+void HotspotNetworkManager::removeSpectator(QTcpSocket* socket)
+{
+    auto it = spectatorNames.find(socket);
+    if (it == spectatorNames.end()) {
+        return;
+    }
+    const QString spectatorName = it.value();
+    spectatorNames.erase(it);
+    emit spectatorLeft(spectatorName);
+    qDebug() << "Spectator left:" << spectatorName;
+}
+
+bool HotspotNetworkManager::processStateMessage(HotspotProtocol::Opcode opcode, HotspotProtocol::Reader& reader,
+                                                const QByteArray& payload, const QString& playerName)
+{
+    using namespace HotspotProtocol;
+    
+    switch (opcode) {
+    case Opcode::GameState:
+        emit gameStateReceived(payload);
+        return true;
+    case Opcode::PlayerDirection: {
+        int playerId = 0;
+        Direction direction = Direction::RIGHT;
+        if (decodePlayerDirection(reader, playerId, direction)) {
+            emit playerDirectionReceived(playerId, direction);
+        }
+        return true;
+    }
+    case Opcode::SnapshotAck: {
+        quint32 sequence = 0;
+        if (!playerName.isEmpty() && reader.readVarUInt(sequence)) {
+            emit snapshotAckReceived(playerName, sequence);
+        }
+        return true;
+    }
+    case Opcode::PlayerInput: {
+        QList<PlayerInput> inputs;
+        if (!playerName.isEmpty() && decodePlayerInput(reader, inputs)) {
+            emit playerInputReceived(playerName, inputs);
+        }
+        return true;
+    }
+    case Opcode::InputAck: {
+        quint32 sequence = 0;
+        if (reader.readVarUInt(sequence)) {
+            emit inputAckReceived(sequence);
+        }
+        return true;
+    }
+    case Opcode::Heartbeat: {
+        // 收到心跳立即沿原通道回复，不等待下一帧
+        quint32 sequence = 0;
+        quint32 timestamp = 0;
+        if (decodeHeartbeat(reader, sequence, timestamp)) {
+            const QByteArray reply = encodeHeartbeatReply(sequence, timestamp);
+            if (playerName.isEmpty()) {
+                sendStateToHost(reply);
+            } else {
+                sendStateToPlayer(playerName, reply);
+            }
+        }
+        return true;
+    }
+    case Opcode::HeartbeatReply: {
+        quint32 sequence = 0;
+        quint32 timestamp = 0;
+        if (decodeHeartbeat(reader, sequence, timestamp)) {
+            recordHeartbeatReply(playerName, sequence, timestamp);
+        }
+        return true;
+    }
+    default:
+        return false;
     }
 }
 
@@ -804,6 +1571,70 @@ QJsonObject HotspotNetworkManager::createMessage(const QString& type, const QJso
     return message;
 }
 
+void HotspotNetworkManager::onReconnectTimeout()
+{
+    if (linkClock.elapsed() >= reconnectDeadline) {
+        // 宽限期已过，主机也已放弃这个位置
+        qDebug() << "Could not resume session within grace period";
+        reconnectTimer->stop();
+        sessionToken = 0;
+        discardClientSocket();
+        closeStateChannel();
+        heartbeatTimer->stop();
+        peerLinks.clear();
+        localPlayerName.clear();
+        hostPort = DEFAULT_PORT;
+        hostStatePort = STATE_PORT;
+        emit disconnectedFromHost();
+        return;
+    }
+    
+    // 已连上，等待主机确认
+    if (isConnectedToHost()) {
+        return;
+    }
+    
+    // 上一次尝试还没连上（热点切换期间SYN可能被丢弃），重新发起连接
+    discardClientSocket();
+    openClientSocket();
+}
+
+void HotspotNetworkManager::onSessionExpiryTimeout()
+{
+    const qint64 now = linkClock.elapsed();
+    QStringList expired;
+    for (auto it = suspendedSessions.constBegin(); it != suspendedSessions.constEnd(); ++it) {
+        if (it.value() <= now) {
+            expired.append(it.key());
+        }
+    }
+    
+    for (const QString& playerName : expired) {
+        suspendedSessions.remove(playerName);
+        sessionTokens.remove(playerName);
+        emit playerDisconnectedFromHost(playerName);
+        qDebug() << "Player session expired:" << playerName;
+    }
+    if (!expired.isEmpty()) {
+        restartAnnouncements();
+    }
+    scheduleSessionExpiry();
+}
+
+void HotspotNetworkManager::scheduleSessionExpiry()
+{
+    if (suspendedSessions.isEmpty()) {
+        sessionTimer->stop();
+        return;
+    }
+    
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (qint64 deadline : suspendedSessions) {
+        earliest = qMin(earliest, deadline);
+    }
+    sessionTimer->start(static_cast<int>(qMax<qint64>(0, earliest - linkClock.elapsed())));
+}
+
 void HotspotNetworkManager::setupHeartbeat()
 {
     heartbeatTimer->start(HEARTBEAT_INTERVAL);
@@ -814,10 +1645,16 @@ void HotspotNetworkManager::cleanupDisconnectedClients()
     for (int i = connectedClients.size() - 1; i >= 0; --i) {
         QTcpSocket* client = connectedClients[i];
         if (client->state() != QAbstractSocket::ConnectedState) {
+            removeSpectator(client);
             QString playerName = clientPlayerNames.value(client);
             connectedClients.removeAt(i);
             clientPlayerNames.remove(client);
             playerSockets.remove(playerName);
+            stateEndpoints.remove(playerName);
+            peerLinks.remove(playerName);
+            receiveParsers.remove(client);
+            outboundQueues.remove(client);
+            peerProtocols.remove(client);
             client->deleteLater();
         }
     }
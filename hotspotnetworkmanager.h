@@ -10,17 +10,24 @@
 #include <QJsonDocument>
 #include <QNetworkInterface>
 #include <QHostAddress>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 #include <deque>
 #include "gamestate.h"
+#include "hotspotprotocol.h"
 
 /**
  * 热点共享网络管理器
  * 专为热点网络环境优化的多人联机解决方案
  * 特点：
- * 1. 自动发现热点网络内的主机
+ * 1. 自动发现热点网络内的主机：组播查询/通告，按指数退避重发，主机随机延迟后应答
  * 2. 简化的连接建立流程
  * 3. 优化的数据同步协议
  * 4. 更好的网络稳定性
+ * 5. TCP消息先进入每个连接的发送队列，同一轮事件循环内产生的消息合并为一次写入；
+ *    慢速连接积压时只保留最新的快照，不影响其他连接
+ * 6. 观战者不占玩家名额，只走TCP接收名单和共享的低频关键帧，积压时同样只保留最新快照
+ * 7. 玩家连接意外断开后保留 SESSION_GRACE_PERIOD 的位置，客户端在此期间自动重连并凭会话令牌恢复
  */
 class HotspotNetworkManager : public QObject
 {
@@ -35,44 +42,117 @@ public:
     void stopHotspotHost();
     bool isHosting() const;
     
+    // 专用服务器：不要求处于热点网络，主机本身不占玩家名额；须在startHotspotHost之前设置
+    void setDedicatedServer(bool dedicated) { dedicatedServer = dedicated; }
+    bool isDedicatedServer() const { return dedicatedServer; }
+    
+    // 一个进程内有多个房间时各房间监听不同端口，房间广播改由服务器统一负责；须在startHotspotHost之前设置
+    void setHostPorts(quint16 tcpPort, quint16 statePort) { hostPort = tcpPort; hostStatePort = statePort; }
+    void setDiscoveryEnabled(bool enabled) { discoveryEnabled = enabled; }
+    
     // 热点客户端功能
     void startHostDiscovery();
     void stopHostDiscovery();
-    bool connectToHost(const QString& hostAddress);
+    bool connectToHost(const QString& hostAddress, quint16 port = DEFAULT_PORT, quint16 statePort = STATE_PORT);
     void disconnectFromHost();
     bool isConnectedToHost() const;
+    bool isReconnecting() const { return reconnectTimer->isActive(); }  // 客户端：断线后正在恢复会话
     
-    // 游戏数据同步
-    void sendPlayerData(const QString& playerName, const QJsonObject& playerData);
-    void sendGameState(const QJsonObject& gameState);
+    // 游戏数据同步（二进制协议，消息格式见 hotspotprotocol.h）
+    void sendPlayerJoin(const QString& playerName, bool spectator = false);
+    void sendPlayerLeave(const QString& playerName);
+    void sendPlayerUpdate(const QString& playerName, const HotspotProtocol::PlayerUpdate& update);
     void sendChatMessage(const QString& playerName, const QString& message);
-    void sendMessage(const QString& type, const QJsonObject& data = QJsonObject());
-    void broadcastToClients(const QJsonObject& message);
+    void sendToHost(const QByteArray& message);
+    void sendToPlayer(const QString& playerName, const QByteArray& message);
+    void broadcastToClients(const QByteArray& message);      // 只发给玩家（含尚未加入的连接），不发给观战者
+    void broadcastToSpectators(const QByteArray& message);   // 快照消息在积压时可被更新的快照取代
+    
+    // 状态通道：快照、方向输入及其确认走UDP，避免一个丢包阻塞后面所有快照
+    // 通道尚未建立或消息超过 MAX_DATAGRAM_SIZE 时自动改走TCP
+    void sendStateToHost(const QByteArray& message);
+    void sendStateToPlayer(const QString& playerName, const QByteArray& message);
+    void broadcastState(const QByteArray& message);
     
     // 房间信息
     QString getRoomName() const { return currentRoomName; }
     int getConnectedPlayersCount() const;
     QStringList getConnectedPlayerNames() const;
+    int getSpectatorCount() const { return spectatorNames.size(); }
+    bool isSessionSuspended(const QString& playerName) const { return suspendedSessions.contains(playerName); }  // 主机：玩家断线，处于宽限期
+    qint64 getPendingBytes(const QString& playerName) const;  // 主机：该玩家发送队列和TCP连接中尚未写出的字节数
     
     // 网络状态
     QString getLocalIPAddress() const;
     bool isInHotspotNetwork() const;
     
+    // 链路质量：心跳带时间戳往返测量，按最近 PING_WINDOW_SIZE 次心跳统计
+    struct LinkStats {
+        int rtt = -1;         // 平均往返时间(ms)，-1表示还没有样本
+        int jitter = 0;       // 相邻两次往返时间之差的平均值(ms)
+        int lossPercent = 0;  // 超时未回复的心跳比例
+        int samples = 0;      // 已回复或已超时的心跳数
+    };
+    LinkStats getLinkStats(const QString& playerName = QString()) const;  // 主机按玩家名查询，客户端查询到主机的链路
+    
+    // 累计流量：只统计游戏消息（TCP发送队列写出和读入的字节、状态通道数据报），不含发现广播和协议头
+    struct TrafficStats {
+        quint64 tcpBytesSent = 0;
+        quint64 tcpBytesReceived = 0;
+        quint64 udpBytesSent = 0;
+        quint64 udpBytesReceived = 0;
+    };
+    TrafficStats getTrafficStats() const { return traffic; }
+    
+    // 加入时协商出的协议版本和特性，主机按玩家名查询，客户端查询与主机的协商结果；尚未协商时version为0
+    struct PeerProtocol {
+        quint8 version = 0;
+        quint32 features = 0;
+    };
+    PeerProtocol getPeerProtocol(const QString& playerName = QString()) const;
+    // 本端愿意使用的特性（HotspotProtocol::Feature），默认全部；须在建房或加入前设置，用于对比测试或排查某个特性
+    void setLocalFeatures(quint32 features) { localFeatures = features; }
+    quint32 getLocalFeatures() const { return localFeatures; }
+    
+    // 发现使用的组播组（本地管理范围），组播被过滤的热点上同时发送子网广播
+    static QHostAddress discoveryGroupAddress();
+    
+    // 默认端口；发现消息中携带房间实际使用的端口
+    static const quint16 DEFAULT_PORT = 23456;
+    static const quint16 DISCOVERY_PORT = 23457;
+    static const quint16 STATE_PORT = 23460;     // 状态通道端口，避开发现端口绑定失败时尝试的备用端口
+    
 signals:
     // 主机相关信号
     void hostStarted(const QString& roomName, const QString& ipAddress);
     void hostStopped();
     void playerConnectedToHost(const QString& playerName);
-    void playerDisconnectedFromHost(const QString& playerName);
+    void playerDisconnectedFromHost(const QString& playerName);   // 主动离开，或断线后宽限期内没有重连
+    void playerConnectionLost(const QString& playerName);         // 连接意外断开，玩家仍留在房间中等待重连
+    void playerReconnected(const QString& playerName);            // 宽限期内凭令牌恢复，需要重新同步
+    void spectatorJoined(const QString& spectatorName);
+    void spectatorLeft(const QString& spectatorName);
     
     // 客户端相关信号
-    void hostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers);
+    void hostDiscovered(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers,
+                        quint16 port, quint16 statePort);
     void connectedToHost(const QString& hostAddress);
     void disconnectedFromHost();
+    void connectionInterrupted();   // 连接意外断开，开始自动重连；失败时再发出disconnectedFromHost
+    void sessionResumed();          // 重连后主机接受了会话令牌
     
     // 数据接收信号
-    void playerDataReceived(const QString& playerName, const QJsonObject& playerData);
-    void gameStateReceived(const QJsonObject& gameState);
+    // rosterReceived/gameStateReceived/inputBundleReceived 的负载直接引用接收缓冲区，只在信号处理期间有效
+    void playerUpdateReceived(const QString& playerName, const HotspotProtocol::PlayerUpdate& update);
+    void rosterReceived(const QByteArray& payload);
+    void gameStateReceived(const QByteArray& payload);
+    void playerDirectionReceived(int playerId, Direction direction);
+    void snapshotAckReceived(const QString& playerName, quint32 sequence);
+    void playerInputReceived(const QString& playerName, const QList<HotspotProtocol::PlayerInput>& inputs);
+    void inputAckReceived(quint32 sequence);
+    void lockstepStartReceived(quint32 tick, quint64 randomState);
+    void inputBundleReceived(const QByteArray& payload);
+    void keyframeRequested(const QString& playerName);
     void chatMessageReceived(const QString& playerName, const QString& message);
     
     // 错误信号
@@ -88,12 +168,37 @@ private slots:
     void onHeartbeatTimeout();
     void processHostDiscovery();
     void broadcastHostInfo();
+    void onAnnounceTimeout();
     void onUdpDataReceived();
+    void onStateDataReceived();
+    void flushOutboundQueues();
+    void onReconnectTimeout();
+    void onSessionExpiryTimeout();
     
 private:
-    void processMessage(const QJsonObject& message, QTcpSocket* sender = nullptr);
-    QJsonObject createMessage(const QString& type, const QJsonObject& data = QJsonObject());
+    void processMessage(const char* data, int size, QTcpSocket* sender = nullptr);
+    void processSpectatorMessage(HotspotProtocol::Opcode opcode, HotspotProtocol::Reader& reader, QTcpSocket* sender);
+    void removeSpectator(QTcpSocket* socket);
+    void processDatagram(const char* data, int size, const QHostAddress& sender, quint16 senderPort);
+    bool processStateMessage(HotspotProtocol::Opcode opcode, HotspotProtocol::Reader& reader,
+                             const QByteArray& payload, const QString& playerName);
+    bool openStateChannel(quint16 port);
+    void closeStateChannel();
+    void sendStateHello();
+    void sendHeartbeat(const QString& playerName);
+    void recordHeartbeatReply(const QString& playerName, quint32 sequence, quint32 timestamp);
+    void writeFrame(QTcpSocket* socket, const QByteArray& message);   // 立即写入，只用于断开前的拒绝消息
+    void queueFrame(QTcpSocket* socket, const QByteArray& message, bool replaceableSnapshot = false);
+    QByteArray compressForPeer(QTcpSocket* socket, const QByteArray& message);  // 对端协商了压缩且消息足够大时返回压缩后的消息
+    void prepareSocket(QTcpSocket* socket);
+    void openClientSocket();
+    void discardClientSocket();
+    void scheduleSessionExpiry();
+    QJsonObject createMessage(const QString& type, const QJsonObject& data = QJsonObject());  // UDP发现消息
     void setupHeartbeat();
+    bool bindDiscoverySocket(quint16 port);
+    void restartAnnouncements();   // 开房或人数变化时尽快通告，并重置退避
+    void scheduleResponse();
     void cleanupDisconnectedClients();
     QString detectHotspotNetwork();
     bool isValidHotspotIP(const QString& ipAddress) const;
@@ -102,29 +207,97 @@ private:
     QTcpServer* tcpServer;
     QTcpSocket* tcpClient;
     QUdpSocket* udpSocket;
+    QUdpSocket* stateSocket;  // 状态通道，与发现用的udpSocket分开，避免广播消息混入
     
     // 定时器
     QTimer* discoveryTimer;
     QTimer* heartbeatTimer;
-    QTimer* broadcastTimer;
+    QTimer* broadcastTimer;   // 主机：定期通告，间隔指数增长
+    QTimer* responseTimer;    // 主机：查询应答的随机延迟
     
     // 连接管理
     QList<QTcpSocket*> connectedClients;
     QMap<QTcpSocket*, QString> clientPlayerNames;
     QMap<QString, QTcpSocket*> playerSockets;
+    QMap<QTcpSocket*, QString> spectatorNames;   // 观战连接，也在connectedClients中
+    QMap<QTcpSocket*, QSharedPointer<HotspotProtocol::FrameParser>> receiveParsers;  // 每个连接的分帧解析器
+    
+    // 发送队列：已分帧、等待下一次合并写入的数据
+    struct OutboundQueue {
+        QByteArray data;
+        int snapshotOffset = -1;  // 队列中可被更新快照替换的帧位置，-1表示没有
+        int snapshotSize = 0;
+    };
+    QMap<QTcpSocket*, OutboundQueue> outboundQueues;
+    QTimer* flushTimer;  // 单次0ms定时器：本轮事件处理产生的消息全部入队后统一写出
+    
+    // 协议协商
+    QMap<QTcpSocket*, PeerProtocol> peerProtocols;  // 主机：每个连接；客户端：到主机的连接
+    quint32 localFeatures;
+    QByteArray compressionSource;   // 最近一次压缩的原消息，广播时同一条消息只压缩一次
+    QByteArray compressionResult;
+    
+    // 会话恢复
+    QMap<QString, quint64> sessionTokens;       // 主机：房间内玩家（含断线的）的会话令牌
+    QMap<QString, qint64> suspendedSessions;    // 主机：断线玩家的宽限期截止时间（linkClock毫秒数）
+    QTimer* sessionTimer;                       // 主机：最早一个宽限期到期时触发
+    quint64 sessionToken;                       // 客户端：主机下发的令牌，0表示没有可恢复的会话
+    QTimer* reconnectTimer;                     // 客户端：断线后定期重连，直到主机确认或宽限期结束
+    qint64 reconnectDeadline;
+    
+    // 发现退避
+    int queryInterval;     // 客户端：下一次查询的间隔(ms)
+    int announceInterval;  // 主机：下一次定期通告的间隔(ms)
+    
+    // 状态通道
+    struct StateEndpoint {
+        QHostAddress address;
+        quint16 port = 0;
+    };
+    QMap<QString, StateEndpoint> stateEndpoints;  // 主机：各玩家登记的UDP地址
+    QString localPlayerName;                      // 客户端：登记状态通道时使用
+    bool stateChannelReady;                       // 客户端：收到主机回复后才改走UDP
+    QByteArray datagramBuffer;
+    
+    // 链路测量
+    struct PingRecord {
+        quint32 sequence = 0;
+        qint64 sentTime = 0;
+        int rtt = -1;  // -1表示尚未回复
+    };
+    struct PeerLink {
+        quint32 nextSequence = 1;
+        std::deque<PingRecord> pings;  // 最近 PING_WINDOW_SIZE 次心跳
+    };
+    QMap<QString, PeerLink> peerLinks;  // 主机：按玩家名；客户端：空名字对应主机
+    QElapsedTimer linkClock;            // 心跳时间戳使用的单调时钟
+    TrafficStats traffic;
     
     // 房间状态
     QString currentRoomName;
     QString hostAddress;
     int maxPlayers;
     bool isHost;
+    bool dedicatedServer;
+    bool discoveryEnabled;
+    quint16 hostPort;       // 主机：监听端口；客户端：所连主机的端口
+    quint16 hostStatePort;  // 主机：状态通道端口；客户端：主机的状态通道端口
     
     // 网络配置 - 优化网络参数以减少延迟
-    static const quint16 DEFAULT_PORT = 23456;
-    static const quint16 DISCOVERY_PORT = 23457;
-    static const int HEARTBEAT_INTERVAL = 1500;  // 优化：缩短心跳间隔到1.5秒
-    static const int DISCOVERY_INTERVAL = 1000;  // 优化：缩短发现间隔到1秒
-    static const int BROADCAST_INTERVAL = 500;   // 优化：缩短广播间隔到0.5秒
+    static const int HEARTBEAT_INTERVAL = 500;   // 心跳兼作往返测量，0.5秒一次保证统计窗口内有足够样本
+    static const int INITIAL_QUERY_INTERVAL = 500;      // 首次查询之后的重发间隔(ms)，每次翻倍
+    static const int MAX_QUERY_INTERVAL = 8000;
+    static const int INITIAL_ANNOUNCE_INTERVAL = 1000;  // 开房或人数变化后的通告间隔(ms)，每次翻倍
+    static const int MAX_ANNOUNCE_INTERVAL = 16000;
+    static const int MIN_RESPONSE_DELAY = 20;           // 查询应答的随机延迟范围(ms)
+    static const int MAX_RESPONSE_DELAY = 150;
+    static const int PING_WINDOW_SIZE = 20;      // 统计最近20次心跳（约10秒）
+    static const int PING_TIMEOUT = 2000;        // 超过2秒未回复的心跳计为丢失
+    static const int MAX_SOCKET_BACKLOG = 16 * 1024;     // 套接字积压超过16KB时暂停写入，队列中的快照只保留最新一个
+    static const int MAX_QUEUED_BYTES = 1024 * 1024;     // 单个连接的发送队列上限，超过说明对端已停止接收，断开连接
+    static const int MAX_SPECTATORS = 32;                // 每个房间的观战者上限
+    static const int SESSION_GRACE_PERIOD = 10000;       // 断线玩家保留位置的时间(ms)，蛇在此期间照常前进
+    static const int RECONNECT_INTERVAL = 1000;          // 客户端重连尝试间隔(ms)
 };
 
 #endif // HOTSPOTNETWORKMANAGER_H
\ No newline at end of file
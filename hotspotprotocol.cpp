@@ -0,0 +1,1001 @@
+#include "hotspotprotocol.h"
+#include "hotspotgamemanager.h"
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+
+namespace HotspotProtocol {
+
+namespace {
+
+// 快照标志位
+const quint8 STATE_PAUSED = 0x01;
+const quint8 STATE_STARTED = 0x02;
+const quint8 STATE_SPECIAL_FOOD = 0x04;
+const quint8 STATE_HAS_WINNER = 0x08;
+
+// 玩家状态字节：低两位为方向，第三位为存活
+const quint8 PLAYER_ALIVE = 0x04;
+const quint8 PLAYER_DIRECTION_MASK = 0x03;
+
+// 蛇身位移编码：(dx+1)*3+(dy+1)，超出相邻范围时写入转义字节后跟两个varint
+const quint8 STEP_ESCAPE = 0xFF;
+
+// 每个玩家蛇身的编码方式
+const quint8 SNAKE_FULL = 0;
+const quint8 SNAKE_DELTA = 1;
+
+const int MAX_STRING_BYTES = 1024;
+const int MAX_PLAYERS = 255;
+
+void beginMessage(QByteArray& out, Opcode opcode)
+{
+    out.resize(0);
+    out.append(static_cast<char>(opcode));
+}
+
+const QString* playerNameForId(const HotspotGameState& state, int playerId)
+{
+    for (auto it = state.playerIds.constBegin(); it != state.playerIds.constEnd(); ++it) {
+        if (it.value() == playerId) {
+            return &it.key();
+        }
+    }
+    return nullptr;
+}
+
+// 相邻两节之间的位移
+void writeStep(Writer& writer, const Point& from, const Point& to)
+{
+    const int dx = to.x - from.x;
+    const int dy = to.y - from.y;
+    if (qAbs(dx) <= 1 && qAbs(dy) <= 1) {
+        writer.writeU8(static_cast<quint8>((dx + 1) * 3 + (dy + 1)));
+    } else {
+        writer.writeU8(STEP_ESCAPE);
+        writer.writeVarInt(dx);
+        writer.writeVarInt(dy);
+    }
+}
+
+bool readStep(Reader& reader, Point& current)
+{
+    quint8 step = 0;
+    if (!reader.readU8(step)) {
+        return false;
+    }
+    if (step == STEP_ESCAPE) {
+        qint32 dx = 0;
+        qint32 dy = 0;
+        if (!reader.readVarInt(dx) || !reader.readVarInt(dy)) {
+            return false;
+        }
+        current.x += dx;
+        current.y += dy;
+        return true;
+    }
+    if (step >= 9) {
+        return false;
+    }
+    current.x += step / 3 - 1;
+    current.y += step % 3 - 1;
+    return true;
+}
+
+void encodeFullSnake(Writer& writer, const std::deque<Point>& snake)
+{
+    writer.writeVarUInt(static_cast<quint32>(snake.size()));
+    if (snake.empty()) {
+        return;
+    }
+
+    writer.writePoint(snake.front());
+    for (size_t i = 1; i < snake.size(); ++i) {
+        writeStep(writer, snake[i - 1], snake[i]);
+    }
+}
+
+// target为空时只消费字节（名单中尚未出现的玩家）
+bool decodeFullSnake(Reader& reader, std::deque<Point>* target)
+{
+    quint32 length = 0;
+    if (!reader.readVarUInt(length)) {
+        return false;
+    }
+    // 每节至少占一个字节，长度不可能超过剩余数据
+    if (length > static_cast<quint32>(reader.remaining())) {
+        return false;
+    }
+
+    if (target) {
+        // resize而不是clear+push_back，蛇长变化不大时复用已有的存储块
+        target->resize(length);
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    Point current;
+    if (!reader.readPoint(current)) {
+        return false;
+    }
+    if (target) {
+        (*target)[0] = current;
+    }
+
+    for (quint32 i = 1; i < length; ++i) {
+        if (!readStep(reader, current)) {
+            return false;
+        }
+        if (target) {
+            (*target)[i] = current;
+        }
+    }
+    return true;
+}
+
+/**
+ * 计算当前蛇身相对基线新增的蛇头数量
+ * 蛇每个tick在头部加一节、尾部减一节（吃到食物时尾部多留一节），
+ * 所以当前蛇身去掉新增的蛇头后，与基线蛇身从头开始逐节相同
+ */
+int findNewHeadCount(const std::deque<Point>& current, const std::deque<Point>& base)
+{
+    if (current.empty() || base.empty()) {
+        return -1;
+    }
+
+    const int maxHeads = qMin(static_cast<int>(current.size()) - 1, MAX_DELTA_HEADS);
+    for (int heads = 0; heads <= maxHeads; ++heads) {
+        if (current[heads] != base.front()) {
+            continue;
+        }
+        const size_t overlap = qMin(base.size(), current.size() - heads);
+        if (std::equal(base.begin(), base.begin() + overlap, current.begin() + heads)) {
+            return heads;
+        }
+    }
+    return -1;
+}
+
+// 增量：新增蛇头数、尾部长度变化，以及对应的位移
+void encodeSnakeDelta(Writer& writer, const std::deque<Point>& current, const std::deque<Point>& base, int heads)
+{
+    const int tailChange = static_cast<int>(current.size()) - heads - static_cast<int>(base.size());
+    writer.writeVarUInt(static_cast<quint32>(heads));
+    writer.writeVarInt(tailChange);
+
+    // 新蛇头从紧挨基线蛇头的一节开始，向当前蛇头方向编码
+    for (int i = heads - 1; i >= 0; --i) {
+        writeStep(writer, current[i + 1], current[i]);
+    }
+    // 尾部增长的部分
+    for (int i = 0; i < tailChange; ++i) {
+        const size_t index = heads + base.size() + i;
+        writeStep(writer, current[index - 1], current[index]);
+    }
+}
+
+bool decodeSnakeDelta(Reader& reader, const std::deque<Point>* base, std::deque<Point>* target)
+{
+    quint32 heads = 0;
+    qint32 tailChange = 0;
+    if (!reader.readVarUInt(heads) || !reader.readVarInt(tailChange)) {
+        return false;
+    }
+    if (!base || base->empty() || heads > static_cast<quint32>(MAX_DELTA_HEADS) ||
+        static_cast<qint64>(base->size()) + tailChange < 0 ||
+        tailChange > reader.remaining()) {
+        return false;
+    }
+
+    std::deque<Point> scratch;
+    std::deque<Point>& snake = target ? *target : scratch;
+    if (&snake != base) {
+        snake = *base;
+    }
+
+    if (tailChange < 0) {
+        snake.erase(snake.end() + tailChange, snake.end());
+    }
+
+    Point current = base->front();
+    for (quint32 i = 0; i < heads; ++i) {
+        if (!readStep(reader, current)) {
+            return false;
+        }
+        snake.push_front(current);
+    }
+
+    if (tailChange > 0) {
+        current = snake.back();
+        for (qint32 i = 0; i < tailChange; ++i) {
+            if (!readStep(reader, current)) {
+                return false;
+            }
+            snake.push_back(current);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Writer
+void Writer::writeU32(quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        buffer.append(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+void Writer::writeU64(quint64 value)
+{
+    writeU32(static_cast<quint32>(value));
+    writeU32(static_cast<quint32>(value >> 32));
+}
+
+void Writer::writeVarUInt(quint32 value)
+{
+    while (value >= 0x80) {
+        buffer.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.append(static_cast<char>(value));
+}
+
+void Writer::writeVarInt(qint32 value)
+{
+    // zigzag：把小的负数映射为小的正数，使其同样只占一个字节
+    writeVarUInt((static_cast<quint32>(value) << 1) ^ static_cast<quint32>(value >> 31));
+}
+
+void Writer::writeString(const QString& value)
+{
+    const QByteArray utf8 = value.toUtf8().left(MAX_STRING_BYTES);
+    writeVarUInt(static_cast<quint32>(utf8.size()));
+    buffer.append(utf8);
+}
+
+void Writer::writePoint(const Point& point)
+{
+    writeVarInt(point.x);
+    writeVarInt(point.y);
+}
+
+// Reader
+bool Reader::readU8(quint8& value)
+{
+    if (!valid || offset >= size) {
+        return fail();
+    }
+    value = data[offset++];
+    return true;
+}
+
+bool Reader::readU32(quint32& value)
+{
+    if (!valid || size - offset < 4) {
+        return fail();
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<quint32>(data[offset++]) << (i * 8);
+    }
+    return true;
+}
+
+bool Reader::readU64(quint64& value)
+{
+    quint32 low = 0;
+    quint32 high = 0;
+    if (!readU32(low) || !readU32(high)) {
+        return false;
+    }
+    value = (static_cast<quint64>(high) << 32) | low;
+    return true;
+}
+
+bool Reader::readVarUInt(quint32& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        quint8 byte = 0;
+        if (!readU8(byte)) {
+            return false;
+        }
+        value |= static_cast<quint32>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return fail();
+}
+
+bool Reader::readVarInt(qint32& value)
+{
+    quint32 raw = 0;
+    if (!readVarUInt(raw)) {
+        return false;
+    }
+    value = static_cast<qint32>((raw >> 1) ^ (~(raw & 1) + 1));
+    return true;
+}
+
+bool Reader::readString(QString& value)
+{
+    quint32 length = 0;
+    if (!readVarUInt(length)) {
+        return false;
+    }
+    if (length > static_cast<quint32>(MAX_STRING_BYTES) || length > static_cast<quint32>(remaining())) {
+        return fail();
+    }
+    value = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), static_cast<int>(length));
+    offset += static_cast<int>(length);
+    return true;
+}
+
+bool Reader::readPoint(Point& point)
+{
+    qint32 x = 0;
+    qint32 y = 0;
+    if (!readVarInt(x) || !readVarInt(y)) {
+        return false;
+    }
+    point = Point(x, y);
+    return true;
+}
+
+// FrameParser
+char* FrameParser::reserve(int bytes)
+{
+    if (readOffset == writeOffset) {
+        // 已全部消费，直接从头开始写，无需移动数据
+        readOffset = 0;
+        writeOffset = 0;
+    }
+
+    if (writeOffset + bytes > buffer.size()) {
+        // 先把未消费的数据移到开头，空间仍不够再扩容
+        if (readOffset > 0) {
+            const int pending = writeOffset - readOffset;
+            memmove(buffer.data(), buffer.constData() + readOffset, pending);
+            readOffset = 0;
+            writeOffset = pending;
+        }
+        if (writeOffset + bytes > buffer.size()) {
+            buffer.resize(qMax(buffer.size() * 2, writeOffset + bytes));
+        }
+    }
+    return buffer.data() + writeOffset;
+}
+
+FrameParser::Status FrameParser::nextFrame(const char*& data, int& size)
+{
+    // 解析varint长度前缀，最多4字节
+    const uchar* bytes = reinterpret_cast<const uchar*>(buffer.constData());
+    quint32 length = 0;
+    int headerSize = 0;
+    bool complete = false;
+    for (int shift = 0; readOffset + headerSize < writeOffset && headerSize < 4; shift += 7) {
+        const uchar byte = bytes[readOffset + headerSize++];
+        length |= static_cast<quint32>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            complete = true;
+            break;
+        }
+    }
+
+    if (!complete) {
+        return headerSize >= 4 ? Status::Error : Status::NeedMoreData;
+    }
+    if (length == 0 || length > static_cast<quint32>(MAX_FRAME_SIZE)) {
+        return Status::Error;
+    }
+    if (writeOffset - readOffset - headerSize < static_cast<int>(length)) {
+        return Status::NeedMoreData;
+    }
+
+    data = buffer.constData() + readOffset + headerSize;
+    size = static_cast<int>(length);
+    readOffset += headerSize + size;
+    return Status::FrameReady;
+}
+
+void appendFrame(QByteArray& out, const QByteArray& message)
+{
+    Writer writer(out);
+    writer.writeVarUInt(static_cast<quint32>(message.size()));
+    out.append(message);
+}
+
+// 控制消息
+QByteArray encodePlayerJoin(const QString& playerName, quint8 joinFlags, quint64 sessionToken, quint32 features)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::PlayerJoin);
+    Writer writer(out);
+    writer.writeU8(PROTOCOL_VERSION);
+    writer.writeString(playerName);
+    writer.writeU8(joinFlags);
+    writer.writeVarUInt(features);
+    if (joinFlags & JoinResume) {
+        writer.writeU64(sessionToken);
+    }
+    return out;
+}
+
+QByteArray encodePlayerLeave(const QString& playerName)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::PlayerLeave);
+    Writer writer(out);
+    writer.writeString(playerName);
+    return out;
+}
+
+QByteArray encodePlayerUpdate(const QString& playerName, const PlayerUpdate& update)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::PlayerUpdate);
+    Writer writer(out);
+    writer.writeString(playerName);
+    writer.writeU8(update.fields);
+    if (update.fields & UpdateDirection) {
+        writer.writeU8(static_cast<quint8>(update.direction));
+    }
+    if (update.fields & UpdateCharacter) {
+        writer.writeU8(static_cast<quint8>(update.character));
+    }
+    if (update.fields & UpdateReady) {
+        writer.writeU8(update.ready ? 1 : 0);
+    }
+    return out;
+}
+
+QByteArray encodeJoinRejected(RejectReason reason)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::JoinRejected);
+    Writer writer(out);
+    writer.writeU8(static_cast<quint8>(reason));
+    return out;
+}
+
+QByteArray encodeJoinAccepted(quint64 sessionToken, quint8 version, quint32 features)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::JoinAccepted);
+    Writer writer(out);
+    writer.writeU64(sessionToken);
+    writer.writeU8(version);
+    writer.writeVarUInt(features);
+    return out;
+}
+
+QByteArray encodeCompressed(const QByteArray& message)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::Compressed);
+    out.append(qCompress(message, COMPRESSION_LEVEL));
+    return out;
+}
+
+bool decodePlayerJoin(Reader& reader, quint8& version, QString& playerName, quint8& joinFlags,
+                      quint32& features, quint64& sessionToken)
+{
+    if (!reader.readU8(version) || !reader.readString(playerName) || !reader.readU8(joinFlags)) {
+        return false;
+    }
+    features = LEGACY_FEATURES;
+    if (version >= 9 && !reader.readVarUInt(features)) {
+        return false;
+    }
+    sessionToken = 0;
+    if ((joinFlags & JoinResume) && !reader.readU64(sessionToken)) {
+        return false;
+    }
+    return true;
+}
+
+bool decodeJoinAccepted(Reader& reader, quint64& sessionToken, quint8& version, quint32& features)
+{
+    if (!reader.readU64(sessionToken)) {
+        return false;
+    }
+    // 版本8的主机只发令牌
+    version = 8;
+    features = LEGACY_FEATURES;
+    if (reader.atEnd()) {
+        return true;
+    }
+    return reader.readU8(version) && reader.readVarUInt(features);
+}
+
+bool decodeCompressed(const QByteArray& payload, QByteArray& message)
+{
+    // qCompress在开头写入4字节大端的原始长度，先检查它，损坏或恶意的数据不会解压出超大的缓冲区
+    if (payload.size() <= 4) {
+        return false;
+    }
+    const quint32 size = (static_cast<quint32>(static_cast<uchar>(payload.at(0))) << 24) |
+                         (static_cast<quint32>(static_cast<uchar>(payload.at(1))) << 16) |
+                         (static_cast<quint32>(static_cast<uchar>(payload.at(2))) << 8) |
+                         static_cast<quint32>(static_cast<uchar>(payload.at(3)));
+    if (size == 0 || size > static_cast<quint32>(MAX_FRAME_SIZE)) {
+        return false;
+    }
+    message = qUncompress(payload);
+    return message.size() == static_cast<int>(size);
+}
+
+QByteArray encodePlayerDirection(int playerId, Direction direction)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::PlayerDirection);
+    Writer writer(out);
+    writer.writeVarUInt(static_cast<quint32>(playerId));
+    writer.writeU8(static_cast<quint8>(direction));
+    return out;
+}
+
+QByteArray encodeChatMessage(const QString& playerName, const QString& message)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::ChatMessage);
+    Writer writer(out);
+    writer.writeString(playerName);
+    writer.writeString(message);
+    return out;
+}
+
+QByteArray encodeHeartbeat(quint32 sequence, quint32 timestamp)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::Heartbeat);
+    Writer writer(out);
+    writer.writeVarUInt(sequence);
+    writer.writeU32(timestamp);
+    return out;
+}
+
+QByteArray encodeHeartbeatReply(quint32 sequence, quint32 timestamp)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::HeartbeatReply);
+    Writer writer(out);
+    writer.writeVarUInt(sequence);
+    writer.writeU32(timestamp);
+    return out;
+}
+
+bool decodePlayerUpdate(Reader& reader, QString& playerName, PlayerUpdate& update)
+{
+    if (!reader.readString(playerName) || !reader.readU8(update.fields)) {
+        return false;
+    }
+
+    quint8 value = 0;
+    if (update.fields & UpdateDirection) {
+        if (!reader.readU8(value) || value > static_cast<quint8>(Direction::RIGHT)) {
+            return false;
+        }
+        update.direction = static_cast<Direction>(value);
+    }
+    if (update.fields & UpdateCharacter) {
+        if (!reader.readU8(value) || value > static_cast<quint8>(CharacterType::PLANKTON)) {
+            return false;
+        }
+        update.character = static_cast<CharacterType>(value);
+    }
+    if (update.fields & UpdateReady) {
+        if (!reader.readU8(value)) {
+            return false;
+        }
+        update.ready = value != 0;
+    }
+    return true;
+}
+
+bool decodePlayerDirection(Reader& reader, int& playerId, Direction& direction)
+{
+    quint32 id = 0;
+    quint8 value = 0;
+    if (!reader.readVarUInt(id) || !reader.readU8(value) || value > static_cast<quint8>(Direction::RIGHT)) {
+        return false;
+    }
+    playerId = static_cast<int>(id);
+    direction = static_cast<Direction>(value);
+    return true;
+}
+
+bool decodeChatMessage(Reader& reader, QString& playerName, QString& message)
+{
+    return reader.readString(playerName) && reader.readString(message);
+}
+
+bool decodeHeartbeat(Reader& reader, quint32& sequence, quint32& timestamp)
+{
+    return reader.readVarUInt(sequence) && reader.readU32(timestamp);
+}
+
+// 玩家名单
+void encodeRoster(const HotspotGameState& state, const QString& hostPlayerName, QByteArray& out)
+{
+    beginMessage(out, Opcode::Roster);
+    Writer writer(out);
+
+    writer.writeVarUInt(static_cast<quint32>(state.playerIds.value(hostPlayerName, -1) + 1));  // 0表示没有房主
+    writer.writeVarUInt(static_cast<quint32>(state.playerIds.size()));
+    for (auto it = state.playerIds.constBegin(); it != state.playerIds.constEnd(); ++it) {
+        writer.writeVarUInt(static_cast<quint32>(it.value()));
+        writer.writeString(it.key());
+        writer.writeU8(static_cast<quint8>(state.playerCharacters.value(it.key(), CharacterType::SPONGEBOB)));
+        writer.writeU8(state.playerReadyStatus.value(it.key(), false) ? 1 : 0);
+    }
+}
+
+bool decodeRoster(Reader& reader, HotspotGameState& state, QString& hostPlayerName)
+{
+    quint32 hostIdPlusOne = 0;
+    quint32 count = 0;
+    if (!reader.readVarUInt(hostIdPlusOne) || !reader.readVarUInt(count) || count > MAX_PLAYERS) {
+        return false;
+    }
+
+    QMap<QString, int> playerIds;
+    QString hostName;
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 id = 0;
+        QString name;
+        quint8 character = 0;
+        quint8 ready = 0;
+        if (!reader.readVarUInt(id) || !reader.readString(name) ||
+            !reader.readU8(character) || !reader.readU8(ready) ||
+            character > static_cast<quint8>(CharacterType::PLANKTON)) {
+            return false;
+        }
+
+        playerIds[name] = static_cast<int>(id);
+        if (id + 1 == hostIdPlusOne) {
+            hostName = name;
+        }
+
+        // 新玩家补齐默认状态，已有玩家保留蛇身和分数
+        if (!state.playerSnakes.contains(name)) {
+            state.playerSnakes[name] = std::deque<Point>();
+            state.playerScores[name] = 0;
+            state.playerAliveStatus[name] = true;
+            state.playerDirections[name] = Direction::RIGHT;
+        }
+        state.playerCharacters[name] = static_cast<CharacterType>(character);
+        state.playerReadyStatus[name] = ready != 0;
+    }
+
+    // 移除已不在名单中的玩家
+    const QStringList knownPlayers = state.playerSnakes.keys();
+    for (const QString& name : knownPlayers) {
+        if (!playerIds.contains(name)) {
+            state.playerSnakes.remove(name);
+            state.playerCharacters.remove(name);
+            state.playerScores.remove(name);
+            state.playerAliveStatus.remove(name);
+            state.playerDirections.remove(name);
+            state.playerReadyStatus.remove(name);
+            state.playerInputSequences.remove(name);
+        }
+    }
+
+    state.playerIds = playerIds;
+    hostPlayerName = hostName;
+    return true;
+}
+
+// 游戏快照
+SnapshotBaseline makeBaseline(const HotspotGameState& state, quint32 sequence)
+{
+    SnapshotBaseline baseline;
+    baseline.sequence = sequence;
+    for (auto it = state.playerIds.constBegin(); it != state.playerIds.constEnd(); ++it) {
+        baseline.snakes[it.value()] = state.playerSnakes.value(it.key());
+    }
+    return baseline;
+}
+
+void encodeGameState(const HotspotGameState& state, quint32 sequence,
+                     const SnapshotBaseline* baseline, QByteArray& out)
+{
+    beginMessage(out, Opcode::GameState);
+    Writer writer(out);
+
+    writer.writeVarUInt(sequence);
+    writer.writeVarUInt(baseline ? baseline->sequence : 0);
+    writer.writeVarUInt(state.tick);
+
+    quint8 flags = 0;
+    if (state.isPaused) flags |= STATE_PAUSED;
+    if (state.isGameStarted) flags |= STATE_STARTED;
+    if (state.isSpecialFood) flags |= STATE_SPECIAL_FOOD;
+    if (!state.gameWinner.isEmpty()) flags |= STATE_HAS_WINNER;
+    writer.writeU8(flags);
+
+    writer.writeVarUInt(static_cast<quint32>(qMax(0, state.gameSpeed)));
+    writer.writeVarUInt(static_cast<quint32>(qMax(0, state.countdownTimer)));
+    writer.writePoint(state.foodPosition);
+    if (state.isSpecialFood) {
+        writer.writePoint(state.specialFoodPosition);
+    }
+    if (!state.gameWinner.isEmpty()) {
+        writer.writeString(state.gameWinner);
+    }
+
+    writer.writeVarUInt(static_cast<quint32>(state.playerIds.size()));
+    for (auto it = state.playerIds.constBegin(); it != state.playerIds.constEnd(); ++it) {
+        const QString& name = it.key();
+        quint8 status = static_cast<quint8>(state.playerDirections.value(name, Direction::RIGHT)) & PLAYER_DIRECTION_MASK;
+        if (state.playerAliveStatus.value(name, false)) {
+            status |= PLAYER_ALIVE;
+        }
+
+        writer.writeVarUInt(static_cast<quint32>(it.value()));
+        writer.writeU8(status);
+        writer.writeVarUInt(static_cast<quint32>(qMax(0, state.playerScores.value(name, 0))));
+        writer.writeVarUInt(state.playerInputSequences.value(name, 0));
+
+        static const std::deque<Point> emptySnake;
+        auto snakeIt = state.playerSnakes.constFind(name);
+        const std::deque<Point>& snake = snakeIt != state.playerSnakes.constEnd() ? snakeIt.value() : emptySnake;
+
+        // 基线中有这条蛇且能对齐时只发增量，否则发完整蛇身
+        int heads = -1;
+        if (baseline) {
+            auto baseIt = baseline->snakes.constFind(it.value());
+            if (baseIt != baseline->snakes.constEnd()) {
+                heads = findNewHeadCount(snake, baseIt.value());
+                if (heads >= 0) {
+                    writer.writeU8(SNAKE_DELTA);
+                    encodeSnakeDelta(writer, snake, baseIt.value(), heads);
+                }
+            }
+        }
+        if (heads < 0) {
+            writer.writeU8(SNAKE_FULL);
+            encodeFullSnake(writer, snake);
+        }
+    }
+}
+
+bool decodeSnapshotHeader(Reader& reader, SnapshotHeader& header)
+{
+    return reader.readVarUInt(header.sequence) && reader.readVarUInt(header.baseSequence) &&
+           reader.readVarUInt(header.tick);
+}
+
+bool decodeGameState(Reader& reader, const SnapshotBaseline* baseline, HotspotGameState& state)
+{
+    quint8 flags = 0;
+    quint32 gameSpeed = 0;
+    quint32 countdown = 0;
+    Point food;
+    if (!reader.readU8(flags) || !reader.readVarUInt(gameSpeed) ||
+        !reader.readVarUInt(countdown) || !reader.readPoint(food)) {
+        return false;
+    }
+
+    state.isPaused = flags & STATE_PAUSED;
+    state.isGameStarted = flags & STATE_STARTED;
+    state.isSpecialFood = flags & STATE_SPECIAL_FOOD;
+    state.gameSpeed = static_cast<int>(gameSpeed);
+    state.countdownTimer = static_cast<int>(countdown);
+    state.foodPosition = food;
+
+    if (state.isSpecialFood && !reader.readPoint(state.specialFoodPosition)) {
+        return false;
+    }
+    if (flags & STATE_HAS_WINNER) {
+        if (!reader.readString(state.gameWinner)) {
+            return false;
+        }
+    } else {
+        state.gameWinner.clear();
+    }
+
+    quint32 count = 0;
+    if (!reader.readVarUInt(count) || count > MAX_PLAYERS) {
+        return false;
+    }
+
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 id = 0;
+        quint8 status = 0;
+        quint32 score = 0;
+        quint32 inputSequence = 0;
+        if (!reader.readVarUInt(id) || !reader.readU8(status) ||
+            !reader.readVarUInt(score) || !reader.readVarUInt(inputSequence)) {
+            return false;
+        }
+
+        // 名单尚未到达的玩家：跳过其数据
+        const QString* name = playerNameForId(state, static_cast<int>(id));
+        std::deque<Point>* snake = nullptr;
+        if (name) {
+            auto snakeIt = state.playerSnakes.find(*name);
+            if (snakeIt != state.playerSnakes.end()) {
+                snake = &snakeIt.value();
+                state.playerDirections[*name] = static_cast<Direction>(status & PLAYER_DIRECTION_MASK);
+                state.playerAliveStatus[*name] = status & PLAYER_ALIVE;
+                state.playerScores[*name] = static_cast<int>(score);
+                state.playerInputSequences[*name] = inputSequence;
+            }
+        }
+
+        quint8 encoding = 0;
+        if (!reader.readU8(encoding)) {
+            return false;
+        }
+        if (encoding == SNAKE_FULL) {
+            if (!decodeFullSnake(reader, snake)) {
+                return false;
+            }
+        } else if (encoding == SNAKE_DELTA) {
+            const std::deque<Point>* base = nullptr;
+            if (baseline) {
+                auto baseIt = baseline->snakes.constFind(static_cast<int>(id));
+                if (baseIt != baseline->snakes.constEnd()) {
+                    base = &baseIt.value();
+                }
+            }
+            if (!decodeSnakeDelta(reader, base, snake)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return reader.isValid();
+}
+
+QByteArray encodeSnapshotAck(quint32 sequence)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::SnapshotAck);
+    Writer writer(out);
+    writer.writeVarUInt(sequence);
+    return out;
+}
+
+QByteArray encodeKeyframeRequest()
+{
+    QByteArray out;
+    beginMessage(out, Opcode::KeyframeRequest);
+    return out;
+}
+
+// 状态通道
+QByteArray encodeStateHello(const QString& playerName)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::StateHello);
+    Writer writer(out);
+    writer.writeString(playerName);
+    return out;
+}
+
+QByteArray encodePlayerInput(const QList<PlayerInput>& inputs)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::PlayerInput);
+    Writer writer(out);
+
+    // 序号连续，只写第一条的序号，后面每条只占一个方向字节
+    const int count = qMin(static_cast<int>(inputs.size()), MAX_INPUTS_PER_MESSAGE);
+    const int first = static_cast<int>(inputs.size()) - count;
+    writer.writeU8(static_cast<quint8>(count));
+    writer.writeVarUInt(count > 0 ? inputs.at(first).sequence : 0);
+    for (int i = first; i < inputs.size(); ++i) {
+        writer.writeU8(static_cast<quint8>(inputs.at(i).direction));
+    }
+    return out;
+}
+
+QByteArray encodeInputAck(quint32 sequence)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::InputAck);
+    Writer writer(out);
+    writer.writeVarUInt(sequence);
+    return out;
+}
+
+bool decodePlayerInput(Reader& reader, QList<PlayerInput>& inputs)
+{
+    quint8 count = 0;
+    quint32 sequence = 0;
+    if (!reader.readU8(count) || count > MAX_INPUTS_PER_MESSAGE || !reader.readVarUInt(sequence)) {
+        return false;
+    }
+
+    inputs.clear();
+    for (quint8 i = 0; i < count; ++i) {
+        quint8 value = 0;
+        if (!reader.readU8(value) || value > static_cast<quint8>(Direction::RIGHT)) {
+            return false;
+        }
+        PlayerInput input;
+        input.sequence = sequence + i;
+        input.direction = static_cast<Direction>(value);
+        inputs.append(input);
+    }
+    return true;
+}
+
+// 锁步模式
+QByteArray encodeLockstepStart(quint32 tick, quint64 randomState)
+{
+    QByteArray out;
+    beginMessage(out, Opcode::LockstepStart);
+    Writer writer(out);
+    writer.writeVarUInt(tick);
+    writer.writeU64(randomState);
+    return out;
+}
+
+void encodeInputBundle(quint32 tick, quint32 checksum, const QList<LockstepInput>& inputs, QByteArray& out)
+{
+    beginMessage(out, Opcode::InputBundle);
+    Writer writer(out);
+    writer.writeVarUInt(tick);
+    writer.writeU32(checksum);
+    writer.writeVarUInt(static_cast<quint32>(inputs.size()));
+    for (const LockstepInput& input : inputs) {
+        writer.writeVarUInt(static_cast<quint32>(input.playerId));
+        writer.writeU8(static_cast<quint8>(input.direction));
+    }
+}
+
+bool decodeLockstepStart(Reader& reader, quint32& tick, quint64& randomState)
+{
+    return reader.readVarUInt(tick) && reader.readU64(randomState);
+}
+
+bool decodeInputBundle(Reader& reader, quint32& tick, quint32& checksum, QList<LockstepInput>& inputs)
+{
+    quint32 count = 0;
+    if (!reader.readVarUInt(tick) || !reader.readU32(checksum) ||
+        !reader.readVarUInt(count) || count > MAX_PLAYERS) {
+        return false;
+    }
+
+    inputs.clear();
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 id = 0;
+        quint8 value = 0;
+        if (!reader.readVarUInt(id) || !reader.readU8(value) || value > static_cast<quint8>(Direction::RIGHT)) {
+            return false;
+        }
+        LockstepInput input;
+        input.playerId = static_cast<int>(id);
+        input.direction = static_cast<Direction>(value);
+        inputs.append(input);
+    }
+    return true;
+}
+
+QString rejectReasonText(RejectReason reason)
+{
+    switch (reason) {
+    case RejectReason::RoomFull:
+        return "Room is full";
+    case RejectReason::VersionMismatch:
+        return "Game version does not match the host";
+    case RejectReason::NameInUse:
+        return "Player name is already in use";
+    case RejectReason::SessionExpired:
+        return "Session expired, please join again";
+    }
+    return "Join rejected by host";
+}
+
+} // namespace HotspotProtocol
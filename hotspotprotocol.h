@@ -0,0 +1,265 @@
+#ifndef HOTSPOTPROTOCOL_H
+#define HOTSPOTPROTOCOL_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+#include <QMap>
+#include <QList>
+#include <deque>
+#include "gamestate.h"
+
+struct HotspotGameState;
+
+/**
+ * 热点联机二进制协议
+ * 取代原先逐条构造QJsonObject再转成文本的消息格式
+ * 特点：
+ * 1. 每条消息以一个字节的操作码开头，接收端按操作码switch分发
+ * 2. 整数使用varint编码，可能为负的坐标先做zigzag变换
+ * 3. 蛇身只编码蛇头坐标，其余每节用一个字节记录相对前一节的位移
+ * 4. 玩家用房主分配的数字ID标识，名字只出现在玩家名单消息中
+ * 5. 解码直接读取接收缓冲区，稳定状态下复用已有容器，不产生额外分配
+ * 6. 快照带序号，可以相对客户端已确认的快照只发送蛇头和蛇尾的变化
+ * 7. 快照和方向输入可以走UDP状态通道（一个数据报一条消息，不加帧头），
+ *    其余控制消息始终走TCP
+ * 8. 加入成功后主机下发会话令牌，连接意外断开的玩家在宽限期内凭令牌恢复原来的位置
+ * 9. 加入时协商协议版本和可选特性：主机接受 MIN_PROTOCOL_VERSION 以上的客户端，双方按较低的版本
+ *    和共同支持的特性通信；以后的版本只在PlayerJoin和JoinAccepted末尾追加字段，旧的一方读到已知字段为止
+ */
+namespace HotspotProtocol {
+
+const quint8 PROTOCOL_VERSION = 9;
+const quint8 MIN_PROTOCOL_VERSION = 8;  // 主机仍接受的最低客户端版本
+const int MAX_FRAME_SIZE = 256 * 1024;  // 单帧上限，超过视为协议错误并断开连接
+const int MAX_DATAGRAM_SIZE = 1200;     // 状态通道单个数据报上限，保证不被IP分片，更大的消息改走TCP
+const int MAX_INPUTS_PER_MESSAGE = 8;   // 每条输入消息冗余携带的最近输入数
+const int MAX_DELTA_HEADS = 64;         // 增量快照最多描述这么多个新蛇头，基线更旧时改发完整蛇身
+const int COMPRESSION_THRESHOLD = 256;  // 只压缩不小于它的TCP消息，更小的消息压缩收益抵不上开销
+const int COMPRESSION_LEVEL = 1;        // zlib最快档，关键帧和名单的重复结构用它已能明显缩小
+
+// 消息操作码
+enum class Opcode : quint8 {
+    PlayerJoin = 1,     // 客户端 -> 主机：协议版本、玩家名、加入标志、支持的特性，恢复会话时再带会话令牌
+    PlayerLeave,        // 客户端 -> 主机：玩家名
+    PlayerUpdate,       // 客户端 -> 主机：方向/角色/准备状态
+    JoinRejected,       // 主机 -> 客户端：拒绝原因
+    Roster,             // 主机 -> 客户端：玩家ID、名字、角色、准备状态
+    GameState,          // 主机 -> 客户端：游戏快照
+    PlayerDirection,    // 主机 -> 客户端：某个玩家的方向变化
+    ChatMessage,        // 双向：玩家名、内容
+    Heartbeat,          // 双向：心跳序号、发送方时间戳，收到后立即回复用于测量往返时间
+    SnapshotAck,        // 客户端 -> 主机：已应用的快照序号
+    KeyframeRequest,    // 客户端 -> 主机：缺少增量的基线，请求完整快照
+    StateHello,         // UDP双向：客户端登记状态通道地址（玩家名），主机原样回复表示通道可用
+    PlayerInput,        // 客户端 -> 主机：最近几次带序号的方向输入，丢包后由下一条消息补齐
+    InputAck,           // 主机 -> 客户端：已应用的最大输入序号
+    LockstepStart,      // 主机 -> 客户端：进入锁步模式，携带帧号和随机数状态，紧跟在关键帧之后
+    InputBundle,        // 主机 -> 客户端：锁步模式下一帧内的方向变化和该帧结束后的状态校验和
+    HeartbeatReply,     // 双向：原样带回心跳序号和时间戳
+    JoinAccepted,       // 主机 -> 客户端：会话令牌（观战者为0）、协商出的协议版本和特性
+    Compressed          // TCP双向：qCompress压缩的完整消息（操作码 + 负载），只发给协商了压缩的一方
+};
+
+enum class RejectReason : quint8 {
+    RoomFull = 1,
+    VersionMismatch,
+    NameInUse,          // 同名玩家仍在线或处于断线宽限期
+    SessionExpired      // 恢复会话时令牌无效或宽限期已过
+};
+
+// PlayerJoin 消息的加入标志
+enum JoinFlag : quint8 {
+    JoinAsSpectator = 0x01, // 观战：不占玩家名额，只接收低频关键帧
+    JoinResume = 0x02       // 恢复断线前的会话，标志之后跟会话令牌
+};
+
+// 加入时协商的可选特性，双方都支持时才启用
+enum Feature : quint32 {
+    FeatureDeltaSnapshots = 0x01,  // 快照相对已确认的基线增量编码，否则每次都发关键帧
+    FeatureStateChannel = 0x02,    // 快照和输入走UDP状态通道，否则全部走TCP
+    FeatureCompression = 0x04      // 大于 COMPRESSION_THRESHOLD 的TCP消息压缩后发送
+};
+const quint32 SUPPORTED_FEATURES = FeatureDeltaSnapshots | FeatureStateChannel | FeatureCompression;
+const quint32 LEGACY_FEATURES = FeatureDeltaSnapshots | FeatureStateChannel;  // 版本8没有特性字段，固定具备这些特性
+
+// PlayerUpdate 消息中实际携带的字段
+enum PlayerUpdateField : quint8 {
+    UpdateDirection = 0x01,
+    UpdateCharacter = 0x02,
+    UpdateReady = 0x04
+};
+
+// 快照基线：某个序号的快照中各玩家的蛇身，增量快照相对它编码
+struct SnapshotBaseline {
+    quint32 sequence = 0;
+    QMap<int, std::deque<Point>> snakes;  // 键为玩家ID
+};
+
+struct SnapshotHeader {
+    quint32 sequence = 0;
+    quint32 baseSequence = 0;  // 0表示关键帧
+    quint32 tick = 0;          // 主机生成快照时的游戏逻辑帧号
+};
+
+// 锁步模式下某一帧生效的方向变化
+struct LockstepInput {
+    int playerId = 0;
+    Direction direction = Direction::RIGHT;
+};
+
+// 客户端方向输入，序号从1开始递增
+struct PlayerInput {
+    quint32 sequence = 0;
+    Direction direction = Direction::RIGHT;
+};
+
+struct PlayerUpdate {
+    quint8 fields = 0;
+    Direction direction = Direction::RIGHT;
+    CharacterType character = CharacterType::SPONGEBOB;
+    bool ready = false;
+};
+
+/**
+ * 追加写入器：把基本类型按协议编码追加到缓冲区末尾
+ */
+class Writer
+{
+public:
+    explicit Writer(QByteArray& buffer) : buffer(buffer) {}
+
+    void writeU8(quint8 value) { buffer.append(static_cast<char>(value)); }
+    void writeU32(quint32 value);  // 定长小端，用于校验和等分布均匀的值
+    void writeU64(quint64 value);
+    void writeVarUInt(quint32 value);
+    void writeVarInt(qint32 value);
+    void writeString(const QString& value);
+    void writePoint(const Point& point);
+
+private:
+    QByteArray& buffer;
+};
+
+/**
+ * 只读解码器：在调用方提供的内存上顺序读取，不复制数据
+ * 任何越界或格式错误都会使读取器失效，之后的读取全部返回false
+ */
+class Reader
+{
+public:
+    Reader(const char* data, int size)
+        : data(reinterpret_cast<const uchar*>(data)), size(size), offset(0), valid(true) {}
+    explicit Reader(const QByteArray& buffer)
+        : Reader(buffer.constData(), buffer.size()) {}
+
+    bool readU8(quint8& value);
+    bool readU32(quint32& value);
+    bool readU64(quint64& value);
+    bool readVarUInt(quint32& value);
+    bool readVarInt(qint32& value);
+    bool readString(QString& value);
+    bool readPoint(Point& point);
+
+    int remaining() const { return valid ? size - offset : 0; }
+    bool atEnd() const { return remaining() == 0; }
+    bool isValid() const { return valid; }
+
+private:
+    bool fail() { valid = false; return false; }
+
+    const uchar* data;
+    int size;
+    int offset;
+    bool valid;
+};
+
+/**
+ * TCP流分帧解析器
+ * 帧格式：varint消息长度 + 消息（操作码 + 负载）
+ * 特点：
+ * 1. 数据直接从套接字读入内部缓冲区，帧在缓冲区内原地返回，不复制
+ * 2. 跨TCP分段的帧留在缓冲区中等待后续数据，不会丢失
+ * 3. 只有缓冲区需要增长时才把未消费的数据移到开头，避免每次读取都移动内存
+ * 4. 帧长度超过 MAX_FRAME_SIZE 时报告错误，缓冲区不会被恶意或损坏的数据撑大
+ */
+class FrameParser
+{
+public:
+    enum class Status {
+        FrameReady,
+        NeedMoreData,
+        Error
+    };
+
+    FrameParser() : readOffset(0), writeOffset(0) {}
+
+    // 预留可写空间，写入后用commit确认实际写入的字节数
+    char* reserve(int bytes);
+    void commit(int bytes) { writeOffset += bytes; }
+
+    // 返回的data指向内部缓冲区，在下一次reserve之前有效
+    Status nextFrame(const char*& data, int& size);
+
+    int bufferedBytes() const { return writeOffset - readOffset; }
+    void clear() { readOffset = 0; writeOffset = 0; buffer.clear(); }
+
+private:
+    QByteArray buffer;
+    int readOffset;
+    int writeOffset;
+};
+
+// 在out末尾追加一帧
+void appendFrame(QByteArray& out, const QByteArray& message);
+
+// 控制消息编码（返回完整消息：操作码 + 负载）
+QByteArray encodePlayerJoin(const QString& playerName, quint8 joinFlags = 0, quint64 sessionToken = 0,
+                            quint32 features = SUPPORTED_FEATURES);  // 令牌只在带JoinResume时写入
+QByteArray encodePlayerLeave(const QString& playerName);
+QByteArray encodePlayerUpdate(const QString& playerName, const PlayerUpdate& update);
+QByteArray encodeJoinRejected(RejectReason reason);
+QByteArray encodeJoinAccepted(quint64 sessionToken, quint8 version, quint32 features);  // 版本8的客户端只读令牌
+QByteArray encodeCompressed(const QByteArray& message);
+QByteArray encodePlayerDirection(int playerId, Direction direction);
+QByteArray encodeChatMessage(const QString& playerName, const QString& message);
+QByteArray encodeHeartbeat(quint32 sequence, quint32 timestamp);
+QByteArray encodeHeartbeatReply(quint32 sequence, quint32 timestamp);
+QByteArray encodeSnapshotAck(quint32 sequence);
+QByteArray encodeKeyframeRequest();
+QByteArray encodeStateHello(const QString& playerName);
+QByteArray encodePlayerInput(const QList<PlayerInput>& inputs);  // 序号须连续，只编码最后 MAX_INPUTS_PER_MESSAGE 条
+QByteArray encodeInputAck(quint32 sequence);
+QByteArray encodeLockstepStart(quint32 tick, quint64 randomState);
+void encodeInputBundle(quint32 tick, quint32 checksum, const QList<LockstepInput>& inputs, QByteArray& out);
+
+// 控制消息解码（读取器位于操作码之后）
+bool decodePlayerJoin(Reader& reader, quint8& version, QString& playerName, quint8& joinFlags,
+                      quint32& features, quint64& sessionToken);
+bool decodeJoinAccepted(Reader& reader, quint64& sessionToken, quint8& version, quint32& features);
+bool decodeCompressed(const QByteArray& payload, QByteArray& message);  // payload 为操作码之后的部分
+bool decodePlayerUpdate(Reader& reader, QString& playerName, PlayerUpdate& update);
+bool decodePlayerDirection(Reader& reader, int& playerId, Direction& direction);
+bool decodeChatMessage(Reader& reader, QString& playerName, QString& message);
+bool decodeHeartbeat(Reader& reader, quint32& sequence, quint32& timestamp);  // 心跳和回复格式相同
+bool decodePlayerInput(Reader& reader, QList<PlayerInput>& inputs);
+bool decodeLockstepStart(Reader& reader, quint32& tick, quint64& randomState);
+bool decodeInputBundle(Reader& reader, quint32& tick, quint32& checksum, QList<LockstepInput>& inputs);
+
+// 玩家名单：ID与名字、角色、准备状态的对应关系，只在成员变化时发送
+void encodeRoster(const HotspotGameState& state, const QString& hostPlayerName, QByteArray& out);
+bool decodeRoster(Reader& reader, HotspotGameState& state, QString& hostPlayerName);
+
+// 游戏快照：baseline为空时编码关键帧，否则蛇身相对基线编码为增量
+// out会先清空但保留容量，便于每次同步复用同一块缓冲区
+SnapshotBaseline makeBaseline(const HotspotGameState& state, quint32 sequence);
+void encodeGameState(const HotspotGameState& state, quint32 sequence,
+                     const SnapshotBaseline* baseline, QByteArray& out);
+bool decodeSnapshotHeader(Reader& reader, SnapshotHeader& header);
+bool decodeGameState(Reader& reader, const SnapshotBaseline* baseline, HotspotGameState& state);
+
+QString rejectReasonText(RejectReason reason);
+
+} // namespace HotspotProtocol
+
+#endif // HOTSPOTPROTOCOL_H
@@ -9,7 +9,7 @@
 #include <QDebug>
 #include <QPainter>
 #include <QEnterEvent>
-#include <QSvgRenderer>
+#include "svgrasterizer.h"
 
 // LocalCoopCharacterButton 实现
 LocalCoopCharacterButton::LocalCoopCharacterButton(CharacterType character, QWidget *parent)
@@ -20,6 +20,13 @@ LocalCoopCharacterButton::LocalCoopCharacterButton(CharacterType character, QWid
 {
     loadCharacterInfo();
     setFixedSize(120, 150);
+    
+    // 新尺寸（如移动到HiDPI屏幕）栅格化完成后重绘
+    connect(SvgRasterizer::instance(), &SvgRasterizer::pixmapReady, this, [this](const QString& svgPath) {
+        if (svgPath == headSvgPath) {
+            update();
+        }
+    });
     setCheckable(true);
     setStyleSheet("QPushButton { border: 2px solid #333; border-radius: 10px; background-color: #f0f0f0; font-family: '华文彩云'; }"
                   "QPushButton:checked { border: 3px solid #ff6b35; background-color: #ffe0d6; }"
@@ -52,7 +59,11 @@ void LocalCoopCharacterButton::paintEvent(QPaintEvent *event)
         painter.fillRect(rect(), QColor(128, 128, 128, 100));
     }
     
-    // 绘制角色图片
+    // 绘制角色图片：优先使用按当前屏幕像素比栅格化的SVG，加载失败时使用默认图片
+    QPixmap characterPixmap = SvgRasterizer::instance()->pixmap(headSvgPath, QSize(100, 100), devicePixelRatioF());
+    if (characterPixmap.isNull()) {
+        characterPixmap = fallbackPixmap;
+    }
     if (!characterPixmap.isNull()) {
         QRect pixmapRect(10, 10, 100, 100);
         if (isDisabledCustom) {
@@ -123,20 +134,16 @@ void LocalCoopCharacterButton::loadCharacterInfo()
         break;
     }
     
-    // 使用蛇头图片
-    QString headPath = basePath + characterName_en + "_head.svg";
-    QSvgRenderer headRenderer;
-    headRenderer.load(headPath);
+    // 使用蛇头图片，由SvgRasterizer按物理像素尺寸栅格化
+    headSvgPath = basePath + characterName_en + "_head.svg";
+    QPixmap headPixmap = SvgRasterizer::instance()->pixmap(headSvgPath, QSize(100, 100), devicePixelRatioF());
     
-    if (headRenderer.isValid()) {
-        characterPixmap = QPixmap(100, 100);
-        characterPixmap.fill(Qt::transparent);
-        QPainter painter(&characterPixmap);
-        headRenderer.render(&painter);
+    if (!headPixmap.isNull()) {
+        fallbackPixmap = QPixmap();
     } else {
         // 如果蛇头SVG不存在，创建默认图片
-        characterPixmap = QPixmap(100, 100);
-        QPainter painter(&characterPixmap);
+        fallbackPixmap = QPixmap(100, 100);
+        QPainter painter(&fallbackPixmap);
         
         // 根据角色类型设置不同颜色
         QColor color;
@@ -149,9 +156,9 @@ void LocalCoopCharacterButton::loadCharacterInfo()
         case CharacterType::PLANKTON: color = Qt::green; break;
         }
         
-        painter.fillRect(characterPixmap.rect(), color);
+        painter.fillRect(fallbackPixmap.rect(), color);
         painter.setPen(Qt::black);
-        painter.drawRect(characterPixmap.rect().adjusted(0, 0, -1, -1));
+        painter.drawRect(fallbackPixmap.rect().adjusted(0, 0, -1, -1));
     }
 }
 
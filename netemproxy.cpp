@@ -0,0 +1,499 @@
+#include "netemproxy.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+struct BuiltinProfile {
+    const char* name;
+    NetemProxy::Impairment impairment;  // latency, jitter, loss, reorder, bandwidth
+};
+
+// 单向数值，往返时间约为延迟的两倍
+const BuiltinProfile BUILTIN_PROFILES[] = {
+    {"none",         {0, 0, 0.0, 0.0, 0}},
+    {"lan",          {1, 1, 0.0, 0.0, 0}},
+    {"wifi",         {5, 5, 0.5, 0.0, 0}},
+    {"hotspot",      {25, 15, 1.0, 0.5, 256}},
+    {"busy-hotspot", {60, 40, 5.0, 2.0, 64}},
+    {"congested",    {150, 80, 10.0, 5.0, 24}},
+};
+
+bool builtinImpairment(const QString& name, NetemProxy::Impairment* impairment)
+{
+    for (const BuiltinProfile& builtin : BUILTIN_PROFILES) {
+        if (name == QLatin1String(builtin.name)) {
+            *impairment = builtin.impairment;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 在 base 的基础上应用对象中给出的字段；"profile" 字段先把基础换成对应的内置档位
+bool parseImpairment(const QJsonObject& object, NetemProxy::Impairment base, NetemProxy::Impairment* impairment, QString* error)
+{
+    if (object.contains("profile") && !builtinImpairment(object["profile"].toString(), &base)) {
+        *error = QString("unknown profile \"%1\"").arg(object["profile"].toString());
+        return false;
+    }
+    base.latency = object["latency"].toInt(base.latency);
+    base.jitter = object["jitter"].toInt(base.jitter);
+    base.loss = object["loss"].toDouble(base.loss);
+    base.reorder = object["reorder"].toDouble(base.reorder);
+    base.bandwidth = object["bandwidth"].toInt(base.bandwidth);
+
+    if (base.latency < 0 || base.jitter < 0 || base.bandwidth < 0 ||
+        base.loss < 0.0 || base.loss > 100.0 || base.reorder < 0.0 || base.reorder > 100.0) {
+        *error = "latency, jitter and bandwidth must be >= 0, loss and reorder within 0-100";
+        return false;
+    }
+    *impairment = base;
+    return true;
+}
+
+QJsonObject impairmentToJson(const NetemProxy::Impairment& impairment)
+{
+    QJsonObject object;
+    object["latency"] = impairment.latency;
+    object["jitter"] = impairment.jitter;
+    object["loss"] = impairment.loss;
+    object["reorder"] = impairment.reorder;
+    object["bandwidth"] = impairment.bandwidth;
+    return object;
+}
+
+} // namespace
+
+NetemProxy::NetemProxy(const Options& options, QObject *parent)
+    : QObject(parent)
+    , options(options)
+    , phaseIndex(0)
+    , random(options.seed)
+    , tcpServer(new QTcpServer(this))
+    , listenSocket(new QUdpSocket(this))
+    , nextId(1)
+    , dispatchTimer(new QTimer(this))
+    , phaseTimer(new QTimer(this))
+    , routeExpiryTimer(new QTimer(this))
+{
+    clock.start();
+    Phase phase;
+    phase.name = "none";
+    profile.name = "none";
+    profile.phases.append(phase);
+
+    dispatchTimer->setSingleShot(true);
+    dispatchTimer->setTimerType(Qt::PreciseTimer);
+    phaseTimer->setSingleShot(true);
+
+    connect(tcpServer, &QTcpServer::newConnection, this, &NetemProxy::onNewConnection);
+    connect(listenSocket, &QUdpSocket::readyRead, this, &NetemProxy::onListenDatagram);
+    connect(dispatchTimer, &QTimer::timeout, this, &NetemProxy::dispatch);
+    connect(phaseTimer, &QTimer::timeout, this, &NetemProxy::onPhaseTimeout);
+    connect(routeExpiryTimer, &QTimer::timeout, this, &NetemProxy::onRouteExpiryTimeout);
+}
+
+NetemProxy::~NetemProxy()
+{
+    qDeleteAll(tcpLinks);
+    qDeleteAll(udpRoutes);
+}
+
+bool NetemProxy::start()
+{
+    if (!tcpServer->listen(options.listenAddress, options.listenPort)) {
+        qWarning() << "Netem proxy failed to listen on TCP port" << options.listenPort << tcpServer->errorString();
+        return false;
+    }
+    const quint16 statePort = static_cast<quint16>(options.listenPort + 1);
+    if (!listenSocket->bind(options.listenAddress, statePort)) {
+        qWarning() << "Netem proxy failed to bind UDP port" << statePort << listenSocket->errorString();
+        tcpServer->close();
+        return false;
+    }
+
+    routeExpiryTimer->start(ROUTE_EXPIRY_INTERVAL);
+    applyPhase(0);
+    qInfo() << "Netem proxy listening on" << options.listenPort << "/" << statePort << "->"
+            << options.targetAddress.toString() << options.targetPort << "/" << options.targetStatePort
+            << "profile" << profile.name;
+    return true;
+}
+
+void NetemProxy::setProfile(const Profile& newProfile)
+{
+    if (newProfile.phases.isEmpty()) {
+        return;
+    }
+    profile = newProfile;
+    if (tcpServer->isListening()) {
+        applyPhase(0);
+    } else {
+        impairment = profile.phases.first().impairment;
+    }
+}
+
+QStringList NetemProxy::builtinProfileNames()
+{
+    QStringList names;
+    for (const BuiltinProfile& builtin : BUILTIN_PROFILES) {
+        names.append(QLatin1String(builtin.name));
+    }
+    return names;
+}
+
+// JSON文件可以是单个档位对象，例如 {"profile": "hotspot", "loss": 3}，
+// 也可以分阶段：{"name": "commute", "loop": 90, "phases": [{"at": 0, "profile": "wifi"}, {"at": 30, "latency": 120}]}，
+// 没有 "profile" 字段的阶段在上一阶段的基础上修改
+bool NetemProxy::loadProfile(const QString& spec, Profile* profile, QString* error)
+{
+    Impairment builtin;
+    if (builtinImpairment(spec, &builtin)) {
+        Phase phase;
+        phase.name = spec;
+        phase.impairment = builtin;
+        profile->name = spec;
+        profile->phases = {phase};
+        profile->loopPeriod = 0;
+        return true;
+    }
+
+    QFile file(spec);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("\"%1\" is neither a built-in profile (%2) nor a readable file")
+                     .arg(spec, builtinProfileNames().join(", "));
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        *error = QString("%1: %2").arg(spec, parseError.errorString());
+        return false;
+    }
+
+    const QJsonObject root = document.object();
+    Profile loaded;
+    loaded.name = root["name"].toString(QFileInfo(spec).baseName());
+    loaded.loopPeriod = root["loop"].toInt(0);
+
+    const QJsonArray phases = root.contains("phases") ? root["phases"].toArray() : QJsonArray{root};
+    Impairment previous;
+    for (const QJsonValue& value : phases) {
+        const QJsonObject object = value.toObject();
+        Phase phase;
+        phase.at = object["at"].toInt(0);
+        phase.name = object["profile"].toString(loaded.name);
+        if (!parseImpairment(object, previous, &phase.impairment, error)) {
+            error->prepend(QString("%1: ").arg(spec));
+            return false;
+        }
+        if ((loaded.phases.isEmpty() && phase.at != 0) ||
+            (!loaded.phases.isEmpty() && phase.at <= loaded.phases.last().at)) {
+            *error = QString("%1: phases must start at 0 and have increasing \"at\" seconds").arg(spec);
+            return false;
+        }
+        previous = phase.impairment;
+        loaded.phases.append(phase);
+    }
+
+    if (loaded.phases.isEmpty()) {
+        *error = QString("%1: no phases").arg(spec);
+        return false;
+    }
+    if (loaded.loopPeriod < 0 || (loaded.loopPeriod > 0 && loaded.loopPeriod <= loaded.phases.last().at)) {
+        *error = QString("%1: \"loop\" must be longer than the last phase start").arg(spec);
+        return false;
+    }
+
+    *profile = loaded;
+    return true;
+}
+
+QJsonObject NetemProxy::stats() const
+{
+    QJsonObject status;
+    status["profile"] = profile.name;
+    status["phase"] = profile.phases.value(phaseIndex).name;
+    status["impairment"] = impairmentToJson(impairment);
+    status["tcpLinks"] = tcpLinks.size();
+    status["udpRoutes"] = udpRoutes.size();
+    status["queued"] = static_cast<double>(deliveries.size());
+    status["toHost"] = countersToJson(counters[static_cast<int>(Direction::ToHost)]);
+    status["toClient"] = countersToJson(counters[static_cast<int>(Direction::ToClient)]);
+    return status;
+}
+
+QJsonObject NetemProxy::countersToJson(const Counters& counters)
+{
+    QJsonObject object;
+    object["packets"] = static_cast<double>(counters.packets);
+    object["bytes"] = static_cast<double>(counters.bytes);
+    object["lost"] = static_cast<double>(counters.lost);
+    object["overflow"] = static_cast<double>(counters.overflow);
+    object["reordered"] = static_cast<double>(counters.reordered);
+    object["stalls"] = static_cast<double>(counters.stalls);
+    return object;
+}
+
+void NetemProxy::onNewConnection()
+{
+    while (QTcpSocket* client = tcpServer->nextPendingConnection()) {
+        const quint64 id = nextId++;
+        TcpLink* link = new TcpLink{client, new QTcpSocket(this)};
+        tcpLinks.insert(id, link);
+
+        // 延迟由代理注入，不让Nagle算法再叠加一层
+        client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(client, &QTcpSocket::readyRead, this, [this, id]() { onTcpReadyRead(id, Direction::ToHost); });
+        connect(client, &QTcpSocket::disconnected, this, [this, id]() { scheduleClose(id, Direction::ToHost); });
+        connect(link->upstream, &QTcpSocket::connected, this, [link]() {
+            link->upstream->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        });
+        connect(link->upstream, &QTcpSocket::readyRead, this, [this, id]() { onTcpReadyRead(id, Direction::ToClient); });
+        connect(link->upstream, &QTcpSocket::disconnected, this, [this, id]() { scheduleClose(id, Direction::ToClient); });
+        connect(link->upstream, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+                this, [this, id](QAbstractSocket::SocketError) { scheduleClose(id, Direction::ToClient); });
+
+        // 连接主机期间客户端发来的数据由QTcpSocket缓存，连接建立后发出
+        link->upstream->connectToHost(options.targetAddress, options.targetPort);
+        qDebug() << "Netem proxy accepted" << client->peerAddress().toString() << ":" << client->peerPort() << "as link" << id;
+    }
+}
+
+void NetemProxy::onTcpReadyRead(quint64 id, Direction direction)
+{
+    TcpLink* link = tcpLinks.value(id);
+    if (!link || link->closing) {
+        return;
+    }
+    QTcpSocket* source = direction == Direction::ToHost ? link->client : link->upstream;
+    Pipe& pipe = direction == Direction::ToHost ? link->toHost : link->toClient;
+    const QByteArray data = source->readAll();
+    if (!data.isEmpty()) {
+        schedule(pipe, true, direction, id, data);
+    }
+}
+
+void NetemProxy::onListenDatagram()
+{
+    while (listenSocket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(static_cast<int>(listenSocket->pendingDatagramSize()));
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        if (listenSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort) < 0) {
+            continue;
+        }
+
+        const QString key = QString("%1:%2").arg(sender.toString()).arg(senderPort);
+        quint64 id = routeIds.value(key, 0);
+        if (id == 0) {
+            // 每个客户端端点对应一个上游套接字，主机按来源端点区分玩家，回包也据此找回客户端
+            id = nextId++;
+            QUdpSocket* upstream = new QUdpSocket(this);
+            if (!upstream->bind(QHostAddress(QHostAddress::AnyIPv4), 0)) {
+                qWarning() << "Netem proxy failed to bind upstream UDP socket:" << upstream->errorString();
+                delete upstream;
+                continue;
+            }
+            connect(upstream, &QUdpSocket::readyRead, this, [this, id, upstream]() {
+                UdpRoute* route = udpRoutes.value(id);
+                while (upstream->hasPendingDatagrams()) {
+                    QByteArray reply;
+                    reply.resize(static_cast<int>(upstream->pendingDatagramSize()));
+                    if (upstream->readDatagram(reply.data(), reply.size()) < 0 || !route) {
+                        continue;
+                    }
+                    route->lastActiveUs = nowUs();
+                    schedule(route->toClient, false, Direction::ToClient, id, reply);
+                }
+            });
+            udpRoutes.insert(id, new UdpRoute{upstream, sender, senderPort, Pipe(), Pipe(), nowUs()});
+            routeIds.insert(key, id);
+        }
+
+        UdpRoute* route = udpRoutes.value(id);
+        route->lastActiveUs = nowUs();
+        schedule(route->toHost, false, Direction::ToHost, id, datagram);
+    }
+}
+
+void NetemProxy::schedule(Pipe& pipe, bool stream, Direction direction, quint64 id, const QByteArray& data)
+{
+    Counters& counter = counters[static_cast<int>(direction)];
+    const qint64 now = nowUs();
+
+    if (!stream && impairment.loss > 0.0 && random.bounded(100.0) < impairment.loss) {
+        ++counter.lost;
+        return;
+    }
+
+    // 先排带宽队列：数据在前面的数据发完后才开始发送，发送本身占用 大小/带宽 的时间
+    qint64 sentUs = now;
+    if (impairment.bandwidth > 0) {
+        const qint64 startUs = qMax(now, pipe.wireFreeUs);
+        if (!stream && startUs - now > UDP_QUEUE_LIMIT * 1000LL) {
+            ++counter.overflow;
+            return;
+        }
+        pipe.wireFreeUs = startUs + data.size() * 1000000LL / (impairment.bandwidth * 1024LL);
+        sentUs = pipe.wireFreeUs;
+    }
+
+    qint64 delayUs = impairment.latency * 1000LL;
+    if (impairment.jitter > 0) {
+        delayUs += random.bounded(-impairment.jitter * 1000, impairment.jitter * 1000 + 1);
+    }
+    delayUs = qMax(Q_INT64_C(0), delayUs);
+
+    if (stream) {
+        if (impairment.loss > 0.0 && random.bounded(100.0) < impairment.loss) {
+            delayUs += RETRANSMIT_PENALTY * 1000LL;
+            ++counter.stalls;
+        }
+    } else if (impairment.reorder > 0.0 && random.bounded(100.0) < impairment.reorder) {
+        delayUs += REORDER_DELAY * 1000LL;
+        ++counter.reordered;
+    }
+
+    qint64 dueUs = sentUs + delayUs;
+    if (stream) {
+        // 字节流不能乱序，抖动或重传停顿会把后面的数据一起推迟
+        dueUs = qMax(dueUs, pipe.lastDueUs);
+        pipe.lastDueUs = dueUs;
+    }
+
+    ++counter.packets;
+    counter.bytes += static_cast<quint64>(data.size());
+    deliveries.insert({dueUs, Delivery{stream, direction, id, data, false}});
+    armDispatchTimer();
+}
+
+void NetemProxy::scheduleClose(quint64 id, Direction direction)
+{
+    TcpLink* link = tcpLinks.value(id);
+    if (!link || link->closing) {
+        return;
+    }
+    link->closing = true;
+
+    // 关闭排在已转发的数据之后，对端先收完数据再看到断开
+    Pipe& pipe = direction == Direction::ToHost ? link->toHost : link->toClient;
+    const qint64 dueUs = qMax(nowUs() + impairment.latency * 1000LL, pipe.lastDueUs);
+    deliveries.insert({dueUs, Delivery{true, direction, id, QByteArray(), true}});
+    armDispatchTimer();
+}
+
+void NetemProxy::dispatch()
+{
+    const qint64 now = nowUs();
+    while (!deliveries.empty() && deliveries.begin()->first <= now) {
+        const Delivery delivery = std::move(deliveries.begin()->second);
+        deliveries.erase(deliveries.begin());
+        deliver(delivery);
+    }
+    armDispatchTimer();
+}
+
+void NetemProxy::deliver(const Delivery& delivery)
+{
+    if (delivery.stream) {
+        TcpLink* link = tcpLinks.value(delivery.id);
+        if (!link) {
+            return;
+        }
+        if (delivery.close) {
+            closeLink(delivery.id);
+            return;
+        }
+        QTcpSocket* target = delivery.direction == Direction::ToHost ? link->upstream : link->client;
+        target->write(delivery.data);
+        return;
+    }
+
+    UdpRoute* route = udpRoutes.value(delivery.id);
+    if (!route) {
+        return;
+    }
+    if (delivery.direction == Direction::ToHost) {
+        route->upstream->writeDatagram(delivery.data, options.targetAddress, options.targetStatePort);
+    } else {
+        listenSocket->writeDatagram(delivery.data, route->clientAddress, route->clientPort);
+    }
+}
+
+void NetemProxy::armDispatchTimer()
+{
+    if (deliveries.empty()) {
+        dispatchTimer->stop();
+        return;
+    }
+    const qint64 waitUs = deliveries.begin()->first - nowUs();
+    dispatchTimer->start(static_cast<int>(qMax(Q_INT64_C(0), (waitUs + 999) / 1000)));
+}
+
+void NetemProxy::closeLink(quint64 id)
+{
+    TcpLink* link = tcpLinks.take(id);
+    if (!link) {
+        return;
+    }
+    // 优雅关闭，已写入的数据发完后再释放套接字
+    for (QTcpSocket* socket : {link->client, link->upstream}) {
+        socket->disconnect(this);
+        if (socket->state() == QAbstractSocket::UnconnectedState) {
+            socket->deleteLater();
+        } else {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            socket->disconnectFromHost();
+        }
+    }
+    delete link;
+    qDebug() << "Netem proxy closed link" << id;
+}
+
+void NetemProxy::onRouteExpiryTimeout()
+{
+    const qint64 now = nowUs();
+    for (auto it = udpRoutes.begin(); it != udpRoutes.end();) {
+        UdpRoute* route = it.value();
+        if (now - route->lastActiveUs <= ROUTE_TIMEOUT * 1000LL) {
+            ++it;
+            continue;
+        }
+        routeIds.remove(QString("%1:%2").arg(route->clientAddress.toString()).arg(route->clientPort));
+        route->upstream->deleteLater();
+        delete route;
+        it = udpRoutes.erase(it);
+    }
+}
+
+void NetemProxy::applyPhase(int index)
+{
+    phaseIndex = index;
+    const Phase& phase = profile.phases.at(index);
+    impairment = phase.impairment;
+    qInfo() << "Netem phase" << phase.name << "latency" << impairment.latency << "jitter" << impairment.jitter
+            << "loss" << impairment.loss << "reorder" << impairment.reorder << "bandwidth" << impairment.bandwidth;
+
+    if (index + 1 < profile.phases.size()) {
+        phaseTimer->start((profile.phases.at(index + 1).at - phase.at) * 1000);
+    } else if (profile.loopPeriod > 0) {
+        phaseTimer->start((profile.loopPeriod - phase.at) * 1000);
+    } else {
+        phaseTimer->stop();
+    }
+}
+
+void NetemProxy::onPhaseTimeout()
+{
+    applyPhase((phaseIndex + 1) % profile.phases.size());
+}
@@ -0,0 +1,166 @@
+#ifndef NETEMPROXY_H
+#define NETEMPROXY_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include <map>
+
+class QTcpServer;
+class QTcpSocket;
+class QUdpSocket;
+
+/**
+ * 网络损伤代理
+ * 位于客户端和主机之间，转发TCP连接和状态通道UDP，按配置注入延迟、抖动、丢包、乱序和带宽限制，
+ * 用于在一台机器上复现热点网络下的预测、插值和自适应快照频率表现
+ * 特点：
+ * 1. 客户端连接代理的TCP端口和紧随其后的UDP端口，代理为每个客户端单独向主机建立连接和UDP端点，
+ *    主机看到的每个客户端仍然是独立的对端
+ * 2. 每个方向先按带宽排队再加延迟和抖动；UDP数据报按丢包率丢弃、按乱序率额外推迟，带宽队列过长时尾部丢弃；
+ *    TCP保持字节顺序，“丢包”表现为等待重传的停顿，后续数据一起被阻塞
+ * 3. 损伤参数由内置档位或JSON文件给出，文件可以按时间分阶段切换档位，模拟网络逐渐变差或恢复
+ */
+class NetemProxy : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 每个方向各自施加的损伤
+    struct Impairment {
+        int latency = 0;       // 单向延迟(ms)
+        int jitter = 0;        // 延迟的随机波动范围(±ms)
+        double loss = 0.0;     // 丢包率(%)
+        double reorder = 0.0;  // UDP乱序率(%)
+        int bandwidth = 0;     // 每个连接每个方向的带宽(KB/s)，0表示不限
+    };
+
+    // 从开始转发后第 at 秒起生效的损伤
+    struct Phase {
+        int at = 0;
+        QString name;
+        Impairment impairment;
+    };
+
+    struct Profile {
+        QString name;
+        QVector<Phase> phases;   // 按 at 升序
+        int loopPeriod = 0;      // 大于0时每隔这么多秒从第一个阶段重新开始
+    };
+
+    struct Options {
+        QHostAddress listenAddress = QHostAddress::AnyIPv4;
+        quint16 listenPort = 24100;      // 客户端连接的TCP端口，状态通道使用 listenPort+1
+        QHostAddress targetAddress = QHostAddress::LocalHost;
+        quint16 targetPort = 23456;      // HotspotNetworkManager 的默认端口
+        quint16 targetStatePort = 23460;
+        quint32 seed = 1;
+    };
+
+    explicit NetemProxy(const Options& options, QObject *parent = nullptr);
+    ~NetemProxy();
+
+    bool start();
+    void setProfile(const Profile& profile);
+    Impairment currentImpairment() const { return impairment; }
+    QJsonObject stats() const;
+
+    // spec 为内置档位名或JSON文件路径；失败时 error 给出原因
+    static bool loadProfile(const QString& spec, Profile* profile, QString* error);
+    static QStringList builtinProfileNames();
+
+private slots:
+    void onNewConnection();
+    void onListenDatagram();
+    void onPhaseTimeout();
+    void onRouteExpiryTimeout();
+    void dispatch();
+
+private:
+    enum class Direction { ToHost, ToClient };
+
+    // 一个方向上的带宽队列和TCP顺序约束，时间都是 clock 上的微秒
+    struct Pipe {
+        qint64 wireFreeUs = 0;   // 带宽队列排空的时间
+        qint64 lastDueUs = 0;    // 最后一段TCP数据的送达时间，后续数据不早于它
+    };
+
+    struct TcpLink {
+        QTcpSocket* client;
+        QTcpSocket* upstream;
+        Pipe toHost;
+        Pipe toClient;
+        bool closing = false;
+    };
+
+    struct UdpRoute {
+        QUdpSocket* upstream;    // 代替该客户端与主机通信的本地端点
+        QHostAddress clientAddress;
+        quint16 clientPort;
+        Pipe toHost;
+        Pipe toClient;
+        qint64 lastActiveUs;
+    };
+
+    struct Delivery {
+        bool stream;             // TCP或UDP
+        Direction direction;
+        quint64 id;              // 连接或UDP端点编号，送达前已关闭的直接丢弃
+        QByteArray data;
+        bool close;              // TCP关闭，随数据按顺序到达另一端
+    };
+
+    struct Counters {
+        quint64 packets = 0;
+        quint64 bytes = 0;
+        quint64 lost = 0;
+        quint64 overflow = 0;
+        quint64 reordered = 0;
+        quint64 stalls = 0;
+    };
+
+    qint64 nowUs() const { return clock.nsecsElapsed() / 1000; }
+    void schedule(Pipe& pipe, bool stream, Direction direction, quint64 id, const QByteArray& data);
+    void scheduleClose(quint64 id, Direction direction);
+    void deliver(const Delivery& delivery);
+    void armDispatchTimer();
+    void onTcpReadyRead(quint64 id, Direction direction);
+    void closeLink(quint64 id);
+    void applyPhase(int index);
+    static QJsonObject countersToJson(const Counters& counters);
+
+    Options options;
+    Profile profile;
+    Impairment impairment;
+    int phaseIndex;
+    QElapsedTimer clock;
+    QRandomGenerator random;
+
+    QTcpServer* tcpServer;
+    QUdpSocket* listenSocket;
+    QHash<quint64, TcpLink*> tcpLinks;
+    QHash<quint64, UdpRoute*> udpRoutes;
+    QHash<QString, quint64> routeIds;  // "地址:端口" -> UDP端点编号
+    quint64 nextId;
+
+    std::multimap<qint64, Delivery> deliveries;  // 按送达时间排序，同一时间按加入顺序
+    Counters counters[2];                        // 按 Direction 索引
+
+    QTimer* dispatchTimer;
+    QTimer* phaseTimer;
+    QTimer* routeExpiryTimer;
+
+    static const int RETRANSMIT_PENALTY = 200;   // TCP丢包后的重传等待(ms)，取Linux的最小RTO
+    static const int REORDER_DELAY = 30;         // 乱序数据报额外推迟的时间(ms)，让后面的数据报先到
+    static const int UDP_QUEUE_LIMIT = 300;      // UDP带宽队列的最大排队时间(ms)，超过时丢弃
+    static const int ROUTE_TIMEOUT = 30000;      // UDP端点空闲多久后回收(ms)
+    static const int ROUTE_EXPIRY_INTERVAL = 10000;
+};
+
+#endif // NETEMPROXY_H
@@ -1,15 +1,20 @@
 #include "oceanbackground.h"
+#include "frameprofiler.h"
 #include <QPainter>
 #include <QLinearGradient>
 #include <QRadialGradient>
 #include <QRandomGenerator>
 #include <QDebug>
 #include <QPainterPath>
+#include <QPaintEvent>
+#include <QtMath>
 
 OceanBackground::OceanBackground(QWidget *parent)
     : QWidget(parent)
-    , bubbleTimer(new QTimer(this))
-    , newBubbleTimer(new QTimer(this))
+    , bubbleTimer(new FrameTimer(this))
+    , newBubbleTimer(new FrameTimer(this))
+    , bubblePool(MAX_BUBBLES)
+    , spriteDevicePixelRatio(0.0)
 {
     // 设置背景透明，让我们可以绘制自定义背景
     setAttribute(Qt::WA_OpaquePaintEvent, false);
@@ -18,9 +23,13 @@ OceanBackground::OceanBackground(QWidget *parent)
     // 直接使用渐变背景，不加载图片
     qDebug() << "Using gradient background instead of image";
     
+    // 气泡上浮并轻微左右摆动，完全越过顶部后回收
+    bubblePool.setSway(2.0f, 0.01f);
+    bubblePool.setTopLimit(0.0f);
+    
     // 初始化定时器
-    connect(bubbleTimer, &QTimer::timeout, this, &OceanBackground::updateBubbles);
-    connect(newBubbleTimer, &QTimer::timeout, this, &OceanBackground::createNewBubble);
+    connect(bubbleTimer, &FrameTimer::timeout, this, &OceanBackground::updateBubbles);
+    connect(newBubbleTimer, &FrameTimer::timeout, this, &OceanBackground::createNewBubble);
     
     bubbleTimer->start(BUBBLE_UPDATE_INTERVAL);
     newBubbleTimer->start(BUBBLE_CREATE_INTERVAL);
@@ -30,24 +39,27 @@ OceanBackground::OceanBackground(QWidget *parent)
 
 OceanBackground::~OceanBackground()
 {
-    // 清理气泡动画
-    for (auto bubble : bubbles) {
-        if (bubble->animation) {
-            bubble->animation->stop();
-            delete bubble->animation;
-        }
-        delete bubble;
-    }
-    bubbles.clear();
 }
 
 void OceanBackground::paintEvent(QPaintEvent *event)
 {
+    ProfileScope profile(ProfilePhase::Background);
+    
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    
+    // 只重绘脏区域（气泡移动时只更新气泡所在的矩形）
+    painter.setClipRegion(event->region());
+    
+    // 屏幕像素比变化（窗口移动到其他屏幕）时重建缓存
+    if (staticLayer.size() != size() * devicePixelRatioF()) {
+        rebuildStaticLayer();
+    }
+    if (!qFuzzyCompare(spriteDevicePixelRatio, devicePixelRatioF())) {
+        rebuildBubbleSprites();
+    }
     
     // 绘制海洋背景
-    drawOceanBackground(painter);
+    painter.drawPixmap(0, 0, staticLayer);
     
     // 绘制气泡（在背景层，不会遮挡UI元素）
     drawBubbles(painter);
@@ -56,7 +68,77 @@ void OceanBackground::paintEvent(QPaintEvent *event)
 void OceanBackground::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
-    // 渐变背景会自动适应新尺寸，无需额外处理
+    // 渐变和波纹只依赖尺寸，在这里重建一次缓存
+    rebuildStaticLayer();
+}
+
+void OceanBackground::rebuildStaticLayer()
+{
+    const qreal dpr = devicePixelRatioF();
+    staticLayer = QPixmap(size() * dpr);
+    staticLayer.setDevicePixelRatio(dpr);
+    staticLayer.fill(Qt::transparent);
+    
+    QPainter painter(&staticLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
+    drawOceanBackground(painter);
+}
+
+void OceanBackground::rebuildBubbleSprites()
+{
+    spriteDevicePixelRatio = devicePixelRatioF();
+    bubbleSprites.clear();
+    
+    const int radiusLevels = (MAX_BUBBLE_RADIUS - MIN_BUBBLE_RADIUS) / BUBBLE_RADIUS_STEP + 1;
+    bubbleSprites.reserve(radiusLevels * BUBBLE_OPACITY_LEVELS);
+    
+    for (int r = 0; r < radiusLevels; ++r) {
+        const float radius = MIN_BUBBLE_RADIUS + r * BUBBLE_RADIUS_STEP;
+        for (int o = 0; o < BUBBLE_OPACITY_LEVELS; ++o) {
+            // 透明度档位均匀分布在0.3-0.8之间
+            const float opacity = 0.3f + 0.5f * (o + 0.5f) / BUBBLE_OPACITY_LEVELS;
+            
+            // 多留1像素给描边
+            const int extent = static_cast<int>(radius) * 2 + 2;
+            QPixmap sprite(QSize(extent, extent) * spriteDevicePixelRatio);
+            sprite.setDevicePixelRatio(spriteDevicePixelRatio);
+            sprite.fill(Qt::transparent);
+            
+            QPainter painter(&sprite);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setOpacity(0.6); // 气泡半透明，不会太显眼
+            
+            const QPointF center(extent / 2.0, extent / 2.0);
+            QRadialGradient bubbleGradient(center, radius);
+            bubbleGradient.setColorAt(0.0, QColor(255, 255, 255, opacity * 180));
+            bubbleGradient.setColorAt(0.7, QColor(173, 216, 230, opacity * 120));
+            bubbleGradient.setColorAt(1.0, QColor(135, 206, 250, opacity * 60));
+            
+            painter.setBrush(bubbleGradient);
+            painter.setPen(QPen(QColor(255, 255, 255, opacity * 100), 1));
+            painter.drawEllipse(center, radius, radius);
+            
+            bubbleSprites.append(sprite);
+        }
+    }
+}
+
+const QPixmap& OceanBackground::bubbleSprite(float radius, float opacity) const
+{
+    const int radiusLevels = (MAX_BUBBLE_RADIUS - MIN_BUBBLE_RADIUS) / BUBBLE_RADIUS_STEP + 1;
+    int r = qRound((radius - MIN_BUBBLE_RADIUS) / BUBBLE_RADIUS_STEP);
+    r = qBound(0, r, radiusLevels - 1);
+    int o = static_cast<int>((opacity - 0.3f) / 0.5f * BUBBLE_OPACITY_LEVELS);
+    o = qBound(0, o, BUBBLE_OPACITY_LEVELS - 1);
+    return bubbleSprites[r * BUBBLE_OPACITY_LEVELS + o];
+}
+
+QRect OceanBackground::bubbleBounds(int index) const
+{
+    // 按最大档位估算，留出描边和取整余量
+    const int extent = MAX_BUBBLE_RADIUS + 2;
+    return QRect(qFloor(bubblePool.x(index)) - extent, qFloor(bubblePool.y(index)) - extent,
+                 extent * 2 + 1, extent * 2 + 1);
 }
 
 void OceanBackground::drawOceanBackground(QPainter &painter)
@@ -93,23 +175,12 @@ void OceanBackground::drawOceanBackground(QPainter &painter)
 
 void OceanBackground::drawBubbles(QPainter &painter)
 {
-    painter.setOpacity(0.6); // 气泡半透明，不会太显眼
-    
-    for (const auto& bubble : bubbles) {
-        if (bubble->position.y() > -bubble->radius * 2) {
-            // 创建气泡的渐变效果
-            QRadialGradient bubbleGradient(bubble->position, bubble->radius);
-            bubbleGradient.setColorAt(0.0, QColor(255, 255, 255, bubble->opacity * 180));
-            bubbleGradient.setColorAt(0.7, QColor(173, 216, 230, bubble->opacity * 120));
-            bubbleGradient.setColorAt(1.0, QColor(135, 206, 250, bubble->opacity * 60));
-            
-            painter.setBrush(bubbleGradient);
-            painter.setPen(QPen(QColor(255, 255, 255, bubble->opacity * 100), 1));
-            painter.drawEllipse(bubble->position, bubble->radius, bubble->radius);
-        }
+    // 使用预渲染精灵，整体透明度已烘焙进精灵中
+    for (int i = 0; i < bubblePool.count(); ++i) {
+        const QPixmap& sprite = bubbleSprite(bubblePool.radius(i), bubblePool.opacity(i));
+        const qreal half = sprite.width() / sprite.devicePixelRatio() / 2.0;
+        painter.drawPixmap(QPointF(bubblePool.x(i) - half, bubblePool.y(i) - half), sprite);
     }
-    
-    painter.setOpacity(1.0);
 }
 
 void OceanBackground::initializeBubbles()
@@ -122,51 +193,38 @@ void OceanBackground::initializeBubbles()
 
 void OceanBackground::createNewBubble()
 {
-    if (bubbles.size() >= MAX_BUBBLES) {
+    if (bubblePool.isFull()) {
         return;
     }
     
-    Bubble* bubble = new Bubble;
-    
     // 随机位置和大小
-    bubble->position = QPointF(
-        QRandomGenerator::global()->bounded(0, width()),
-        height() + 50
-    );
-    bubble->radius = QRandomGenerator::global()->bounded(10, 30);
-    bubble->speed = QRandomGenerator::global()->bounded(100, 300) / 100.0; // 1.0 to 3.0
-    bubble->opacity = QRandomGenerator::global()->bounded(30, 80) / 100.0; // 0.3 to 0.8
-    bubble->animation = nullptr;
-    
-    bubbles.append(bubble);
+    const float x = QRandomGenerator::global()->bounded(0, qMax(1, width()));
+    const float y = height() + 50;
+    const float radius = QRandomGenerator::global()->bounded(MIN_BUBBLE_RADIUS, MAX_BUBBLE_RADIUS);
+    const float speed = QRandomGenerator::global()->bounded(100, 300) / 100.0f; // 1.0 to 3.0
+    const float opacity = QRandomGenerator::global()->bounded(30, 80) / 100.0f; // 0.3 to 0.8
+    
+    // 速度以“每次更新移动的像素”为单位，向上为负
+    bubblePool.spawn(x, y, 0.0f, -speed, radius, opacity);
 }
 
 void OceanBackground::updateBubbles()
 {
-    // 更新气泡位置
-    for (auto it = bubbles.begin(); it != bubbles.end();) {
-        Bubble* bubble = *it;
-        
-        // 向上移动气泡
-        bubble->position.setY(bubble->position.y() - bubble->speed);
-        
-        // 添加轻微的水平摆动
-        float sway = 2.0 * qSin(bubble->position.y() * 0.01);
-        bubble->position.setX(bubble->position.x() + sway);
-        
-        // 如果气泡移出屏幕，删除它
-        if (bubble->position.y() < -bubble->radius * 2) {
-            if (bubble->animation) {
-                bubble->animation->stop();
-                delete bubble->animation;
-            }
-            delete bubble;
-            it = bubbles.erase(it);
-        } else {
-            ++it;
-        }
+    // 只收集气泡移动前后覆盖的区域，避免整窗重绘
+    QRegion dirtyRegion;
+    for (int i = 0; i < bubblePool.count(); ++i) {
+        dirtyRegion += bubbleBounds(i);
+    }
+    
+    // 更新气泡位置，移出屏幕的气泡原地回收
+    bubblePool.update(1.0f);
+    
+    for (int i = 0; i < bubblePool.count(); ++i) {
+        dirtyRegion += bubbleBounds(i);
     }
     
     // 触发重绘
-    update();
-}
\ No newline at end of file
+    if (!dirtyRegion.isEmpty()) {
+        update(dirtyRegion);
+    }
+}
@@ -2,23 +2,13 @@
 #define OCEANBACKGROUND_H
 
 #include <QWidget>
-#include <QTimer>
+#include "framescheduler.h"
 #include <QPainter>
-#include <QPropertyAnimation>
-#include <QParallelAnimationGroup>
-#include <QSequentialAnimationGroup>
-#include <QGraphicsOpacityEffect>
 #include <QRandomGenerator>
 #include <QPixmap>
 #include <QResizeEvent>
-
-struct Bubble {
-    QPointF position;
-    float radius;
-    float speed;
-    float opacity;
-    QPropertyAnimation* animation;
-};
+#include <QVector>
+#include "particlesystem.h"
 
 class OceanBackground : public QWidget
 {
@@ -42,11 +32,25 @@ private:
     void drawOceanBackground(QPainter &painter);
     void drawBubbles(QPainter &painter);
     
-    QTimer *bubbleTimer;
-    QTimer *newBubbleTimer;
-    QList<Bubble*> bubbles;
+    // 优化：静态层（渐变+波纹）只在尺寸变化时重建，气泡使用预渲染精灵
+    void rebuildStaticLayer();
+    void rebuildBubbleSprites();
+    const QPixmap& bubbleSprite(float radius, float opacity) const;
+    QRect bubbleBounds(int index) const;
+    
+    FrameTimer *bubbleTimer;
+    FrameTimer *newBubbleTimer;
+    ParticleSystem bubblePool;      // 固定容量的气泡粒子池
+    
+    QPixmap staticLayer;            // 渐变背景和波纹的缓存
+    QVector<QPixmap> bubbleSprites; // 按半径档位×透明度档位预渲染的气泡
+    qreal spriteDevicePixelRatio;
     
     static const int MAX_BUBBLES = 15;
+    static const int MIN_BUBBLE_RADIUS = 10;
+    static const int MAX_BUBBLE_RADIUS = 30;
+    static const int BUBBLE_RADIUS_STEP = 5;   // 半径档位间隔
+    static const int BUBBLE_OPACITY_LEVELS = 3; // 透明度档位数
     static const int BUBBLE_CREATE_INTERVAL = 2000; // 2秒创建一个新气泡
     static const int BUBBLE_UPDATE_INTERVAL = 50;   // 50ms更新一次
 };
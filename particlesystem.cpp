@@ -0,0 +1,97 @@
+#include "particlesystem.h"
+#include <cmath>
+#include <limits>
+
+ParticleSystem::ParticleSystem(int capacity)
+    : maxParticles(capacity)
+    , activeCount(0)
+    , posX(capacity)
+    , posY(capacity)
+    , velX(capacity)
+    , velY(capacity)
+    , accelY(capacity)
+    , radii(capacity)
+    , opacities(capacity)
+    , life(capacity)
+    , maxLife(capacity)
+    , colors(capacity)
+    , swayAmplitude(0.0f)
+    , swayFrequency(0.0f)
+    , topLimit(-std::numeric_limits<float>::max())
+{
+}
+
+int ParticleSystem::spawn(float x, float y, float vx, float vy, float radius, float opacity,
+                          float lifetime, QRgb color, float gravity)
+{
+    if (activeCount >= maxParticles) {
+        return -1;
+    }
+
+    const int i = activeCount++;
+    posX[i] = x;
+    posY[i] = y;
+    velX[i] = vx;
+    velY[i] = vy;
+    accelY[i] = gravity;
+    radii[i] = radius;
+    opacities[i] = opacity;
+    life[i] = lifetime;
+    maxLife[i] = lifetime;
+    colors[i] = color;
+    return i;
+}
+
+void ParticleSystem::update(float dt)
+{
+    const int n = activeCount;
+    float* px = posX.data();
+    float* py = posY.data();
+    float* vx = velX.data();
+    float* vy = velY.data();
+    const float* ay = accelY.data();
+    float* lf = life.data();
+
+    // 积分：纯数组运算，无分支，可被向量化
+    for (int i = 0; i < n; ++i) {
+        vy[i] += ay[i] * dt;
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        lf[i] -= dt;
+    }
+
+    // 水平摆动（气泡使用），只在启用时计算正弦
+    if (swayAmplitude != 0.0f) {
+        for (int i = 0; i < n; ++i) {
+            px[i] += swayAmplitude * std::sin(py[i] * swayFrequency) * dt;
+        }
+    }
+
+    // 回收：倒序遍历，交换删除不会跳过尚未检查的粒子
+    for (int i = n - 1; i >= 0; --i) {
+        const bool expired = maxLife[i] > 0.0f && life[i] <= 0.0f;
+        const bool outOfTop = posY[i] < topLimit - radii[i] * 2.0f;
+        if (expired || outOfTop) {
+            removeAt(i);
+        }
+    }
+}
+
+void ParticleSystem::removeAt(int index)
+{
+    const int last = --activeCount;
+    if (index == last) {
+        return;
+    }
+
+    posX[index] = posX[last];
+    posY[index] = posY[last];
+    velX[index] = velX[last];
+    velY[index] = velY[last];
+    accelY[index] = accelY[last];
+    radii[index] = radii[last];
+    opacities[index] = opacities[last];
+    life[index] = life[last];
+    maxLife[index] = maxLife[last];
+    colors[index] = colors[last];
+}
@@ -0,0 +1,74 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <vector>
+
+/**
+ * 固定容量的粒子池（结构数组布局）
+ * 用于背景气泡以及吃食物、死亡等游戏特效
+ * 特点：
+ * 1. 位置、速度、半径、透明度等属性分别存放在连续数组中，更新循环可被编译器向量化
+ * 2. 容量在构造时一次性分配，之后生成和回收粒子都不再分配内存
+ * 3. 粒子死亡时与末尾粒子交换后删除，存活粒子始终紧凑排列在 [0, count) 区间
+ */
+class ParticleSystem
+{
+public:
+    explicit ParticleSystem(int capacity);
+
+    // 生成粒子，池已满时返回-1；lifetime <= 0 表示不按寿命回收
+    // gravity 为该粒子的竖直加速度，同一个池中不同特效的粒子可以各不相同
+    int spawn(float x, float y, float vx, float vy, float radius, float opacity,
+              float lifetime = 0.0f, QRgb color = qRgb(255, 255, 255), float gravity = 0.0f);
+
+    // 按时间步长推进所有粒子，并回收寿命耗尽或越过上边界的粒子
+    void update(float dt);
+    void clear() { activeCount = 0; }
+
+    // 全局运动参数
+    void setSway(float amplitude, float frequency) { swayAmplitude = amplitude; swayFrequency = frequency; }
+    void setTopLimit(float y) { topLimit = y; }  // 粒子底部越过该线时回收（用于上浮的气泡）
+
+    int count() const { return activeCount; }
+    int capacity() const { return maxParticles; }
+    bool isEmpty() const { return activeCount == 0; }
+    bool isFull() const { return activeCount >= maxParticles; }
+
+    // 只读访问，下标范围 [0, count())
+    float x(int i) const { return posX[i]; }
+    float y(int i) const { return posY[i]; }
+    float radius(int i) const { return radii[i]; }
+    float opacity(int i) const { return opacities[i]; }
+    QRgb color(int i) const { return colors[i]; }
+
+    // 考虑寿命衰减后的透明度（寿命型粒子逐渐淡出）
+    float fadedOpacity(int i) const
+    {
+        return maxLife[i] > 0.0f ? opacities[i] * (life[i] / maxLife[i]) : opacities[i];
+    }
+
+private:
+    void removeAt(int index);
+
+    int maxParticles;
+    int activeCount;
+
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> velX;
+    std::vector<float> velY;
+    std::vector<float> accelY;
+    std::vector<float> radii;
+    std::vector<float> opacities;
+    std::vector<float> life;
+    std::vector<float> maxLife;
+    std::vector<QRgb> colors;
+
+    float swayAmplitude;
+    float swayFrequency;
+    float topLimit;
+};
+
+#endif // PARTICLESYSTEM_H
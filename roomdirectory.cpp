@@ -0,0 +1,131 @@
+#include "roomdirectory.h"
+#include <QDebug>
+
+RoomDirectory::RoomDirectory(QObject *parent)
+    : QAbstractListModel(parent)
+    , expiryTimer(new QTimer(this))
+{
+    clock.start();
+    expiryTimer->setSingleShot(false);
+    connect(expiryTimer, &QTimer::timeout, this, &RoomDirectory::removeExpired);
+}
+
+int RoomDirectory::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : rooms.size();
+}
+
+QVariant RoomDirectory::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rooms.size()) {
+        return QVariant();
+    }
+
+    const Entry& room = rooms.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("%1 (%2/%3)").arg(room.roomName).arg(room.playerCount).arg(room.maxPlayers);
+    case Qt::ToolTipRole:
+        return QString("%1:%2").arg(room.hostAddress).arg(room.port);
+    case HostAddressRole:
+        return room.hostAddress;
+    case HostPortRole:
+        return room.port;
+    case HostStatePortRole:
+        return room.statePort;
+    case RoomNameRole:
+        return room.roomName;
+    case PlayerCountRole:
+        return room.playerCount;
+    case MaxPlayersRole:
+        return room.maxPlayers;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> RoomDirectory::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractListModel::roleNames();
+    names[HostAddressRole] = "hostAddress";
+    names[HostPortRole] = "port";
+    names[HostStatePortRole] = "statePort";
+    names[RoomNameRole] = "roomName";
+    names[PlayerCountRole] = "playerCount";
+    names[MaxPlayersRole] = "maxPlayers";
+    return names;
+}
+
+bool RoomDirectory::updateRoom(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers,
+                               quint16 port, quint16 statePort)
+{
+    const qint64 now = clock.elapsed();
+    const int row = indexOf(hostAddress, port);
+
+    if (row < 0) {
+        beginInsertRows(QModelIndex(), rooms.size(), rooms.size());
+        rooms.append({hostAddress, port, statePort, roomName, playerCount, maxPlayers, now});
+        endInsertRows();
+        if (!expiryTimer->isActive()) {
+            expiryTimer->start(EXPIRY_CHECK_INTERVAL);
+        }
+        qDebug() << "Room discovered:" << roomName << "at" << hostAddress << ":" << port;
+        return true;
+    }
+
+    // 绝大多数通告与缓存一致，只刷新时间，不打扰视图
+    Entry& room = rooms[row];
+    room.lastSeen = now;
+    if (room.roomName == roomName && room.playerCount == playerCount &&
+        room.maxPlayers == maxPlayers && room.statePort == statePort) {
+        return false;
+    }
+
+    room.roomName = roomName;
+    room.playerCount = playerCount;
+    room.maxPlayers = maxPlayers;
+    room.statePort = statePort;
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+    return true;
+}
+
+void RoomDirectory::clear()
+{
+    expiryTimer->stop();
+    if (rooms.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    rooms.clear();
+    endResetModel();
+}
+
+void RoomDirectory::removeExpired()
+{
+    const qint64 now = clock.elapsed();
+    // 从后往前删除，前面的行号不受影响
+    for (int row = rooms.size() - 1; row >= 0; --row) {
+        if (now - rooms.at(row).lastSeen <= ROOM_TTL) {
+            continue;
+        }
+        qDebug() << "Room expired:" << rooms.at(row).roomName << "at" << rooms.at(row).hostAddress;
+        beginRemoveRows(QModelIndex(), row, row);
+        rooms.remove(row);
+        endRemoveRows();
+    }
+
+    if (rooms.isEmpty()) {
+        expiryTimer->stop();
+    }
+}
+
+int RoomDirectory::indexOf(const QString& hostAddress, quint16 port) const
+{
+    for (int i = 0; i < rooms.size(); ++i) {
+        if (rooms.at(i).port == port && rooms.at(i).hostAddress == hostAddress) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,67 @@
+#ifndef ROOMDIRECTORY_H
+#define ROOMDIRECTORY_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * 已发现房间目录
+ * 缓存局域网发现到的房间，作为大厅房间列表的数据模型
+ * 特点：
+ * 1. 以主机地址和端口标识房间（专用服务器的多个房间地址相同，端口不同），重复的通告只刷新最后收到时间
+ * 2. 只有新房间、房间信息变化和房间过期时才通知视图，且只更新受影响的行
+ * 3. 超过 ROOM_TTL 没有再收到通告的房间自动移除
+ */
+class RoomDirectory : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        HostAddressRole = Qt::UserRole,
+        HostPortRole,
+        HostStatePortRole,
+        RoomNameRole,
+        PlayerCountRole,
+        MaxPlayersRole
+    };
+
+    explicit RoomDirectory(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // 记录一次房间通告，返回列表是否因此发生变化
+    bool updateRoom(const QString& hostAddress, const QString& roomName, int playerCount, int maxPlayers,
+                    quint16 port, quint16 statePort);
+    void clear();
+
+public slots:
+    void removeExpired();
+
+private:
+    struct Entry {
+        QString hostAddress;
+        quint16 port;
+        quint16 statePort;
+        QString roomName;
+        int playerCount;
+        int maxPlayers;
+        qint64 lastSeen;   // clock 上的毫秒数
+    };
+
+    int indexOf(const QString& hostAddress, quint16 port) const;
+
+    QVector<Entry> rooms;
+    QElapsedTimer clock;
+    QTimer* expiryTimer;
+
+    // 主机通告间隔最长16秒，客户端查询间隔最长8秒，留出一次丢包的余量
+    static const int ROOM_TTL = 20000;         // ms
+    static const int EXPIRY_CHECK_INTERVAL = 2000;
+};
+
+#endif // ROOMDIRECTORY_H
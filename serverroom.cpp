@@ -0,0 +1,136 @@
+#include "serverroom.h"
+#include <QJsonArray>
+#include <QDebug>
+
+ServerRoom::ServerRoom(const Config& config, QObject *parent)
+    : QObject(parent)
+    , config(config)
+    , networkManager(new HotspotNetworkManager(this))
+    , gameManager(new HotspotGameManager(this))
+    , statusTimer(new QTimer(this))
+    , resetTimer(new QTimer(this))
+{
+    // 房间广播由服务器统一发送，各房间只监听自己的端口
+    networkManager->setDedicatedServer(true);
+    networkManager->setDiscoveryEnabled(false);
+    networkManager->setHostPorts(config.tcpPort, config.statePort);
+    gameManager->setNetworkManager(networkManager);
+    gameManager->setGameSpeed(config.gameSpeed);
+    gameManager->setLockstepMode(config.lockstep);
+
+    resetTimer->setSingleShot(true);
+
+    connect(gameManager, &HotspotGameManager::playerReadyChanged, this, &ServerRoom::onPlayerReadyChanged);
+    connect(gameManager, &HotspotGameManager::playerJoined, this, &ServerRoom::tryAutoStart);
+    connect(gameManager, &HotspotGameManager::playerLeft, this, &ServerRoom::tryAutoStart);
+    connect(gameManager, &HotspotGameManager::gameEnded, this, &ServerRoom::onGameEnded);
+    connect(resetTimer, &QTimer::timeout, gameManager, &HotspotGameManager::resetGame);
+    connect(statusTimer, &QTimer::timeout, this, &ServerRoom::publishStatus);
+    connect(networkManager, &HotspotNetworkManager::networkError, this, [this](const QString& error) {
+        qWarning() << "Room" << this->config.roomName << "network error:" << error;
+    });
+}
+
+bool ServerRoom::start()
+{
+    // 专用服务器不占用玩家名额，房间内全部是远端玩家
+    if (!gameManager->createRoom(QString(), config.roomName, config.maxPlayers)) {
+        qWarning() << "Failed to start room" << config.roomName << "on port" << config.tcpPort;
+        return false;
+    }
+
+    statusTimer->start(STATUS_INTERVAL);
+    publishStatus();
+    return true;
+}
+
+void ServerRoom::onPlayerReadyChanged(const QString& playerName, bool ready)
+{
+    Q_UNUSED(playerName)
+    if (ready) {
+        tryAutoStart();
+    }
+}
+
+void ServerRoom::onGameEnded(const QString& winner)
+{
+    qInfo() << "Room" << config.roomName << "game ended, winner:" << (winner.isEmpty() ? QString("none") : winner);
+    resetTimer->start(RESET_DELAY);
+}
+
+void ServerRoom::publishStatus()
+{
+    const HotspotGameState state = gameManager->getGameState();
+    const QMap<QString, HotspotGameManager::ClientLinkInfo> links = gameManager->getClientLinkInfo();
+    const HotspotGameManager::TickTiming timing = gameManager->getTickTiming();
+    gameManager->resetTickPeak();
+
+    QString phase = "lobby";
+    if (state.isGameStarted) {
+        phase = state.isPaused ? "paused" : "running";
+    } else if (state.countdownTimer > 0) {
+        phase = "countdown";
+    }
+
+    QJsonArray players;
+    for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+        const QString& name = it.key();
+        const HotspotNetworkManager::LinkStats stats = networkManager->getLinkStats(name);
+        const HotspotGameManager::ClientLinkInfo link = links.value(name);
+        const HotspotNetworkManager::PeerProtocol protocol = networkManager->getPeerProtocol(name);
+
+        QJsonObject player;
+        player["name"] = name;
+        player["ready"] = state.playerReadyStatus.value(name, false);
+        player["alive"] = state.playerAliveStatus.value(name, false);
+        player["score"] = state.playerScores.value(name, 0);
+        player["rtt"] = stats.rtt;
+        player["jitter"] = stats.jitter;
+        player["loss"] = stats.lossPercent;
+        player["snapshotInterval"] = link.snapshotInterval;
+        player["backlog"] = static_cast<double>(link.backlog);
+        player["reconnecting"] = networkManager->isSessionSuspended(name);
+        player["protocol"] = protocol.version;
+        player["features"] = static_cast<int>(protocol.features);
+        players.append(player);
+    }
+
+    QJsonObject status;
+    status["room"] = config.roomName;
+    status["port"] = config.tcpPort;
+    status["statePort"] = config.statePort;
+    status["state"] = phase;
+    status["mode"] = gameManager->isLockstepMode() ? "lockstep" : "snapshot";
+    status["tick"] = static_cast<double>(state.tick);
+    status["maxPlayers"] = config.maxPlayers;
+    status["playerCount"] = players.size();
+    status["spectators"] = networkManager->getSpectatorCount();
+    status["tickAvgUs"] = qRound(timing.averageUs);
+    status["tickPeakUs"] = static_cast<double>(timing.peakUs);
+    status["players"] = players;
+    if (!state.gameWinner.isEmpty()) {
+        status["winner"] = state.gameWinner;
+    }
+    emit statusUpdated(status);
+}
+
+void ServerRoom::tryAutoStart()
+{
+    if (!config.autoStart || resetTimer->isActive()) {
+        return;
+    }
+
+    // 倒计时期间countdownTimer大于0，避免重复开局
+    const HotspotGameState state = gameManager->getGameState();
+    if (state.isGameStarted || state.countdownTimer > 0 || state.playerSnakes.size() < 2) {
+        return;
+    }
+    for (auto it = state.playerReadyStatus.constBegin(); it != state.playerReadyStatus.constEnd(); ++it) {
+        if (!it.value()) {
+            return;
+        }
+    }
+
+    qInfo() << "Room" << config.roomName << "all players ready, starting game";
+    gameManager->startGame();
+}
@@ -0,0 +1,63 @@
+#ifndef SERVERROOM_H
+#define SERVERROOM_H
+
+#include <QObject>
+#include <QTimer>
+#include <QJsonObject>
+#include "hotspotgamemanager.h"
+#include "hotspotnetworkmanager.h"
+
+/**
+ * 专用服务器中的一个房间
+ * 房间的网络连接和游戏模拟属于同一个对象树，整体移动到某个工作线程上运行
+ * 特点：
+ * 1. 套接字读写、模拟和快照发送都在房间所在线程完成，热路径上没有跨线程传递和加锁
+ * 2. 与主线程之间只通过排队信号交换每秒一次的房间状态
+ * 3. 所有玩家准备就绪后自动开局，一局结束后自动重置房间
+ */
+class ServerRoom : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        QString roomName;
+        int maxPlayers = 4;
+        int gameSpeed = 100;          // 逻辑帧间隔(ms)
+        bool lockstep = false;
+        bool autoStart = true;
+        quint16 tcpPort = HotspotNetworkManager::DEFAULT_PORT;
+        quint16 statePort = HotspotNetworkManager::STATE_PORT;
+    };
+
+    explicit ServerRoom(const Config& config, QObject *parent = nullptr);
+
+    // 须在房间所在线程调用（跨线程时使用BlockingQueuedConnection）
+    bool start();
+
+    // 构造后不再修改，可以在任意线程读取
+    const Config& getConfig() const { return config; }
+
+signals:
+    // 每 STATUS_INTERVAL 毫秒发布一次，tickAvgUs/tickPeakUs为该房间的逻辑帧耗时
+    void statusUpdated(const QJsonObject& status);
+
+private slots:
+    void onPlayerReadyChanged(const QString& playerName, bool ready);
+    void onGameEnded(const QString& winner);
+    void publishStatus();
+
+private:
+    void tryAutoStart();
+
+    Config config;
+    HotspotNetworkManager* networkManager;
+    HotspotGameManager* gameManager;
+    QTimer* statusTimer;
+    QTimer* resetTimer;
+
+    static const int STATUS_INTERVAL = 1000;  // ms
+    static const int RESET_DELAY = 5000;      // 一局结束后保留结果的时间(ms)，之后重置房间等待下一局
+};
+
+#endif // SERVERROOM_H
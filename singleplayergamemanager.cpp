@@ -1,5 +1,6 @@
 #include "singleplayergamemanager.h"
 #include "gamewidget.h"
+#include "frameprofiler.h"
 #include <QDebug>
 #include <QSettings>
 #include <QRandomGenerator>
@@ -25,15 +26,15 @@ SinglePlayerGameManager::SinglePlayerGameManager(QObject *parent)
     , settings(new QSettings("SnakeGame", "SinglePlayer", this))
 {
     // 初始化计时器
-    gameTimer = new QTimer(this);
-    modeTimer = new QTimer(this);
-    speedTimer = new QTimer(this);
-    aiMoveTimer = new QTimer(this);
+    gameTimer = new FrameTimer(this);
+    modeTimer = new FrameTimer(this);
+    speedTimer = new FrameTimer(this);
+    aiMoveTimer = new FrameTimer(this);
     
-    connect(gameTimer, &QTimer::timeout, this, &SinglePlayerGameManager::onGameTimer);
-    connect(modeTimer, &QTimer::timeout, this, &SinglePlayerGameManager::onModeTimer);
-    connect(speedTimer, &QTimer::timeout, this, &SinglePlayerGameManager::onSpeedTimer);
-    connect(aiMoveTimer, &QTimer::timeout, this, &SinglePlayerGameManager::updateAIMovement);
+    connect(gameTimer, &FrameTimer::timeout, this, &SinglePlayerGameManager::onGameTimer);
+    connect(modeTimer, &FrameTimer::timeout, this, &SinglePlayerGameManager::onModeTimer);
+    connect(speedTimer, &FrameTimer::timeout, this, &SinglePlayerGameManager::onSpeedTimer);
+    connect(aiMoveTimer, &FrameTimer::timeout, this, &SinglePlayerGameManager::updateAIMovement);
     
     // 初始化成就系统
     initializeAchievements();
@@ -1088,6 +1089,8 @@ void SinglePlayerGameManager::updateAIMovement()
         return;
     }
     
+    ProfileScope profile(ProfilePhase::Simulation);
+    
     qDebug() << "AI movement update called, aiSnake size:" << aiSnake.size() << ", foodPosition:" << foodPosition.x << "," << foodPosition.y;
     
     // 使用食物位置作为目标
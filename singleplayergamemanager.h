@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QTimer>
+#include "framescheduler.h"
 #include <QTime>
 #include <QSettings>
 #include <deque>
@@ -192,9 +193,9 @@ private:
     bool isPaused;
     
     // 计时器
-    QTimer* gameTimer;      // 主游戏计时器
-    QTimer* modeTimer;      // 模式特定计时器
-    QTimer* speedTimer;     // 速度变化计时器
+    FrameTimer* gameTimer;      // 主游戏计时器
+    FrameTimer* modeTimer;      // 模式特定计时器
+    FrameTimer* speedTimer;     // 速度变化计时器
     QTime gameStartTime;
     
     // AI蛇的目标食物位置
@@ -213,7 +214,7 @@ private:
     CharacterType aiSnakeCharacter;  // AI蛇的角色
     Direction aiDirection;      // AI移动方向
     Point aiTarget;             // AI目标食物位置
-    QTimer* aiMoveTimer;        // AI移动计时器
+    FrameTimer* aiMoveTimer;        // AI移动计时器
     
     // 成就系统
     QList<Achievement> achievements;
@@ -1,14 +1,16 @@
 #include "snake.h"
 #include <QPixmap>
 #include <QDebug>
-#include <QSvgRenderer>
-#include <QPainter>
+#include <QGuiApplication>
+#include "svgrasterizer.h"
 
 Snake::Snake(QObject *parent)
     : QObject(parent)
     , currentDirection(Direction::RIGHT)
     , nextDirection(Direction::RIGHT)
     , character(CharacterType::SPONGEBOB)
+    , spriteSize(DEFAULT_SPRITE_SIZE)
+    , spriteDevicePixelRatio(qApp->devicePixelRatio())
 {
     loadCharacterPixmaps();
 }
@@ -129,41 +131,36 @@ void Snake::loadCharacterPixmaps()
         break;
     }
     
-    // 使用QSvgRenderer加载SVG文件
-    QString headPath = basePath + characterName + "_head.svg";
-    QString bodyPath = basePath + characterName + "_body.svg";
+    // SVG由SvgRasterizer按物理像素尺寸栅格化，这里预热一次缓存
+    headSvgPath = basePath + characterName + "_head.svg";
+    bodySvgPath = basePath + characterName + "_body.svg";
     
-    QSvgRenderer headRenderer;
-    QSvgRenderer bodyRenderer;
-    headRenderer.load(QString(headPath));
-    bodyRenderer.load(QString(bodyPath));
+    getHeadPixmap();
+    getBodyPixmap();
+}
+
+void Snake::setSpriteSize(int logicalSize, qreal devicePixelRatio)
+{
+    if (logicalSize == spriteSize && qFuzzyCompare(devicePixelRatio, spriteDevicePixelRatio)) {
+        return;
+    }
     
-    // 使用统一的大小（20x20像素，与cellSize相同）
-    const int pixmapSize = 20;
+    spriteSize = logicalSize;
+    spriteDevicePixelRatio = devicePixelRatio;
     
-    if (headRenderer.isValid()) {
-        qDebug() << "Successfully loaded head SVG:" << headPath;
-        headPixmap = QPixmap(pixmapSize, pixmapSize);
-        headPixmap.fill(Qt::transparent);
-        QPainter painter(&headPixmap);
-        headRenderer.render(&painter);
-    } else {
-        qDebug() << "Failed to load head SVG:" << headPath;
-        headPixmap = QPixmap(pixmapSize, pixmapSize);
-        headPixmap.fill(Qt::darkGreen);
-    }
+    SvgRasterizer::instance()->prefetch(headSvgPath, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
+    SvgRasterizer::instance()->prefetch(bodySvgPath, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
+}
 
-    if (bodyRenderer.isValid()) {
-        qDebug() << "Successfully loaded body SVG:" << bodyPath;
-        bodyPixmap = QPixmap(pixmapSize, pixmapSize);
-        bodyPixmap.fill(Qt::transparent);
-        QPainter painter(&bodyPixmap);
-        bodyRenderer.render(&painter);
-    } else {
-        qDebug() << "Failed to load body SVG:" << bodyPath;
-        bodyPixmap = QPixmap(pixmapSize, pixmapSize);
-        bodyPixmap.fill(Qt::green);
-    }
+QPixmap Snake::getHeadPixmap() const
+{
+    // 目标尺寸未就绪时返回上一次的尺寸，加载失败时返回空位图由调用方备用绘制
+    return SvgRasterizer::instance()->pixmap(headSvgPath, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
+}
+
+QPixmap Snake::getBodyPixmap() const
+{
+    return SvgRasterizer::instance()->pixmap(bodySvgPath, QSize(spriteSize, spriteSize), spriteDevicePixelRatio);
 }
 
 bool Snake::canChangeDirection(Direction newDir) const
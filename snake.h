@@ -29,8 +29,11 @@ public:
     Direction getDirection() const { return currentDirection; }
     CharacterType getCharacter() const { return character; }
     
-    QPixmap getHeadPixmap() const { return headPixmap; }
-    QPixmap getBodyPixmap() const { return bodyPixmap; }
+    QPixmap getHeadPixmap() const;
+    QPixmap getBodyPixmap() const;
+    
+    // 设置精灵的逻辑尺寸和设备像素比，新尺寸在后台栅格化
+    void setSpriteSize(int logicalSize, qreal devicePixelRatio);
     
     int getLength() const { return body.size(); }
     bool canChangeDirection(Direction newDir) const;
@@ -38,13 +41,17 @@ public:
 private:
     void loadCharacterPixmaps();
     
+    static const int DEFAULT_SPRITE_SIZE = 20;
+    
     std::deque<Point> body;
     Direction currentDirection;
     Direction nextDirection;
     CharacterType character;
     
-    QPixmap headPixmap;
-    QPixmap bodyPixmap;
+    QString headSvgPath;
+    QString bodySvgPath;
+    int spriteSize;
+    qreal spriteDevicePixelRatio;
 };
 
 #endif // SNAKE_H
\ No newline at end of file
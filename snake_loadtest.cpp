@@ -0,0 +1,731 @@
+// 热点联机压力测试
+// 在一个进程内启动专用主机，通过回环地址连接N个虚拟客户端，每个客户端用简单的贪心策略操控自己的蛇，
+// 跑完一局后输出主机逻辑帧耗时、每个客户端的上下行带宽、快照延迟分位数和内存增长。
+// 主机在主线程运行，虚拟客户端分布在工作线程上，客户端自身的开销不计入主机的逻辑帧耗时。
+//
+// 用法：snake_loadtest [--clients N] [--threads N] [--speed ms] [--grid WxH] [--lockstep]
+//                      [--duration 秒] [--base-port 端口] [--seed N] [--netem 档位]
+//                      [--disable-features delta,udp,compression] [--csv]
+//   --netem 档位          客户端经过独立线程上的NetemProxy连接主机，档位为内置名称或JSON文件
+//   --disable-features    虚拟客户端不声明这些协议特性，用于对比单个优化的效果
+//   某一秒内的逻辑帧耗时峰值超过 --speed 或有客户端没能加入时返回非零退出码，用于回归检查
+
+#include "hotspotnetworkmanager.h"
+#include "hotspotgamemanager.h"
+#include "snakesimulation.h"
+#include "netemproxy.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+struct LoadTestOptions {
+    int clients = 8;
+    int threads = 0;              // 客户端工作线程数，0表示按CPU核数
+    int gameSpeed = 100;          // 逻辑帧间隔(ms)
+    int gridWidth = 40;           // 与HotspotGameManager的默认地图相同
+    int gridHeight = 30;
+    bool lockstep = false;
+    int duration = 60;            // 一局的最长时间(秒)，到时由主机结束
+    quint16 basePort = 24600;     // 主机使用 basePort (TCP) 和 basePort+1 (状态通道UDP)，损伤代理使用 basePort+2 和 basePort+3
+    quint32 seed = 1;
+    bool netem = false;
+    NetemProxy::Profile netemProfile;
+    quint32 clientFeatures = HotspotProtocol::SUPPORTED_FEATURES;
+    bool csv = false;
+};
+
+// 进程常驻内存(KB)，主机和所有虚拟客户端合计；不支持的平台返回-1
+qint64 residentMemoryKb()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray& line : lines) {
+            if (line.startsWith("VmRSS:")) {
+                return line.mid(6).simplified().split(' ').first().toLongLong();
+            }
+        }
+    }
+#endif
+    return -1;
+}
+
+double percentile(QVector<double> samples, double p)
+{
+    if (samples.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const int index = qBound(0, static_cast<int>(std::ceil(p * samples.size())) - 1, samples.size() - 1);
+    return samples.at(index);
+}
+
+double average(const QVector<double>& samples)
+{
+    if (samples.isEmpty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    return sum / samples.size();
+}
+
+// 主机模拟完每个逻辑帧、发出快照之前的时间，客户端收到同一帧时据此计算快照延迟；主机和客户端线程共用
+class TickClock
+{
+public:
+    TickClock() { clock.start(); }
+
+    qint64 nowUs() const { return clock.nsecsElapsed() / 1000; }
+
+    void record(quint32 tick)
+    {
+        QMutexLocker locker(&mutex);
+        // 重新开局后帧号从头计数，只保留第一次的时间
+        if (!tickTimes.contains(tick)) {
+            tickTimes.insert(tick, nowUs());
+            tickTimes.remove(tick - TICK_HISTORY);
+        }
+    }
+
+    qint64 timeOf(quint32 tick) const
+    {
+        QMutexLocker locker(&mutex);
+        return tickTimes.value(tick, -1);
+    }
+
+private:
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QHash<quint32, qint64> tickTimes;
+
+    static const quint32 TICK_HISTORY = 1024;  // 只保留最近的帧，更晚到达的快照不计延迟
+};
+
+struct ClientResult {
+    QString name;
+    bool joined = false;
+    double downKBps = 0.0;
+    double upKBps = 0.0;
+    QVector<double> latenciesMs;
+    int unmatchedSnapshots = 0;   // 找不到主机时间戳的新帧（超出TICK_HISTORY），不计入延迟
+    int turns = 0;
+};
+
+/**
+ * 虚拟客户端
+ * 与真实客户端使用同一套网络和游戏管理器，运行在工作线程上
+ * 特点：
+ * 1. 连接后立即加入房间并准备，由主机在所有人准备后开局
+ * 2. 每收到一个新逻辑帧，选择不回头、不出界、不撞蛇且离食物最近的方向，带少量随机性
+ * 3. 从开局起统计上下行流量和快照延迟，结束时由主线程阻塞取回结果
+ */
+class VirtualClient : public QObject
+{
+public:
+    VirtualClient(const QString& name, const LoadTestOptions& options, const TickClock* tickClock, quint32 seed)
+        : name(name)
+        , options(options)
+        , tickClock(tickClock)
+        , random(seed)
+        , networkManager(new HotspotNetworkManager(this))
+        , gameManager(new HotspotGameManager(this))
+        , lastTick(0)
+        , matchStartUs(-1)
+    {
+        result.name = name;
+        networkManager->setLocalFeatures(options.clientFeatures);
+        gameManager->setNetworkManager(networkManager);
+        gameManager->setGridSize(options.gridWidth, options.gridHeight);
+
+        connect(networkManager, &HotspotNetworkManager::connectedToHost, this, [this]() {
+            result.joined = gameManager->joinRoom(this->name);
+            gameManager->setPlayerReady(this->name, true);
+        });
+        connect(networkManager, &HotspotNetworkManager::networkError, this, [this](const QString& error) {
+            qWarning() << "Virtual client" << this->name << "network error:" << error;
+        });
+        connect(gameManager, &HotspotGameManager::gameStateUpdated, this, [this](const HotspotGameState& state) {
+            onGameStateUpdated(state);
+        });
+    }
+
+    void start()
+    {
+        const quint16 port = options.netem ? static_cast<quint16>(options.basePort + 2) : options.basePort;
+        networkManager->connectToHost("127.0.0.1", port, static_cast<quint16>(port + 1));
+    }
+
+    ClientResult takeResult()
+    {
+        if (matchStartUs >= 0) {
+            const HotspotNetworkManager::TrafficStats traffic = networkManager->getTrafficStats();
+            const double seconds = qMax(0.001, (tickClock->nowUs() - matchStartUs) / 1000000.0);
+            const quint64 received = traffic.tcpBytesReceived + traffic.udpBytesReceived
+                                   - baseline.tcpBytesReceived - baseline.udpBytesReceived;
+            const quint64 sent = traffic.tcpBytesSent + traffic.udpBytesSent
+                               - baseline.tcpBytesSent - baseline.udpBytesSent;
+            result.downKBps = received / 1024.0 / seconds;
+            result.upKBps = sent / 1024.0 / seconds;
+        }
+        return result;
+    }
+
+private:
+    void onGameStateUpdated(const HotspotGameState& state)
+    {
+        if (!state.isGameStarted) {
+            return;
+        }
+        if (matchStartUs < 0) {
+            // 加入和倒计时阶段的流量不计入带宽
+            baseline = networkManager->getTrafficStats();
+            matchStartUs = tickClock->nowUs();
+        }
+        // 本地预测也会发出状态更新，只处理主机推进的新帧
+        if (state.tick <= lastTick) {
+            return;
+        }
+        lastTick = state.tick;
+
+        const qint64 tickTimeUs = tickClock->timeOf(state.tick);
+        if (tickTimeUs >= 0) {
+            result.latenciesMs.append((tickClock->nowUs() - tickTimeUs) / 1000.0);
+        } else {
+            ++result.unmatchedSnapshots;
+        }
+        steer(state);
+    }
+
+    void steer(const HotspotGameState& state)
+    {
+        const auto snake = state.playerSnakes.constFind(name);
+        if (snake == state.playerSnakes.constEnd() || snake->empty() || !state.playerAliveStatus.value(name, false)) {
+            return;
+        }
+
+        QSet<Point> occupied;
+        for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+            for (const Point& point : it.value()) {
+                occupied.insert(point);
+            }
+        }
+
+        const Point head = snake->front();
+        const Direction current = state.playerDirections.value(name, Direction::RIGHT);
+        Direction best = current;
+        int bestScore = INT_MAX;
+        for (Direction direction : {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT}) {
+            if (SnakeSimulation::isOppositeDirection(current, direction)) {
+                continue;
+            }
+            const Point next = SnakeSimulation::nextHeadPosition(head, direction);
+            if (next.x < 0 || next.y < 0 || next.x >= options.gridWidth || next.y >= options.gridHeight ||
+                occupied.contains(next)) {
+                continue;
+            }
+            const int distance = qAbs(next.x - state.foodPosition.x) + qAbs(next.y - state.foodPosition.y);
+            const int score = distance * DISTANCE_WEIGHT + static_cast<int>(random.bounded(RANDOM_WEIGHT));
+            if (score < bestScore) {
+                bestScore = score;
+                best = direction;
+            }
+        }
+
+        if (best != current) {
+            gameManager->updatePlayerDirection(name, best);
+            ++result.turns;
+        }
+    }
+
+    QString name;
+    LoadTestOptions options;
+    const TickClock* tickClock;
+    QRandomGenerator random;
+    HotspotNetworkManager* networkManager;
+    HotspotGameManager* gameManager;
+    quint32 lastTick;
+    qint64 matchStartUs;                         // tickClock上的开局时间，-1表示尚未开局
+    HotspotNetworkManager::TrafficStats baseline; // 开局时的流量计数
+    ClientResult result;
+
+    // 随机项小于两格距离差，只在几个方向同样好时打破平局，避免所有蛇走出相同的路线
+    static const int DISTANCE_WEIGHT = 4;
+    static const int RANDOM_WEIGHT = 6;
+};
+
+/**
+ * 压力测试主体
+ * 在主线程运行主机房间，虚拟客户端全部加入并准备后开局，一局结束后汇总并输出报告
+ */
+class LoadTest : public QObject
+{
+public:
+    explicit LoadTest(const LoadTestOptions& options)
+        : options(options)
+        , hostNetwork(new HotspotNetworkManager(this))
+        , hostGame(new HotspotGameManager(this))
+        , sampleTimer(new QTimer(this))
+        , joinTimer(new QTimer(this))
+        , durationTimer(new QTimer(this))
+        , netemThread(nullptr)
+        , netemProxy(nullptr)
+        , rssBeforeKb(-1)
+        , rssPeakKb(-1)
+        , matchSeconds(0.0)
+        , finished(false)
+        , exitCode(0)
+    {
+        hostNetwork->setDedicatedServer(true);
+        hostNetwork->setDiscoveryEnabled(false);
+        hostNetwork->setHostPorts(options.basePort, static_cast<quint16>(options.basePort + 1));
+        hostGame->setNetworkManager(hostNetwork);
+        hostGame->setGameSpeed(options.gameSpeed);
+        hostGame->setLockstepMode(options.lockstep);
+        hostGame->setGridSize(options.gridWidth, options.gridHeight);
+
+        joinTimer->setSingleShot(true);
+        durationTimer->setSingleShot(true);
+
+        connect(hostGame, &HotspotGameManager::playerJoined, this, [this](const QString&) { tryStart(); });
+        connect(hostGame, &HotspotGameManager::playerReadyChanged, this, [this](const QString&, bool) { tryStart(); });
+        connect(hostGame, &HotspotGameManager::gameStarted, this, [this]() { onGameStarted(); });
+        connect(hostGame, &HotspotGameManager::gameEnded, this, [this](const QString& winner) {
+            finish(winner.isEmpty() ? QString("no winner") : QString("winner %1").arg(winner));
+        });
+        // 时间戳在模拟完成后、快照发出前记录，客户端线程收到快照时一定已经可以查到
+        connect(hostGame, &HotspotGameManager::tickSimulated, this, [this](quint32 tick) {
+            tickClock.record(tick);
+        });
+        connect(sampleTimer, &QTimer::timeout, this, [this]() { sample(); });
+        connect(joinTimer, &QTimer::timeout, this, [this]() {
+            const int joined = hostGame->getGameState().playerSnakes.size();
+            qCritical() << "Only" << joined << "of" << this->options.clients << "virtual clients joined in time";
+            exitCode = 1;
+            finish("join timeout");
+        });
+        connect(durationTimer, &QTimer::timeout, this, [this]() { hostGame->endGame(QString()); });
+    }
+
+    ~LoadTest()
+    {
+        stopWorkers();
+    }
+
+    bool start()
+    {
+        rssBeforeKb = residentMemoryKb();
+        rssPeakKb = rssBeforeKb;
+
+        if (!hostGame->createRoom(QString(), "Load Test", options.clients)) {
+            qCritical() << "Failed to start host on port" << options.basePort;
+            return false;
+        }
+
+        // 代理放在单独的线程上，转发开销不计入主机的逻辑帧耗时
+        if (options.netem) {
+            NetemProxy::Options proxyOptions;
+            proxyOptions.listenAddress = QHostAddress::LocalHost;
+            proxyOptions.listenPort = static_cast<quint16>(options.basePort + 2);
+            proxyOptions.targetPort = options.basePort;
+            proxyOptions.targetStatePort = static_cast<quint16>(options.basePort + 1);
+            proxyOptions.seed = options.seed;
+
+            netemThread = new QThread(this);
+            netemThread->setObjectName("loadtest-netem");
+            netemThread->start();
+            netemProxy = new NetemProxy(proxyOptions);
+            netemProxy->setProfile(options.netemProfile);
+            netemProxy->moveToThread(netemThread);
+            connect(netemThread, &QThread::finished, netemProxy, &QObject::deleteLater);
+
+            bool started = false;
+            QMetaObject::invokeMethod(netemProxy, &NetemProxy::start, Qt::BlockingQueuedConnection, &started);
+            if (!started) {
+                return false;
+            }
+        }
+
+        const int threadCount = qBound(1, options.threads > 0 ? options.threads : QThread::idealThreadCount(), options.clients);
+        for (int i = 0; i < threadCount; ++i) {
+            QThread* worker = new QThread(this);
+            worker->setObjectName(QString("loadtest-client-%1").arg(i));
+            worker->start();
+            workers.append(worker);
+        }
+
+        // 客户端在主线程构造后移到工作线程，之后只在该线程内访问；错开连接避免瞬间挤满监听队列
+        for (int i = 0; i < options.clients; ++i) {
+            VirtualClient* client = new VirtualClient(QString("bot%1").arg(i + 1), options, &tickClock,
+                                                      options.seed + static_cast<quint32>(i));
+            client->moveToThread(workers.at(i % workers.size()));
+            connect(workers.at(i % workers.size()), &QThread::finished, client, &QObject::deleteLater);
+            QTimer::singleShot(i * CONNECT_STAGGER, client, [client]() { client->start(); });
+            clients.append(client);
+        }
+
+        joinTimer->start(JOIN_TIMEOUT + options.clients * CONNECT_STAGGER);
+        sampleTimer->start(SAMPLE_INTERVAL);
+        qInfo() << "Load test started:" << options.clients << "clients on" << workers.size() << "threads,"
+                << options.gridWidth << "x" << options.gridHeight << (options.lockstep ? "lockstep" : "snapshot")
+                << (options.netem ? QString("via netem profile %1").arg(options.netemProfile.name) : QString());
+        return true;
+    }
+
+    int result() const { return exitCode; }
+
+private:
+    void tryStart()
+    {
+        const HotspotGameState state = hostGame->getGameState();
+        if (state.isGameStarted || state.countdownTimer > 0 || state.playerSnakes.size() < options.clients) {
+            return;
+        }
+        for (auto it = state.playerReadyStatus.constBegin(); it != state.playerReadyStatus.constEnd(); ++it) {
+            if (!it.value()) {
+                return;
+            }
+        }
+        joinTimer->stop();
+        hostGame->startGame();
+    }
+
+    void onGameStarted()
+    {
+        matchClock.start();
+        trafficBaseline = hostNetwork->getTrafficStats();
+        hostGame->resetTickPeak();
+        durationTimer->start(options.duration * 1000);
+    }
+
+    void sample()
+    {
+        rssPeakKb = qMax(rssPeakKb, residentMemoryKb());
+        if (!matchClock.isValid()) {
+            return;
+        }
+        // 每秒一个样本：这一秒内的平均和峰值逻辑帧耗时
+        const HotspotGameManager::TickTiming timing = hostGame->getTickTiming();
+        hostGame->resetTickPeak();
+        tickAverageUs.append(timing.averageUs);
+        tickPeakUs.append(static_cast<double>(timing.peakUs));
+    }
+
+    void finish(const QString& reason)
+    {
+        if (finished) {
+            return;
+        }
+        finished = true;
+        sample();
+        sampleTimer->stop();
+        durationTimer->stop();
+        matchSeconds = matchClock.isValid() ? matchClock.elapsed() / 1000.0 : 0.0;
+        const quint32 ticks = hostGame->getGameState().tick;
+
+        QVector<ClientResult> results;
+        for (VirtualClient* client : clients) {
+            ClientResult clientResult;
+            QMetaObject::invokeMethod(client, [client]() { return client->takeResult(); },
+                                      Qt::BlockingQueuedConnection, &clientResult);
+            results.append(clientResult);
+        }
+        QJsonObject netemStats;
+        if (netemProxy) {
+            NetemProxy* proxy = netemProxy;
+            QMetaObject::invokeMethod(proxy, [proxy]() { return proxy->stats(); }, Qt::BlockingQueuedConnection, &netemStats);
+        }
+        stopWorkers();
+
+        for (const ClientResult& clientResult : results) {
+            if (!clientResult.joined) {
+                exitCode = 1;
+            }
+        }
+        const double budgetUs = options.gameSpeed * 1000.0;
+        int overBudget = 0;
+        for (double peak : tickPeakUs) {
+            if (peak > budgetUs) {
+                ++overBudget;
+            }
+        }
+        if (overBudget > 0) {
+            exitCode = 1;
+        }
+
+        printReport(reason, ticks, results, overBudget, netemStats);
+        QCoreApplication::exit(exitCode);
+    }
+
+    void printReport(const QString& reason, quint32 ticks, const QVector<ClientResult>& results, int overBudget,
+                     const QJsonObject& netemStats) const
+    {
+        QVector<double> down, up, latencies;
+        int unmatched = 0;
+        for (const ClientResult& clientResult : results) {
+            down.append(clientResult.downKBps);
+            up.append(clientResult.upKBps);
+            latencies += clientResult.latenciesMs;
+            unmatched += clientResult.unmatchedSnapshots;
+        }
+        const HotspotNetworkManager::TrafficStats traffic = hostNetwork->getTrafficStats();
+        const double seconds = qMax(0.001, matchSeconds);
+        const double hostDown = (traffic.tcpBytesReceived + traffic.udpBytesReceived
+                                 - trafficBaseline.tcpBytesReceived - trafficBaseline.udpBytesReceived) / 1024.0 / seconds;
+        const double hostUp = (traffic.tcpBytesSent + traffic.udpBytesSent
+                               - trafficBaseline.tcpBytesSent - trafficBaseline.udpBytesSent) / 1024.0 / seconds;
+        const qint64 rssAfterKb = residentMemoryKb();
+        const double maxPeak = tickPeakUs.isEmpty() ? 0.0 : *std::max_element(tickPeakUs.constBegin(), tickPeakUs.constEnd());
+        const double minDown = down.isEmpty() ? 0.0 : *std::min_element(down.constBegin(), down.constEnd());
+        const double maxDown = down.isEmpty() ? 0.0 : *std::max_element(down.constBegin(), down.constEnd());
+
+        if (options.csv) {
+            std::cout << "clients,mode,features,grid,speed_ms,seconds,ticks,tick_avg_us,tick_peak_us,over_budget_s,"
+                         "down_avg_kbps,down_min_kbps,down_max_kbps,up_avg_kbps,host_down_kbps,host_up_kbps,"
+                         "latency_p50_ms,latency_p95_ms,latency_p99_ms,latency_max_ms,latency_samples,latency_unmatched,rss_before_kb,rss_peak_kb,rss_after_kb\n";
+            std::cout << options.clients << ',' << (options.lockstep ? "lockstep" : "snapshot") << ','
+                      << options.clientFeatures << ','
+                      << options.gridWidth << 'x' << options.gridHeight << ',' << options.gameSpeed << ','
+                      << std::fixed << std::setprecision(2)
+                      << matchSeconds << ',' << ticks << ',' << average(tickAverageUs) << ',' << maxPeak << ','
+                      << overBudget << ',' << average(down) << ',' << minDown << ',' << maxDown << ','
+                      << average(up) << ',' << hostDown << ',' << hostUp << ','
+                      << percentile(latencies, 0.50) << ',' << percentile(latencies, 0.95) << ','
+                      << percentile(latencies, 0.99) << ',' << percentile(latencies, 1.0) << ','
+                      << latencies.size() << ',' << unmatched << ','
+                      << rssBeforeKb << ',' << rssPeakKb << ',' << rssAfterKb << '\n';
+            return;
+        }
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Load test: " << options.clients << " clients, "
+                  << (options.lockstep ? "lockstep" : "snapshot") << ", grid "
+                  << options.gridWidth << 'x' << options.gridHeight << ", tick " << options.gameSpeed << " ms"
+                  << ", client features " << options.clientFeatures << '\n';
+        std::cout << "Match:     " << matchSeconds << " s, " << ticks << " ticks, "
+                  << reason.toStdString() << "\n\n";
+
+        std::cout << "Host tick (us)        avg " << std::setw(10) << average(tickAverageUs)
+                  << "   p95 peak " << std::setw(10) << percentile(tickPeakUs, 0.95)
+                  << "   max peak " << std::setw(10) << maxPeak
+                  << "   seconds over budget " << overBudget << '/' << tickPeakUs.size() << '\n';
+        std::cout << "Host traffic (KB/s)   down " << std::setw(9) << hostDown
+                  << "   up " << std::setw(10) << hostUp << '\n';
+        std::cout << "Client down (KB/s)    avg " << std::setw(10) << average(down)
+                  << "   min " << std::setw(10) << minDown
+                  << "   max " << std::setw(10) << maxDown << '\n';
+        std::cout << "Client up (KB/s)      avg " << std::setw(10) << average(up) << '\n';
+        std::cout << "Snapshot latency (ms) p50 " << std::setw(10) << percentile(latencies, 0.50)
+                  << "   p95 " << std::setw(10) << percentile(latencies, 0.95)
+                  << "   p99 " << std::setw(10) << percentile(latencies, 0.99)
+                  << "   max " << std::setw(10) << percentile(latencies, 1.0)
+                  << "   samples " << latencies.size() << "   unmatched " << unmatched << '\n';
+        if (!netemStats.isEmpty()) {
+            // 两个方向合计
+            const QJsonObject toHost = netemStats["toHost"].toObject();
+            const QJsonObject toClient = netemStats["toClient"].toObject();
+            const auto total = [&toHost, &toClient](const char* key) {
+                return static_cast<qint64>(toHost[key].toDouble() + toClient[key].toDouble());
+            };
+            std::cout << "Netem " << std::setw(16) << std::left << options.netemProfile.name.toStdString() << std::right
+                      << "lost " << total("lost") << "   overflow " << total("overflow")
+                      << "   reordered " << total("reordered") << "   tcp stalls " << total("stalls") << '\n';
+        }
+        if (rssBeforeKb >= 0) {
+            std::cout << "Process RSS (MB)      before " << std::setw(7) << rssBeforeKb / 1024.0
+                      << "   peak " << std::setw(9) << rssPeakKb / 1024.0
+                      << "   after " << std::setw(8) << rssAfterKb / 1024.0
+                      << "   growth " << (rssAfterKb - rssBeforeKb) / 1024.0 << '\n';
+        }
+
+        std::cout << '\n' << std::left << std::setw(10) << "client" << std::right
+                  << std::setw(12) << "down KB/s" << std::setw(12) << "up KB/s"
+                  << std::setw(12) << "p95 ms" << std::setw(10) << "turns" << '\n';
+        for (const ClientResult& clientResult : results) {
+            std::cout << std::left << std::setw(10) << clientResult.name.toStdString() << std::right
+                      << std::setw(12) << clientResult.downKBps << std::setw(12) << clientResult.upKBps
+                      << std::setw(12) << percentile(clientResult.latenciesMs, 0.95)
+                      << std::setw(10) << clientResult.turns
+                      << (clientResult.joined ? "" : "   (not joined)") << '\n';
+        }
+    }
+
+    void stopWorkers()
+    {
+        // 线程结束后客户端和代理随finished信号删除
+        for (QThread* worker : workers) {
+            worker->quit();
+        }
+        for (QThread* worker : workers) {
+            worker->wait();
+        }
+        workers.clear();
+        clients.clear();
+        if (netemThread) {
+            netemThread->quit();
+            netemThread->wait();
+            netemThread = nullptr;
+            netemProxy = nullptr;
+        }
+    }
+
+    LoadTestOptions options;
+    TickClock tickClock;
+    HotspotNetworkManager* hostNetwork;
+    HotspotGameManager* hostGame;
+    QVector<QThread*> workers;
+    QVector<VirtualClient*> clients;
+    QTimer* sampleTimer;
+    QTimer* joinTimer;
+    QTimer* durationTimer;
+    QThread* netemThread;
+    NetemProxy* netemProxy;
+    QElapsedTimer matchClock;
+    HotspotNetworkManager::TrafficStats trafficBaseline;
+    QVector<double> tickAverageUs;   // 每秒一个样本
+    QVector<double> tickPeakUs;
+    qint64 rssBeforeKb;
+    qint64 rssPeakKb;
+    double matchSeconds;
+    bool finished;
+    int exitCode;
+
+    static const int SAMPLE_INTERVAL = 1000;   // ms
+    static const int CONNECT_STAGGER = 5;      // 相邻客户端发起连接的间隔(ms)
+    static const int JOIN_TIMEOUT = 10000;     // 所有客户端加入并准备的时限(ms)，按客户端数加上错开的时间
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("snake_loadtest");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load generator running a hotspot host and N virtual clients over loopback");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption clientsOption({"c", "clients"}, "Number of virtual clients (2-255, limited by grid size).", "count", "8");
+    QCommandLineOption threadsOption("threads", "Worker threads running the clients (0 = one per CPU core).", "count", "0");
+    QCommandLineOption speedOption({"s", "speed"}, "Game tick interval in milliseconds; also the tick time budget.", "ms", "100");
+    QCommandLineOption gridOption("grid", "Grid size, applied to the host and every client.", "WxH", "40x30");
+    QCommandLineOption lockstepOption("lockstep", "Run the room in deterministic lockstep mode.");
+    QCommandLineOption durationOption({"d", "duration"}, "End the match after this many seconds.", "seconds", "60");
+    QCommandLineOption basePortOption("base-port", "Host TCP port; the state channel uses base+1.", "port", "24600");
+    QCommandLineOption seedOption("seed", "Seed for the virtual clients' steering.", "number", "1");
+    QCommandLineOption netemOption("netem", "Route clients through a NetemProxy with this profile (built-in name or JSON file).", "profile");
+    QCommandLineOption disableFeaturesOption("disable-features", "Comma-separated protocol features the clients do not offer: delta, udp, compression.", "list");
+    QCommandLineOption csvOption("csv", "Print the summary as one CSV row.");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Print debug logging.");
+    parser.addOptions({clientsOption, threadsOption, speedOption, gridOption, lockstepOption, durationOption,
+                       basePortOption, seedOption, netemOption, disableFeaturesOption, csvOption, verboseOption});
+    parser.process(app);
+
+    // 数百个管理器的逐帧调试输出会淹没报告，也会拖慢被测的主机
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    LoadTestOptions options;
+    bool ok = true;
+    const QStringList grid = parser.value(gridOption).split('x');
+    bool heightOk = false;
+    if (grid.size() == 2) {
+        options.gridWidth = grid.at(0).toInt(&ok);
+        options.gridHeight = grid.at(1).toInt(&heightOk);
+    }
+    if (grid.size() != 2 || !ok || !heightOk || options.gridWidth < 10 || options.gridHeight < 10) {
+        qCritical() << "Invalid --grid:" << parser.value(gridOption);
+        return 1;
+    }
+    const int spawnCapacity = qMin(255, SnakeSimulation(options.gridWidth, options.gridHeight).spawnCapacity());
+    options.clients = parser.value(clientsOption).toInt(&ok);
+    if (!ok || options.clients < 2 || options.clients > spawnCapacity) {
+        qCritical() << "Invalid --clients:" << parser.value(clientsOption)
+                    << "(grid" << parser.value(gridOption) << "fits 2 -" << spawnCapacity << ")";
+        return 1;
+    }
+    options.threads = parser.value(threadsOption).toInt(&ok);
+    if (!ok || options.threads < 0) {
+        qCritical() << "Invalid --threads:" << parser.value(threadsOption);
+        return 1;
+    }
+    options.gameSpeed = parser.value(speedOption).toInt(&ok);
+    if (!ok || options.gameSpeed < 10) {
+        qCritical() << "Invalid --speed:" << parser.value(speedOption);
+        return 1;
+    }
+    options.duration = parser.value(durationOption).toInt(&ok);
+    if (!ok || options.duration < 1) {
+        qCritical() << "Invalid --duration:" << parser.value(durationOption);
+        return 1;
+    }
+    const int basePort = parser.value(basePortOption).toInt(&ok);
+    if (!ok || basePort < 1024 || basePort > 65532) {
+        qCritical() << "Invalid --base-port:" << parser.value(basePortOption);
+        return 1;
+    }
+    options.basePort = static_cast<quint16>(basePort);
+    options.seed = parser.value(seedOption).toUInt(&ok);
+    if (!ok) {
+        qCritical() << "Invalid --seed:" << parser.value(seedOption);
+        return 1;
+    }
+    if (parser.isSet(netemOption)) {
+        QString error;
+        if (!NetemProxy::loadProfile(parser.value(netemOption), &options.netemProfile, &error)) {
+            qCritical() << "Invalid --netem:" << error;
+            return 1;
+        }
+        options.netem = true;
+    }
+    const QStringList disabledFeatures = parser.value(disableFeaturesOption).split(',', Qt::SkipEmptyParts);
+    for (const QString& feature : disabledFeatures) {
+        if (feature == "delta") {
+            options.clientFeatures &= ~static_cast<quint32>(HotspotProtocol::FeatureDeltaSnapshots);
+        } else if (feature == "udp") {
+            options.clientFeatures &= ~static_cast<quint32>(HotspotProtocol::FeatureStateChannel);
+        } else if (feature == "compression") {
+            options.clientFeatures &= ~static_cast<quint32>(HotspotProtocol::FeatureCompression);
+        } else {
+            qCritical() << "Invalid --disable-features entry:" << feature;
+            return 1;
+        }
+    }
+    options.lockstep = parser.isSet(lockstepOption);
+    options.csv = parser.isSet(csvOption);
+
+    LoadTest loadTest(options);
+    if (!loadTest.start()) {
+        return 1;
+    }
+
+    app.exec();
+    return loadTest.result();
+}
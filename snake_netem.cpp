@@ -0,0 +1,143 @@
+#include "netemproxy.h"
+#include "hotspotnetworkmanager.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QDebug>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("snake_netem");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Network impairment proxy between hotspot clients and a host.\n"
+                                     "Clients connect to the proxy port (TCP) and proxy port + 1 (state channel UDP).");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption listenPortOption("listen-port", "TCP port clients connect to; the state channel uses port+1.", "port", "24100");
+    QCommandLineOption targetOption({"t", "target"}, "Host IPv4 address to forward to.", "address", "127.0.0.1");
+    QCommandLineOption targetPortOption("target-port", "Host TCP port.", "port", QString::number(HotspotNetworkManager::DEFAULT_PORT));
+    QCommandLineOption targetStatePortOption("target-state-port", "Host state channel UDP port.", "port",
+                                             QString::number(HotspotNetworkManager::STATE_PORT));
+    QCommandLineOption profileOption({"p", "profile"}, "Built-in profile name or JSON profile file.", "profile", "none");
+    QCommandLineOption latencyOption("latency", "Override one-way latency (ms) in every phase.", "ms");
+    QCommandLineOption jitterOption("jitter", "Override latency jitter (+/- ms) in every phase.", "ms");
+    QCommandLineOption lossOption("loss", "Override loss rate (%) in every phase.", "percent");
+    QCommandLineOption reorderOption("reorder", "Override UDP reorder rate (%) in every phase.", "percent");
+    QCommandLineOption bandwidthOption("bandwidth", "Override per-connection bandwidth (KB/s, 0 = unlimited) in every phase.", "kbps");
+    QCommandLineOption seedOption("seed", "Random seed, so the same profile drops the same packets.", "number", "1");
+    QCommandLineOption statusIntervalOption("status-interval", "Print proxy counters as JSON every N seconds (0 disables).", "seconds", "5");
+    QCommandLineOption listProfilesOption("list-profiles", "List the built-in profiles and exit.");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Print debug logging.");
+    parser.addOptions({listenPortOption, targetOption, targetPortOption, targetStatePortOption, profileOption,
+                       latencyOption, jitterOption, lossOption, reorderOption, bandwidthOption, seedOption,
+                       statusIntervalOption, listProfilesOption, verboseOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    if (parser.isSet(listProfilesOption)) {
+        for (const QString& name : NetemProxy::builtinProfileNames()) {
+            NetemProxy::Profile profile;
+            QString error;
+            NetemProxy::loadProfile(name, &profile, &error);
+            const NetemProxy::Impairment& impairment = profile.phases.first().impairment;
+            std::printf("%-14s latency %4d ms  jitter %3d ms  loss %5.1f%%  reorder %4.1f%%  bandwidth %s\n",
+                        qPrintable(name), impairment.latency, impairment.jitter, impairment.loss, impairment.reorder,
+                        impairment.bandwidth > 0 ? qPrintable(QString("%1 KB/s").arg(impairment.bandwidth)) : "unlimited");
+        }
+        return 0;
+    }
+
+    NetemProxy::Options options;
+    bool ok = true;
+    const int listenPort = parser.value(listenPortOption).toInt(&ok);
+    if (!ok || listenPort < 1024 || listenPort > 65534) {
+        qCritical() << "Invalid --listen-port:" << parser.value(listenPortOption);
+        return 1;
+    }
+    options.listenPort = static_cast<quint16>(listenPort);
+    options.targetAddress = QHostAddress(parser.value(targetOption));
+    if (options.targetAddress.protocol() != QAbstractSocket::IPv4Protocol) {
+        qCritical() << "Invalid --target:" << parser.value(targetOption);
+        return 1;
+    }
+    const int targetPort = parser.value(targetPortOption).toInt(&ok);
+    if (!ok || targetPort < 1 || targetPort > 65535) {
+        qCritical() << "Invalid --target-port:" << parser.value(targetPortOption);
+        return 1;
+    }
+    options.targetPort = static_cast<quint16>(targetPort);
+    const int targetStatePort = parser.value(targetStatePortOption).toInt(&ok);
+    if (!ok || targetStatePort < 1 || targetStatePort > 65535) {
+        qCritical() << "Invalid --target-state-port:" << parser.value(targetStatePortOption);
+        return 1;
+    }
+    options.targetStatePort = static_cast<quint16>(targetStatePort);
+    options.seed = parser.value(seedOption).toUInt(&ok);
+    if (!ok) {
+        qCritical() << "Invalid --seed:" << parser.value(seedOption);
+        return 1;
+    }
+    const int statusInterval = parser.value(statusIntervalOption).toInt(&ok);
+    if (!ok || statusInterval < 0) {
+        qCritical() << "Invalid --status-interval:" << parser.value(statusIntervalOption);
+        return 1;
+    }
+
+    NetemProxy::Profile profile;
+    QString error;
+    if (!NetemProxy::loadProfile(parser.value(profileOption), &profile, &error)) {
+        qCritical() << "Invalid --profile:" << error;
+        return 1;
+    }
+
+    // 命令行给出的单项覆盖档位中所有阶段的对应值，方便在同一档位上扫描某一个参数
+    for (NetemProxy::Phase& phase : profile.phases) {
+        NetemProxy::Impairment& impairment = phase.impairment;
+        if (parser.isSet(latencyOption)) {
+            impairment.latency = qMax(0, parser.value(latencyOption).toInt());
+        }
+        if (parser.isSet(jitterOption)) {
+            impairment.jitter = qMax(0, parser.value(jitterOption).toInt());
+        }
+        if (parser.isSet(lossOption)) {
+            impairment.loss = qBound(0.0, parser.value(lossOption).toDouble(), 100.0);
+        }
+        if (parser.isSet(reorderOption)) {
+            impairment.reorder = qBound(0.0, parser.value(reorderOption).toDouble(), 100.0);
+        }
+        if (parser.isSet(bandwidthOption)) {
+            impairment.bandwidth = qMax(0, parser.value(bandwidthOption).toInt());
+        }
+    }
+
+    NetemProxy proxy(options);
+    proxy.setProfile(profile);
+    if (!proxy.start()) {
+        return 1;
+    }
+
+    // 与snake_server相同，每次一行JSON
+    QTimer statusTimer;
+    QObject::connect(&statusTimer, &QTimer::timeout, &proxy, [&proxy]() {
+        const QByteArray line = QJsonDocument(proxy.stats()).toJson(QJsonDocument::Compact);
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    });
+    if (statusInterval > 0) {
+        statusTimer.start(statusInterval * 1000);
+    }
+
+    return app.exec();
+}
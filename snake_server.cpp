@@ -0,0 +1,83 @@
+#include "dedicatedserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("snake_server");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless dedicated server for hotspot multiplayer rooms");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption roomOption({"r", "room"}, "Room name announced to clients (numbered when hosting several rooms).", "name", "Snake Server");
+    QCommandLineOption roomsOption("rooms", "Number of rooms to host.", "count", "1");
+    QCommandLineOption threadsOption("threads", "Worker threads running the rooms (0 = one per CPU core).", "count", "0");
+    QCommandLineOption basePortOption("base-port", "First TCP port; room i listens on base+2i (TCP) and base+2i+1 (UDP).", "port", "24000");
+    QCommandLineOption playersOption({"p", "max-players"}, "Maximum number of players (2-255).", "count", "4");
+    QCommandLineOption speedOption({"s", "speed"}, "Game tick interval in milliseconds.", "ms", "100");
+    QCommandLineOption lockstepOption("lockstep", "Run the room in deterministic lockstep mode.");
+    QCommandLineOption noAutoStartOption("no-auto-start", "Do not start a round when all players are ready.");
+    QCommandLineOption statusIntervalOption("status-interval", "Print room status as JSON every N seconds (0 disables).", "seconds", "5");
+    QCommandLineOption statusSocketOption("status-socket", "Serve room status JSON on this local socket.", "name");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Print debug logging.");
+    parser.addOptions({roomOption, roomsOption, threadsOption, basePortOption, playersOption, speedOption,
+                       lockstepOption, noAutoStartOption, statusIntervalOption, statusSocketOption, verboseOption});
+    parser.process(app);
+
+    // 网络和游戏管理器的逐帧调试输出对无人值守的服务器没有意义
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    DedicatedServer::Options options;
+    bool ok = true;
+    options.roomName = parser.value(roomOption);
+    options.rooms = parser.value(roomsOption).toInt(&ok);
+    if (!ok || options.rooms < 1 || options.rooms > 10000) {
+        qCritical() << "Invalid --rooms:" << parser.value(roomsOption);
+        return 1;
+    }
+    options.threads = parser.value(threadsOption).toInt(&ok);
+    if (!ok || options.threads < 0) {
+        qCritical() << "Invalid --threads:" << parser.value(threadsOption);
+        return 1;
+    }
+    const int basePort = parser.value(basePortOption).toInt(&ok);
+    if (!ok || basePort < 1024 || basePort + 2 * options.rooms - 1 > 65535) {
+        qCritical() << "Invalid --base-port for" << options.rooms << "rooms:" << parser.value(basePortOption);
+        return 1;
+    }
+    options.basePort = static_cast<quint16>(basePort);
+    options.maxPlayers = parser.value(playersOption).toInt(&ok);
+    if (!ok || options.maxPlayers < 2 || options.maxPlayers > 255) {
+        qCritical() << "Invalid --max-players:" << parser.value(playersOption);
+        return 1;
+    }
+    options.gameSpeed = parser.value(speedOption).toInt(&ok);
+    if (!ok || options.gameSpeed < 10) {
+        qCritical() << "Invalid --speed:" << parser.value(speedOption);
+        return 1;
+    }
+    options.statusInterval = parser.value(statusIntervalOption).toInt(&ok);
+    if (!ok || options.statusInterval < 0) {
+        qCritical() << "Invalid --status-interval:" << parser.value(statusIntervalOption);
+        return 1;
+    }
+    options.lockstep = parser.isSet(lockstepOption);
+    options.autoStart = !parser.isSet(noAutoStartOption);
+    options.statusSocket = parser.value(statusSocketOption);
+
+    DedicatedServer server(options);
+    if (!server.start()) {
+        return 1;
+    }
+
+    return app.exec();
+}
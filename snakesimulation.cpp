@@ -0,0 +1,266 @@
+#include "snakesimulation.h"
+#include "hotspotgamemanager.h"
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+// FNV-1a：校验和只需在各端一致，不需要抗碰撞
+void hashValue(quint32& hash, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+}
+
+} // namespace
+
+SnakeSimulation::SnakeSimulation(int gridWidth, int gridHeight)
+    : gridWidth(gridWidth)
+    , gridHeight(gridHeight)
+    , randomState(0)
+{
+}
+
+void SnakeSimulation::initialize(HotspotGameState& state)
+{
+    state.tick = 0;
+
+    // 根据玩家在ID顺序中的位置设置初始位置
+    const QStringList players = playersInIdOrder(state);
+    for (int playerIndex = 0; playerIndex < players.size(); ++playerIndex) {
+        const QString& playerName = players.at(playerIndex);
+        std::deque<Point>& snake = state.playerSnakes[playerName];
+        snake.clear();
+
+        int startX = 5 + (playerIndex % 2) * (gridWidth - 10);
+        int startY = 5 + (playerIndex / 2) * (gridHeight - 10);
+        if (players.size() > 4) {
+            // 四人以上改为分列分行排开，每列宽度至少容纳蛇身和前方的空格，行间隔至少一格
+            const int maxRows = qMax(1, gridHeight / 2);
+            const int columns = (players.size() + maxRows - 1) / maxRows;
+            const int rows = (players.size() + columns - 1) / columns;
+            const int columnWidth = gridWidth / columns;
+            const int rowSpacing = gridHeight / rows;
+            startX = (playerIndex / rows) * columnWidth + INITIAL_SNAKE_LENGTH - 1;
+            startY = (playerIndex % rows) * rowSpacing + rowSpacing / 2;
+        }
+
+        for (int i = 0; i < INITIAL_SNAKE_LENGTH; ++i) {
+            snake.push_back(Point(startX - i, startY));
+        }
+
+        state.playerAliveStatus[playerName] = true;
+        state.playerScores[playerName] = 0;
+        state.playerDirections[playerName] = Direction::RIGHT;
+    }
+
+    generateFood(state);
+}
+
+void SnakeSimulation::step(HotspotGameState& state, StepEvents& events)
+{
+    ++state.tick;
+    const QStringList players = playersInIdOrder(state);
+
+    // 先移动所有存活的蛇
+    for (const QString& playerName : players) {
+        if (!state.playerAliveStatus.value(playerName, false)) {
+            continue;
+        }
+        std::deque<Point>& snake = state.playerSnakes[playerName];
+        if (snake.empty()) {
+            continue;
+        }
+        snake.push_front(nextHeadPosition(snake.front(), state.playerDirections.value(playerName, Direction::RIGHT)));
+        snake.pop_back();
+    }
+
+    // 再按ID顺序判定碰撞和吃食物，先死亡的蛇不再阻挡后面的玩家
+    for (const QString& playerName : players) {
+        if (!state.playerAliveStatus.value(playerName, false)) {
+            continue;
+        }
+        std::deque<Point>& snake = state.playerSnakes[playerName];
+        if (snake.empty()) {
+            continue;
+        }
+
+        const Point head = snake.front();
+        const bool selfCollision = std::find(snake.begin() + 1, snake.end(), head) != snake.end();
+        if (selfCollision || !isInsideGrid(head) || collidesWithOthers(state, playerName)) {
+            state.playerAliveStatus[playerName] = false;
+            events.deaths.append(playerName);
+            continue;
+        }
+
+        if (isFoodAt(state, head)) {
+            const int points = state.isSpecialFood ? SPECIAL_FOOD_POINTS : FOOD_POINTS;
+            state.playerScores[playerName] += points;
+            snake.push_back(snake.back());
+            generateFood(state);
+            events.foodEaten.append(qMakePair(playerName, points));
+        }
+    }
+}
+
+void SnakeSimulation::generateFood(HotspotGameState& state)
+{
+    QSet<Point> occupied;
+    for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+        if (state.playerAliveStatus.value(it.key(), false)) {
+            for (const Point& segment : it.value()) {
+                occupied.insert(segment);
+            }
+        }
+    }
+
+    state.foodPosition = randomFreePosition(occupied);
+
+    // 随机生成特殊食物
+    state.isSpecialFood = nextRandom(SPECIAL_FOOD_CHANCE) == 0;
+    if (state.isSpecialFood) {
+        occupied.insert(state.foodPosition);
+        state.specialFoodPosition = randomFreePosition(occupied);
+    }
+}
+
+quint32 SnakeSimulation::checksum(const HotspotGameState& state) const
+{
+    quint32 hash = 2166136261u;
+    hashValue(hash, state.tick);
+    hashValue(hash, static_cast<quint32>(state.foodPosition.x));
+    hashValue(hash, static_cast<quint32>(state.foodPosition.y));
+    hashValue(hash, state.isSpecialFood ? 1 : 0);
+
+    const QStringList players = playersInIdOrder(state);
+    for (const QString& playerName : players) {
+        hashValue(hash, static_cast<quint32>(state.playerIds.value(playerName)));
+        hashValue(hash, state.playerAliveStatus.value(playerName, false) ? 1 : 0);
+        hashValue(hash, static_cast<quint32>(state.playerDirections.value(playerName, Direction::RIGHT)));
+        hashValue(hash, static_cast<quint32>(state.playerScores.value(playerName, 0)));
+
+        auto snakeIt = state.playerSnakes.constFind(playerName);
+        hashValue(hash, static_cast<quint32>(snakeIt.value().size()));
+        for (const Point& segment : snakeIt.value()) {
+            hashValue(hash, static_cast<quint32>(segment.x));
+            hashValue(hash, static_cast<quint32>(segment.y));
+        }
+    }
+    return hash;
+}
+
+int SnakeSimulation::spawnCapacity() const
+{
+    return qMax(4, (gridHeight / 2) * (gridWidth / (INITIAL_SNAKE_LENGTH + 2)));
+}
+
+bool SnakeSimulation::isInsideGrid(const Point& point) const
+{
+    return point.x >= 0 && point.x < gridWidth && point.y >= 0 && point.y < gridHeight;
+}
+
+bool SnakeSimulation::isOppositeDirection(Direction current, Direction next)
+{
+    return (current == Direction::UP && next == Direction::DOWN) ||
+           (current == Direction::DOWN && next == Direction::UP) ||
+           (current == Direction::LEFT && next == Direction::RIGHT) ||
+           (current == Direction::RIGHT && next == Direction::LEFT);
+}
+
+Point SnakeSimulation::nextHeadPosition(const Point& position, Direction direction)
+{
+    Point head = position;
+    switch (direction) {
+        case Direction::UP:
+            head.y--;
+            break;
+        case Direction::DOWN:
+            head.y++;
+            break;
+        case Direction::LEFT:
+            head.x--;
+            break;
+        case Direction::RIGHT:
+            head.x++;
+            break;
+    }
+
+    return head;
+}
+
+bool SnakeSimulation::isFoodAt(const HotspotGameState& state, const Point& point)
+{
+    return point == state.foodPosition ||
+           (state.isSpecialFood && point == state.specialFoodPosition);
+}
+
+QStringList SnakeSimulation::playersInIdOrder(const HotspotGameState& state)
+{
+    // playerIds按名字排序，这里改为按ID排序；还没分配ID的玩家排在最后
+    QList<QPair<int, QString>> ordered;
+    ordered.reserve(state.playerSnakes.size());
+    for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+        ordered.append(qMakePair(state.playerIds.value(it.key(), INT_MAX), it.key()));
+    }
+    std::sort(ordered.begin(), ordered.end());
+
+    QStringList players;
+    players.reserve(ordered.size());
+    for (const auto& entry : ordered) {
+        players.append(entry.second);
+    }
+    return players;
+}
+
+quint32 SnakeSimulation::nextRandom(quint32 bound)
+{
+    // SplitMix64：状态只有一个64位整数，便于随锁步开始消息下发
+    quint64 z = (randomState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    // 乘法映射到[0, bound)，不依赖取模的平台差异
+    return static_cast<quint32>(((z >> 32) * bound) >> 32);
+}
+
+Point SnakeSimulation::randomFreePosition(const QSet<Point>& occupied)
+{
+    const int cellCount = gridWidth * gridHeight;
+    if (occupied.size() < cellCount) {
+        // 空格较多时随机尝试很快就能命中
+        for (int attempt = 0; attempt < cellCount; ++attempt) {
+            Point candidate(static_cast<int>(nextRandom(static_cast<quint32>(gridWidth))),
+                            static_cast<int>(nextRandom(static_cast<quint32>(gridHeight))));
+            if (!occupied.contains(candidate)) {
+                return candidate;
+            }
+        }
+
+        // 几乎占满时按顺序找第一个空格，保证有限步内结束
+        for (int y = 0; y < gridHeight; ++y) {
+            for (int x = 0; x < gridWidth; ++x) {
+                if (!occupied.contains(Point(x, y))) {
+                    return Point(x, y);
+                }
+            }
+        }
+    }
+    return Point(0, 0);
+}
+
+bool SnakeSimulation::collidesWithOthers(const HotspotGameState& state, const QString& playerName) const
+{
+    const Point head = state.playerSnakes.constFind(playerName).value().front();
+    for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+        if (it.key() == playerName || !state.playerAliveStatus.value(it.key(), false)) {
+            continue;
+        }
+        if (std::find(it.value().begin(), it.value().end(), head) != it.value().end()) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef SNAKESIMULATION_H
+#define SNAKESIMULATION_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include "gamestate.h"
+
+struct HotspotGameState;
+
+/**
+ * 热点对战的确定性模拟
+ * 主机的权威模拟、客户端的本地预测和锁步模式下各端的模拟共用这一套规则
+ * 特点：
+ * 1. 玩家按房主分配的ID顺序处理，结果与名字排序无关
+ * 2. 使用自带的随机数生成器，同一随机状态在所有平台上生成相同的食物序列
+ * 3. 只依赖当前状态和玩家方向，不读取时间，不使用全局随机数
+ * 4. 提供状态校验和，锁步模式下用来发现各端模拟是否出现分歧
+ */
+class SnakeSimulation
+{
+public:
+    // 一个逻辑帧内发生的事件，由调用方转换成信号
+    struct StepEvents {
+        QList<QPair<QString, int>> foodEaten;  // 玩家名、得分
+        QStringList deaths;
+    };
+
+    SnakeSimulation(int gridWidth, int gridHeight);
+
+    // 地图大小：各端须相同，只能在开局前修改
+    void setGridSize(int width, int height) { gridWidth = width; gridHeight = height; }
+    int getGridWidth() const { return gridWidth; }
+    int getGridHeight() const { return gridHeight; }
+    int spawnCapacity() const;  // 当前地图大小下能摆放初始蛇身的玩家上限
+
+    // 随机状态：锁步模式开始时由主机下发，各端从同一状态开始生成食物
+    void setRandomState(quint64 state) { randomState = state; }
+    quint64 getRandomState() const { return randomState; }
+
+    void initialize(HotspotGameState& state);                // 按玩家ID摆放初始蛇身并生成食物
+    void step(HotspotGameState& state, StepEvents& events);  // 推进一个逻辑帧
+    void generateFood(HotspotGameState& state);
+    quint32 checksum(const HotspotGameState& state) const;
+
+    // 基本移动规则
+    bool isInsideGrid(const Point& point) const;
+    static bool isOppositeDirection(Direction current, Direction next);
+    static Point nextHeadPosition(const Point& position, Direction direction);
+    static bool isFoodAt(const HotspotGameState& state, const Point& point);
+    static QStringList playersInIdOrder(const HotspotGameState& state);
+
+    static const int INITIAL_SNAKE_LENGTH = 3;
+    static const int FOOD_POINTS = 10;
+    static const int SPECIAL_FOOD_POINTS = 50;
+
+private:
+    quint32 nextRandom(quint32 bound);
+    Point randomFreePosition(const QSet<Point>& occupied);
+    bool collidesWithOthers(const HotspotGameState& state, const QString& playerName) const;
+
+    int gridWidth;
+    int gridHeight;
+    quint64 randomState;
+
+    static const int SPECIAL_FOOD_CHANCE = 10;  // 每次生成食物有1/10概率额外出现特殊食物
+};
+
+#endif // SNAKESIMULATION_H
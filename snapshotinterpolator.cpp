@@ -0,0 +1,179 @@
+#include "snapshotinterpolator.h"
+#include "hotspotgamemanager.h"
+#include <cmath>
+
+SnapshotInterpolator::SnapshotInterpolator()
+    : tickInterval(0)
+    , hasTiming(false)
+    , clockOffset(0.0)
+    , jitter(0.0)
+    , snapshotSpacing(0.0)
+    , bufferDelay(MIN_BUFFER_DELAY)
+    , lastArrival(0)
+    , lastTick(0)
+{
+}
+
+void SnapshotInterpolator::clear()
+{
+    snapshots.clear();
+    hasTiming = false;
+    jitter = 0.0;
+    snapshotSpacing = 0.0;
+    bufferDelay = MIN_BUFFER_DELAY;
+}
+
+void SnapshotInterpolator::addSnapshot(const HotspotGameState& state, const QString& excludedPlayer, qint64 arrivalTime)
+{
+    // 调用方已丢弃过期快照，帧号倒退只会是重新开局；游戏速度变化时帧号与时间的对应关系也失效
+    if (state.gameSpeed <= 0) {
+        return;
+    }
+    if (state.gameSpeed != tickInterval || (hasTiming && state.tick < lastTick)) {
+        clear();
+        tickInterval = state.gameSpeed;
+    }
+    if (hasTiming && state.tick == lastTick) {
+        return;
+    }
+
+    const double offsetSample = static_cast<double>(arrivalTime) - static_cast<double>(state.tick) * tickInterval;
+    if (!hasTiming) {
+        clockOffset = offsetSample;
+        snapshotSpacing = tickInterval;
+        hasTiming = true;
+    } else {
+        // 到达间隔与帧时间间隔之差即为这次的抖动（RFC 3550的到达抖动估计）
+        const double tickSpan = static_cast<double>(state.tick - lastTick) * tickInterval;
+        const double deviation = static_cast<double>(arrivalTime - lastArrival) - tickSpan;
+        jitter += (std::fabs(deviation) - jitter) / 16.0;
+        snapshotSpacing += (tickSpan - snapshotSpacing) / 8.0;
+
+        // 偏移取最快到达的下包络，其余的迟到由缓冲延迟吸收；缓慢上移以跟随时钟漂移
+        if (offsetSample < clockOffset) {
+            clockOffset = offsetSample;
+        } else {
+            clockOffset += (offsetSample - clockOffset) / 128.0;
+        }
+    }
+    lastArrival = arrivalTime;
+    lastTick = state.tick;
+
+    // 目标延迟要保证渲染到某个快照时，下一个快照通常已经到达
+    const double targetDelay = qBound(static_cast<double>(MIN_BUFFER_DELAY),
+                                      snapshotSpacing + JITTER_MULTIPLIER * jitter,
+                                      static_cast<double>(MAX_BUFFER_DELAY));
+    bufferDelay += (targetDelay - bufferDelay) / 8.0;
+
+    Snapshot snapshot;
+    snapshot.tick = state.tick;
+    for (auto it = state.playerSnakes.constBegin(); it != state.playerSnakes.constEnd(); ++it) {
+        if (it.key() != excludedPlayer && state.playerAliveStatus.value(it.key(), false) && !it.value().empty()) {
+            snapshot.snakes.insert(it.key(), it.value());
+        }
+    }
+
+    snapshots.push_back(std::move(snapshot));
+
+    // 已经播放过的快照只保留最近一个作为插值起点
+    const double currentTick = renderTick(arrivalTime);
+    while (snapshots.size() > 2 && snapshots[1].tick <= currentTick) {
+        snapshots.pop_front();
+    }
+    while (snapshots.size() > static_cast<size_t>(MAX_BUFFERED_SNAPSHOTS)) {
+        snapshots.pop_front();
+    }
+}
+
+bool SnapshotInterpolator::sample(qint64 now, QMap<QString, QVector<QPointF>>& snakes) const
+{
+    if (snapshots.empty()) {
+        return false;
+    }
+
+    const double currentTick = renderTick(now);
+
+    // 找到渲染时刻前后的两个快照；缓冲耗尽时停在最新快照，不做外推
+    size_t next = 0;
+    while (next < snapshots.size() && snapshots[next].tick <= currentTick) {
+        ++next;
+    }
+
+    QMap<QString, QVector<QPointF>> result;
+    if (next == 0 || next == snapshots.size()) {
+        const Snapshot& held = (next == 0) ? snapshots.front() : snapshots.back();
+        for (auto it = held.snakes.constBegin(); it != held.snakes.constEnd(); ++it) {
+            copySnake(it.value(), result[it.key()]);
+        }
+    } else {
+        const Snapshot& from = snapshots[next - 1];
+        const Snapshot& to = snapshots[next];
+        const int steps = static_cast<int>(to.tick - from.tick);
+        const double fraction = (currentTick - from.tick) / steps;
+
+        // 只显示在后一个快照中仍然存活的玩家
+        for (auto it = to.snakes.constBegin(); it != to.snakes.constEnd(); ++it) {
+            auto previous = from.snakes.constFind(it.key());
+            if (previous == from.snakes.constEnd()) {
+                copySnake(it.value(), result[it.key()]);
+            } else {
+                interpolateSnake(previous.value(), it.value(), steps, fraction, result[it.key()]);
+            }
+        }
+    }
+
+    snakes.swap(result);
+    return true;
+}
+
+double SnapshotInterpolator::renderTick(qint64 now) const
+{
+    if (!hasTiming || tickInterval <= 0) {
+        return 0.0;
+    }
+    return (static_cast<double>(now) - clockOffset - bufferDelay) / tickInterval;
+}
+
+void SnapshotInterpolator::interpolateSnake(const std::deque<Point>& from, const std::deque<Point>& to,
+                                            int steps, double fraction, QVector<QPointF>& out)
+{
+    // 蛇每帧前进一格，两个快照之间走过的路径 = 后一快照的前steps格 + 前一快照的蛇身
+    const int toSize = static_cast<int>(to.size());
+    const bool connected = steps > 0 && steps <= toSize &&
+                           qAbs(to[steps - 1].x - from.front().x) + qAbs(to[steps - 1].y - from.front().y) == 1 &&
+                           (steps == toSize || to[steps] == from.front());
+    if (!connected) {
+        copySnake(fraction < 0.5 ? from : to, out);
+        return;
+    }
+
+    auto pathAt = [&](int index) -> const Point& {
+        if (index < steps) {
+            return to[index];
+        }
+        const int fromIndex = qMin(index - steps, static_cast<int>(from.size()) - 1);
+        return from[fromIndex];
+    };
+
+    const double head = steps * (1.0 - fraction);
+    const int headIndex = static_cast<int>(std::floor(head));
+    const double blend = head - headIndex;
+    const int length = static_cast<int>(from.size()) +
+                       qRound(fraction * (static_cast<int>(to.size()) - static_cast<int>(from.size())));
+
+    out.resize(qMax(length, 1));
+    for (int i = 0; i < out.size(); ++i) {
+        const Point& ahead = pathAt(headIndex + i);
+        const Point& behind = pathAt(headIndex + i + 1);
+        out[i] = QPointF(ahead.x + (behind.x - ahead.x) * blend,
+                         ahead.y + (behind.y - ahead.y) * blend);
+    }
+}
+
+void SnapshotInterpolator::copySnake(const std::deque<Point>& body, QVector<QPointF>& out)
+{
+    out.resize(static_cast<int>(body.size()));
+    for (int i = 0; i < out.size(); ++i) {
+        out[i] = QPointF(body[i].x, body[i].y);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SNAPSHOTINTERPOLATOR_H
+#define SNAPSHOTINTERPOLATOR_H
+
+#include <QtGlobal>
+#include <QMap>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <deque>
+#include "gamestate.h"
+
+struct HotspotGameState;
+
+/**
+ * 远端玩家快照的抖动缓冲与插值
+ * 客户端把收到的权威状态按逻辑帧号缓存一段时间，渲染时取前后两个快照插值
+ * 特点：
+ * 1. 播放时间由快照的帧号换算而不是取到达时间，突发到达的快照仍按原节奏播放
+ * 2. 缓冲延迟 = 快照平均间隔 + 若干倍到达抖动，随实测抖动自动增减，并逐步过渡避免画面跳变
+ * 3. 蛇身沿实际走过的格子插值，转弯处不会斜着穿过格子
+ * 4. 复活等无法连成路径的变化直接切换，不做插值
+ */
+class SnapshotInterpolator
+{
+public:
+    SnapshotInterpolator();
+
+    void clear();
+
+    // 记录一个权威状态；excludedPlayer（本地玩家，由预测负责）不进入缓冲
+    void addSnapshot(const HotspotGameState& state, const QString& excludedPlayer, qint64 arrivalTime);
+
+    // 取now时刻应显示的远端蛇身（格子坐标，可为小数），缓冲为空时返回false
+    bool sample(qint64 now, QMap<QString, QVector<QPointF>>& snakes) const;
+
+    int getBufferDelay() const { return qRound(bufferDelay); }  // 当前缓冲延迟(ms)
+    double getJitter() const { return jitter; }                 // 平滑后的到达抖动(ms)
+
+private:
+    struct Snapshot {
+        quint32 tick = 0;
+        QMap<QString, std::deque<Point>> snakes;
+    };
+
+    double renderTick(qint64 now) const;
+    static void interpolateSnake(const std::deque<Point>& from, const std::deque<Point>& to,
+                                 int steps, double fraction, QVector<QPointF>& out);
+    static void copySnake(const std::deque<Point>& body, QVector<QPointF>& out);
+
+    std::deque<Snapshot> snapshots;
+    int tickInterval;        // 主机逻辑帧间隔(ms)
+    bool hasTiming;
+    double clockOffset;      // 到达时间 - 帧号对应的主机时间，取下包络
+    double jitter;           // 到达时间相对帧时间的平均偏差(ms)
+    double snapshotSpacing;  // 相邻快照的平均帧时间间隔(ms)
+    double bufferDelay;      // 当前使用的缓冲延迟(ms)
+    qint64 lastArrival;
+    quint32 lastTick;
+
+    static const int MAX_BUFFERED_SNAPSHOTS = 32;
+    static const int MIN_BUFFER_DELAY = 20;     // ms
+    static const int MAX_BUFFER_DELAY = 500;    // ms，更高的抖动宁可卡顿也不再增加延迟
+    static const int JITTER_MULTIPLIER = 2;     // 覆盖约两倍平均抖动的迟到快照
+};
+
+#endif // SNAPSHOTINTERPOLATOR_H
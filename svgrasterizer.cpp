@@ -0,0 +1,148 @@
+#include "svgrasterizer.h"
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QSvgRenderer>
+#include <QPainter>
+#include <QPointer>
+#include <QMetaObject>
+#include <QtMath>
+#include <QDebug>
+
+SvgRasterizer* SvgRasterizer::instance()
+{
+    // 挂在应用对象上，随应用一起销毁
+    static SvgRasterizer* rasterizer = new SvgRasterizer(QCoreApplication::instance());
+    return rasterizer;
+}
+
+SvgRasterizer::SvgRasterizer(QObject *parent)
+    : QObject(parent)
+    , pixmapCache(CACHE_LIMIT_KB)
+    , workerPool(new QThreadPool(this))
+{
+    workerPool->setMaxThreadCount(MAX_WORKER_THREADS);
+}
+
+QString SvgRasterizer::cacheKey(const QString& svgPath, const QSize& physicalSize)
+{
+    return QString("%1@%2x%3").arg(svgPath).arg(physicalSize.width()).arg(physicalSize.height());
+}
+
+QSize SvgRasterizer::physicalSizeFor(const QSize& logicalSize, qreal devicePixelRatio)
+{
+    // 向上取整，保证位图不小于实际绘制区域
+    return QSize(qCeil(logicalSize.width() * devicePixelRatio),
+                 qCeil(logicalSize.height() * devicePixelRatio));
+}
+
+QImage SvgRasterizer::rasterize(const QString& svgPath, const QSize& physicalSize)
+{
+    // 在工作线程中执行：QSvgRenderer + QImage 均可在非GUI线程使用
+    QSvgRenderer renderer;
+    if (!renderer.load(svgPath) || !renderer.isValid()) {
+        return QImage();
+    }
+
+    QImage image(physicalSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    renderer.render(&painter);
+    painter.end();
+    return image;
+}
+
+QPixmap SvgRasterizer::toPixmap(const QImage& image, qreal devicePixelRatio) const
+{
+    QPixmap pixmap = QPixmap::fromImage(image);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    return pixmap;
+}
+
+QPixmap SvgRasterizer::pixmap(const QString& svgPath, const QSize& logicalSize, qreal devicePixelRatio)
+{
+    if (invalidPaths.contains(svgPath) || logicalSize.isEmpty()) {
+        return QPixmap();
+    }
+
+    const QSize physicalSize = physicalSizeFor(logicalSize, devicePixelRatio);
+    const QString key = cacheKey(svgPath, physicalSize);
+
+    if (QPixmap* cached = pixmapCache.object(key)) {
+        return *cached;
+    }
+
+    auto latest = latestPixmaps.constFind(svgPath);
+    if (latest != latestPixmaps.constEnd()) {
+        // 新尺寸尚未就绪，先用上一次的位图顶上
+        requestRaster(svgPath, physicalSize, devicePixelRatio);
+        return latest.value();
+    }
+
+    // 该SVG第一次使用，没有可以过渡的位图，只能同步生成一次
+    QImage image = rasterize(svgPath, physicalSize);
+    if (image.isNull()) {
+        qDebug() << "Failed to load SVG:" << svgPath;
+        invalidPaths.insert(svgPath);
+        return QPixmap();
+    }
+
+    QPixmap result = toPixmap(image, devicePixelRatio);
+    pixmapCache.insert(key, new QPixmap(result), qMax(1, static_cast<int>(image.sizeInBytes() / 1024)));
+    latestPixmaps.insert(svgPath, result);
+    return result;
+}
+
+void SvgRasterizer::prefetch(const QString& svgPath, const QSize& logicalSize, qreal devicePixelRatio)
+{
+    if (invalidPaths.contains(svgPath) || logicalSize.isEmpty()) {
+        return;
+    }
+
+    const QSize physicalSize = physicalSizeFor(logicalSize, devicePixelRatio);
+    if (!pixmapCache.contains(cacheKey(svgPath, physicalSize))) {
+        requestRaster(svgPath, physicalSize, devicePixelRatio);
+    }
+}
+
+void SvgRasterizer::requestRaster(const QString& svgPath, const QSize& physicalSize, qreal devicePixelRatio)
+{
+    const QString key = cacheKey(svgPath, physicalSize);
+    if (pendingKeys.contains(key)) {
+        return;
+    }
+    pendingKeys.insert(key);
+
+    QPointer<SvgRasterizer> self(this);
+    workerPool->start([self, key, svgPath, physicalSize, devicePixelRatio]() {
+        QImage image = rasterize(svgPath, physicalSize);
+        if (!self) {
+            return;
+        }
+        // QPixmap只能在GUI线程创建，结果排队送回主线程
+        QMetaObject::invokeMethod(self.data(), [self, key, svgPath, image, devicePixelRatio]() {
+            if (self) {
+                self->onImageRasterized(key, svgPath, image, devicePixelRatio);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SvgRasterizer::onImageRasterized(const QString& key, const QString& svgPath,
+                                      const QImage& image, qreal devicePixelRatio)
+{
+    pendingKeys.remove(key);
+
+    if (image.isNull()) {
+        qDebug() << "Failed to rasterize SVG:" << svgPath;
+        invalidPaths.insert(svgPath);
+        latestPixmaps.remove(svgPath);
+        emit pixmapReady(svgPath);
+        return;
+    }
+
+    QPixmap result = toPixmap(image, devicePixelRatio);
+    pixmapCache.insert(key, new QPixmap(result), qMax(1, static_cast<int>(image.sizeInBytes() / 1024)));
+    latestPixmaps.insert(svgPath, result);
+    emit pixmapReady(svgPath);
+}
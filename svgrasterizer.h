@@ -0,0 +1,64 @@
+#ifndef SVGRASTERIZER_H
+#define SVGRASTERIZER_H
+
+#include <QObject>
+#include <QPixmap>
+#include <QImage>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QSize>
+#include <QString>
+
+class QThreadPool;
+
+/**
+ * SVG异步栅格化管线
+ * 在工作线程中把SVG渲染为QImage，再回到GUI线程转换为QPixmap缓存
+ * 特点：
+ * 1. 按物理像素尺寸（逻辑尺寸 × devicePixelRatio）栅格化，HiDPI屏幕不再模糊
+ * 2. 新尺寸在后台生成，完成前继续返回上一次的尺寸，调整窗口大小不会卡帧
+ * 3. 相同SVG和尺寸的请求自动去重，结果按内存大小缓存
+ */
+class SvgRasterizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SvgRasterizer* instance();
+
+    // 获取指定逻辑尺寸的位图；目标尺寸未就绪时返回该SVG最近一次的位图并在后台生成
+    QPixmap pixmap(const QString& svgPath, const QSize& logicalSize, qreal devicePixelRatio);
+
+    // 预先请求指定尺寸，不关心当前返回值
+    void prefetch(const QString& svgPath, const QSize& logicalSize, qreal devicePixelRatio);
+
+    // SVG是否无法加载（调用方应使用备用绘制）
+    bool isInvalid(const QString& svgPath) const { return invalidPaths.contains(svgPath); }
+
+signals:
+    void pixmapReady(const QString& svgPath);
+
+private:
+    explicit SvgRasterizer(QObject *parent = nullptr);
+
+    static QString cacheKey(const QString& svgPath, const QSize& physicalSize);
+    static QSize physicalSizeFor(const QSize& logicalSize, qreal devicePixelRatio);
+    static QImage rasterize(const QString& svgPath, const QSize& physicalSize);
+
+    QPixmap toPixmap(const QImage& image, qreal devicePixelRatio) const;
+    void requestRaster(const QString& svgPath, const QSize& physicalSize, qreal devicePixelRatio);
+    void onImageRasterized(const QString& key, const QString& svgPath,
+                           const QImage& image, qreal devicePixelRatio);
+
+    QCache<QString, QPixmap> pixmapCache;   // key: 路径@宽x高，cost: KB
+    QHash<QString, QPixmap> latestPixmaps;  // 每个SVG最近一次完成的位图，作为过渡
+    QSet<QString> pendingKeys;              // 正在后台栅格化的请求
+    QSet<QString> invalidPaths;             // 无法加载的SVG
+    QThreadPool* workerPool;
+
+    static const int CACHE_LIMIT_KB = 32 * 1024;  // 位图缓存上限32MB
+    static const int MAX_WORKER_THREADS = 2;      // 栅格化线程数，避免与游戏逻辑争抢CPU
+};
+
+#endif // SVGRASTERIZER_H
@@ -0,0 +1,703 @@
+// 热点联机协议测试
+// 检查快照编解码（关键帧、增量、回退到完整蛇身）、TCP分帧解析，以及截断和畸形数据的处理。
+// 不需要网络和事件循环，任何一项检查失败时返回非零退出码。
+
+#include "hotspotprotocol.h"
+#include "hotspotgamemanager.h"
+#include "snakesimulation.h"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include <QDebug>
+#include <cstring>
+#include <functional>
+
+using namespace HotspotProtocol;
+
+namespace {
+
+int checks = 0;
+int failures = 0;
+
+bool check(bool condition, const QString& what)
+{
+    ++checks;
+    if (!condition) {
+        ++failures;
+        qCritical().noquote() << "FAIL:" << what;
+    }
+    return condition;
+}
+
+QString describe(const std::deque<Point>& snake)
+{
+    QStringList points;
+    for (const Point& point : snake) {
+        points.append(QString("(%1,%2)").arg(point.x).arg(point.y));
+    }
+    return "[" + points.join(' ') + "]";
+}
+
+std::deque<Point> straightSnake(const Point& head, int length, int dx, int dy)
+{
+    std::deque<Point> snake;
+    for (int i = 0; i < length; ++i) {
+        snake.push_back(Point(head.x - i * dx, head.y - i * dy));
+    }
+    return snake;
+}
+
+// 与SnakeSimulation::step相同：头部加一节、尾部减一节，吃到食物时尾部重复最后一节
+void moveSnake(std::deque<Point>& snake, Direction direction, bool eat)
+{
+    snake.push_front(SnakeSimulation::nextHeadPosition(snake.front(), direction));
+    snake.pop_back();
+    if (eat) {
+        snake.push_back(snake.back());
+    }
+}
+
+void addPlayer(HotspotGameState& state, const QString& name, int id, const std::deque<Point>& snake, Direction direction)
+{
+    state.playerIds[name] = id;
+    state.playerSnakes[name] = snake;
+    state.playerDirections[name] = direction;
+    state.playerAliveStatus[name] = true;
+    state.playerScores[name] = 0;
+    state.playerInputSequences[name] = 0;
+}
+
+// 客户端在收到快照前已经从名单得知玩家ID；蛇身先填入占位内容，解码后必须被覆盖
+HotspotGameState clientStateFor(const HotspotGameState& host)
+{
+    HotspotGameState client;
+    client.playerIds = host.playerIds;
+    for (auto it = host.playerIds.constBegin(); it != host.playerIds.constEnd(); ++it) {
+        client.playerSnakes[it.key()] = std::deque<Point>{Point(-99, -99), Point(-98, -99)};
+    }
+    return client;
+}
+
+bool decodeSnapshot(const QByteArray& message, const SnapshotBaseline* baseline, HotspotGameState& client,
+                    SnapshotHeader* header = nullptr)
+{
+    if (message.isEmpty() || static_cast<Opcode>(static_cast<quint8>(message.at(0))) != Opcode::GameState) {
+        return false;
+    }
+    Reader reader(message.constData() + 1, message.size() - 1);
+    SnapshotHeader decodedHeader;
+    if (!decodeSnapshotHeader(reader, decodedHeader) || !decodeGameState(reader, baseline, client)) {
+        return false;
+    }
+    client.tick = decodedHeader.tick;
+    if (header) {
+        *header = decodedHeader;
+    }
+    return reader.atEnd();
+}
+
+bool sameState(const HotspotGameState& host, const HotspotGameState& client, const QString& context)
+{
+    bool same = check(client.tick == host.tick, context + ": tick") &&
+                check(client.isPaused == host.isPaused && client.isGameStarted == host.isGameStarted &&
+                      client.isSpecialFood == host.isSpecialFood, context + ": flags") &&
+                check(client.foodPosition == host.foodPosition, context + ": food") &&
+                check(!host.isSpecialFood || client.specialFoodPosition == host.specialFoodPosition,
+                      context + ": special food") &&
+                check(client.gameWinner == host.gameWinner, context + ": winner") &&
+                check(client.gameSpeed == host.gameSpeed && client.countdownTimer == host.countdownTimer,
+                      context + ": speed and countdown");
+    for (auto it = host.playerIds.constBegin(); it != host.playerIds.constEnd(); ++it) {
+        const QString& name = it.key();
+        const std::deque<Point>& expected = host.playerSnakes.value(name);
+        const std::deque<Point>& actual = client.playerSnakes.value(name);
+        same &= check(actual == expected, QString("%1: snake of %2 is %3, expected %4")
+                                              .arg(context, name, describe(actual), describe(expected)));
+        same &= check(client.playerAliveStatus.value(name) == host.playerAliveStatus.value(name) &&
+                      client.playerDirections.value(name) == host.playerDirections.value(name) &&
+                      client.playerScores.value(name) == host.playerScores.value(name) &&
+                      client.playerInputSequences.value(name) == host.playerInputSequences.value(name),
+                      QString("%1: status of %2").arg(context, name));
+    }
+    return same;
+}
+
+// 增量快照离开基线无法解码，用来判断编码器实际选择了哪种方式
+bool usesDelta(const QByteArray& message, const HotspotGameState& host)
+{
+    HotspotGameState client = clientStateFor(host);
+    return !decodeSnapshot(message, nullptr, client);
+}
+
+/**
+ * 多名玩家同时出现各种蛇身变化，每一帧都按关键帧和多种基线间隔编码后解码比对
+ * turner 折返前进并定期吃食物，shrinker 尾部成段缩短，grower 原地从尾部接长（含超出相邻范围的转义位移），
+ * dier 中途死亡后蛇身保留，再之后被清空
+ */
+void testSnapshotRoundTrips()
+{
+    HotspotGameState host;
+    host.isGameStarted = true;
+    host.gameSpeed = 100;
+    host.foodPosition = Point(3, 4);
+    addPlayer(host, "turner", 1, straightSnake(Point(10, 10), 6, 1, 0), Direction::RIGHT);
+    addPlayer(host, "shrinker", 2, straightSnake(Point(-20, 40), 40, 0, -1), Direction::DOWN);
+    addPlayer(host, "grower", 3, straightSnake(Point(60, 60), 2, 1, 0), Direction::RIGHT);
+    addPlayer(host, "dier", 4, straightSnake(Point(100, 0), 5, -1, 0), Direction::LEFT);
+
+    const int ticks = 200;
+    const QVector<int> lags = {1, 2, 5, 30, MAX_DELTA_HEADS, MAX_DELTA_HEADS + 1, 90};
+    QVector<HotspotGameState> history;
+    history.append(host);
+
+    // 模拟真实客户端：同一个状态对象依次应用每一帧相对上一帧的增量
+    HotspotGameState sequentialClient = clientStateFor(host);
+    QByteArray message;
+    encodeGameState(host, 1, nullptr, message);
+    check(decodeSnapshot(message, nullptr, sequentialClient), "initial keyframe decodes");
+
+    int turnerLeg = 0;
+    Direction turnerDirection = Direction::RIGHT;
+    for (int tick = 1; tick <= ticks; ++tick) {
+        host.tick = static_cast<quint32>(tick);
+
+        // 折返：向右或向左走8格，再向下走1格
+        std::deque<Point>& turner = host.playerSnakes["turner"];
+        ++turnerLeg;
+        if (turnerDirection == Direction::DOWN) {
+            turnerDirection = (tick / 9) % 2 == 0 ? Direction::RIGHT : Direction::LEFT;
+            turnerLeg = 0;
+        } else if (turnerLeg >= 8) {
+            turnerDirection = Direction::DOWN;
+        }
+        host.playerDirections["turner"] = turnerDirection;
+        const bool eat = tick % 7 == 0;
+        moveSnake(turner, turnerDirection, eat);
+        if (eat) {
+            host.playerScores["turner"] += SnakeSimulation::FOOD_POINTS;
+            host.foodPosition = Point(tick % 37, tick % 23);
+        }
+
+        std::deque<Point>& shrinker = host.playerSnakes["shrinker"];
+        moveSnake(shrinker, Direction::DOWN, false);
+        if (tick % 4 == 0 && shrinker.size() > 3) {
+            shrinker.pop_back();
+            shrinker.pop_back();
+        }
+
+        std::deque<Point>& grower = host.playerSnakes["grower"];
+        if (tick % 5 == 0) {
+            const Point tail = grower.back();
+            grower.push_back(Point(tail.x, tail.y + (tick % 10 == 0 ? 3 : 1)));
+        } else {
+            moveSnake(grower, Direction::RIGHT, false);
+        }
+        host.playerInputSequences["grower"] = static_cast<quint32>(tick / 3);
+
+        if (tick < 40) {
+            moveSnake(host.playerSnakes["dier"], Direction::LEFT, false);
+        } else if (tick == 40) {
+            host.playerAliveStatus["dier"] = false;
+        } else if (tick == 80) {
+            host.playerSnakes["dier"].clear();
+        }
+
+        host.isSpecialFood = tick % 13 < 4;
+        host.specialFoodPosition = Point(-tick, tick);
+        host.isPaused = tick % 50 == 25;
+        if (tick == ticks) {
+            host.gameWinner = "turner";
+        }
+        history.append(host);
+
+        const quint32 sequence = static_cast<quint32>(tick + 1);
+        encodeGameState(host, sequence, nullptr, message);
+        HotspotGameState keyframeClient = clientStateFor(host);
+        check(decodeSnapshot(message, nullptr, keyframeClient), QString("keyframe at tick %1 decodes").arg(tick));
+        sameState(host, keyframeClient, QString("keyframe at tick %1").arg(tick));
+
+        for (int lag : lags) {
+            if (lag > tick) {
+                continue;
+            }
+            const SnapshotBaseline baseline = makeBaseline(history.at(tick - lag), sequence - lag);
+            encodeGameState(host, sequence, &baseline, message);
+            HotspotGameState client = clientStateFor(host);
+            SnapshotHeader header;
+            const QString context = QString("delta at tick %1 from %2 ticks back").arg(tick).arg(lag);
+            if (check(decodeSnapshot(message, &baseline, client, &header), context + " decodes")) {
+                check(header.sequence == sequence && header.baseSequence == baseline.sequence, context + ": header");
+                sameState(host, client, context);
+            }
+            if (lag == 1) {
+                check(decodeSnapshot(message, &baseline, sequentialClient), context + " applies to the running client");
+                sameState(host, sequentialClient, context + " (running client)");
+            }
+        }
+    }
+}
+
+/**
+ * 单条长蛇直行折返，检查编码器何时发增量、何时回退到完整蛇身：
+ * 不超过 MAX_DELTA_HEADS 帧且当前帧没有吃到食物时必须是增量；更旧的基线必须回退到完整蛇身。
+ * 当前帧吃到食物时尾部多出一节重复位置，与基线不再逐节相同，只要求结果正确
+ */
+void testDeltaFallback()
+{
+    HotspotGameState host;
+    host.isGameStarted = true;
+    addPlayer(host, "long", 7, straightSnake(Point(0, 0), MAX_DELTA_HEADS + 20, 1, 0), Direction::RIGHT);
+
+    QVector<HotspotGameState> history;
+    QVector<bool> ateAt;
+    history.append(host);
+    ateAt.append(false);
+
+    Direction direction = Direction::RIGHT;
+    int leg = 0;
+    for (int tick = 1; tick <= 3 * MAX_DELTA_HEADS; ++tick) {
+        host.tick = static_cast<quint32>(tick);
+        // 向右或向左走20格再向下1格，蛇头不会回到走过的位置
+        if (direction == Direction::DOWN) {
+            direction = (tick / 21) % 2 == 0 ? Direction::RIGHT : Direction::LEFT;
+            leg = 0;
+        } else if (++leg >= 20) {
+            direction = Direction::DOWN;
+        }
+        host.playerDirections["long"] = direction;
+        const bool eat = tick % 17 == 0;
+        moveSnake(host.playerSnakes["long"], direction, eat);
+        history.append(host);
+        ateAt.append(eat);
+
+        for (int lag = 1; lag <= qMin(tick, MAX_DELTA_HEADS + 3); ++lag) {
+            const SnapshotBaseline baseline = makeBaseline(history.at(tick - lag), 1);
+            QByteArray message;
+            encodeGameState(host, 2, &baseline, message);
+            const QString context = QString("long snake at tick %1 from %2 ticks back").arg(tick).arg(lag);
+
+            HotspotGameState client = clientStateFor(host);
+            if (check(decodeSnapshot(message, &baseline, client), context + " decodes")) {
+                sameState(host, client, context);
+            }
+            if (lag > MAX_DELTA_HEADS) {
+                check(!usesDelta(message, host), context + " falls back to a full snake");
+            } else if (!ateAt.at(tick)) {
+                check(usesDelta(message, host), context + " is sent as a delta");
+            }
+        }
+    }
+}
+
+/**
+ * 吃到食物后尾部重复的一节：位移为零，关键帧和以它为基线的增量都必须原样还原；
+ * 连续吃两次时尾部有三节重叠
+ */
+void testZeroLengthSteps()
+{
+    HotspotGameState host;
+    host.isGameStarted = true;
+    addPlayer(host, "eater", 1, straightSnake(Point(5, 5), 3, 1, 0), Direction::RIGHT);
+    QVector<HotspotGameState> history;
+    history.append(host);
+
+    const QVector<bool> eats = {false, true, true, false, false, true, false};
+    for (int i = 0; i < eats.size(); ++i) {
+        host.tick = static_cast<quint32>(i + 1);
+        moveSnake(host.playerSnakes["eater"], i % 3 == 2 ? Direction::DOWN : Direction::RIGHT, eats.at(i));
+        history.append(host);
+
+        const QString context = QString("after step %1 (%2)").arg(i + 1).arg(describe(host.playerSnakes["eater"]));
+        QByteArray message;
+        encodeGameState(host, host.tick + 1, nullptr, message);
+        HotspotGameState client = clientStateFor(host);
+        if (check(decodeSnapshot(message, nullptr, client), "keyframe " + context + " decodes")) {
+            sameState(host, client, "keyframe " + context);
+        }
+
+        for (int lag = 1; lag <= i + 1; ++lag) {
+            const SnapshotBaseline baseline = makeBaseline(history.at(i + 1 - lag), 1);
+            encodeGameState(host, host.tick + 1, &baseline, message);
+            HotspotGameState deltaClient = clientStateFor(host);
+            const QString deltaContext = QString("delta %1 from %2 ticks back").arg(context).arg(lag);
+            if (check(decodeSnapshot(message, &baseline, deltaClient), deltaContext + " decodes")) {
+                sameState(host, deltaClient, deltaContext);
+            }
+            // 基线尾部带重复节、本帧没有吃到食物时，蛇身仍与基线逐节对齐
+            if (lag == 1 && i > 0 && eats.at(i - 1) && !eats.at(i)) {
+                check(usesDelta(message, host), deltaContext + " is sent as a delta");
+            }
+        }
+    }
+    check(history.at(3).playerSnakes["eater"].size() == 5, "two meals in a row leave three overlapping tail cells");
+}
+
+QByteArray randomMessage(QRandomGenerator& random, int size)
+{
+    QByteArray message(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        message[i] = static_cast<char>(random.bounded(256));
+    }
+    return message;
+}
+
+void feed(FrameParser& parser, const char* data, int size)
+{
+    char* target = parser.reserve(size);
+    memcpy(target, data, static_cast<size_t>(size));
+    parser.commit(size);
+}
+
+// 取出当前缓冲区中的全部完整帧；返回的data在下一次reserve前有效，所以立即复制
+bool drain(FrameParser& parser, QList<QByteArray>& frames)
+{
+    for (;;) {
+        const char* data = nullptr;
+        int size = 0;
+        const FrameParser::Status status = parser.nextFrame(data, size);
+        if (status == FrameParser::Status::NeedMoreData) {
+            return true;
+        }
+        if (status == FrameParser::Status::Error) {
+            return false;
+        }
+        frames.append(QByteArray(data, size));
+    }
+}
+
+/**
+ * 分帧：在每一个字节处切开、多帧一次到达、逐字节到达，以及大量帧按随机大小分段到达时不丢帧
+ */
+void testFrameParser()
+{
+    QRandomGenerator random(20240518);
+
+    // 长度前缀分别占1、2、3个字节的帧，加上真实的控制消息
+    QList<QByteArray> messages = {encodeHeartbeat(7, 123456), randomMessage(random, 1), randomMessage(random, 127),
+                                  randomMessage(random, 128), encodeKeyframeRequest(), randomMessage(random, 300),
+                                  encodePlayerJoin("玩家一", JoinResume, 0x0123456789abcdefULL)};
+    QByteArray stream;
+    for (const QByteArray& message : messages) {
+        appendFrame(stream, message);
+    }
+
+    for (int split = 0; split <= stream.size(); ++split) {
+        FrameParser parser;
+        QList<QByteArray> frames;
+        feed(parser, stream.constData(), split);
+        bool ok = drain(parser, frames);
+        feed(parser, stream.constData() + split, stream.size() - split);
+        ok = drain(parser, frames) && ok;
+        check(ok && frames == messages && parser.bufferedBytes() == 0,
+              QString("stream split at byte %1 of %2 yields every frame once").arg(split).arg(stream.size()));
+    }
+
+    {
+        FrameParser parser;
+        QList<QByteArray> frames;
+        feed(parser, stream.constData(), stream.size());
+        check(drain(parser, frames) && frames == messages, "several frames in one read");
+    }
+
+    // 大帧逐字节到达
+    const QList<QByteArray> large = {randomMessage(random, 16383), randomMessage(random, 16384),
+                                     randomMessage(random, 70000), randomMessage(random, 5)};
+    QByteArray largeStream;
+    for (const QByteArray& message : large) {
+        appendFrame(largeStream, message);
+    }
+    {
+        FrameParser parser;
+        QList<QByteArray> frames;
+        bool ok = true;
+        for (int i = 0; i < largeStream.size() && ok; ++i) {
+            feed(parser, largeStream.constData() + i, 1);
+            ok = drain(parser, frames);
+        }
+        check(ok && frames == large && parser.bufferedBytes() == 0, "large frames arriving one byte at a time");
+    }
+
+    // 负载测试：两万帧按随机大小的分段到达，边读边取，与onDataReceived的用法相同
+    QList<QByteArray> burst;
+    QByteArray burstStream;
+    for (int i = 0; i < 20000; ++i) {
+        burst.append(randomMessage(random, 1 + random.bounded(i % 100 == 0 ? 40000 : 1500)));
+        appendFrame(burstStream, burst.last());
+    }
+    {
+        FrameParser parser;
+        QList<QByteArray> frames;
+        bool ok = true;
+        int offset = 0;
+        while (offset < burstStream.size() && ok) {
+            const int chunk = qMin(burstStream.size() - offset, 1 + random.bounded(65536));
+            feed(parser, burstStream.constData() + offset, chunk);
+            offset += chunk;
+            ok = drain(parser, frames);
+        }
+        check(ok, "no framing error under load");
+        check(frames.size() == burst.size(), QString("%1 of %2 frames delivered under load").arg(frames.size()).arg(burst.size()));
+        check(frames == burst, "frames delivered under load are intact and in order");
+    }
+
+    // 长度前缀错误
+    const auto firstStatus = [](const QByteArray& bytes) {
+        FrameParser parser;
+        feed(parser, bytes.constData(), bytes.size());
+        const char* data = nullptr;
+        int size = 0;
+        return parser.nextFrame(data, size);
+    };
+    QByteArray prefix;
+    Writer(prefix).writeVarUInt(static_cast<quint32>(MAX_FRAME_SIZE + 1));
+    check(firstStatus(prefix) == FrameParser::Status::Error, "length prefix over MAX_FRAME_SIZE is an error");
+    prefix.clear();
+    Writer(prefix).writeVarUInt(static_cast<quint32>(MAX_FRAME_SIZE));
+    check(firstStatus(prefix + QByteArray(100, 'x')) == FrameParser::Status::NeedMoreData,
+          "length prefix of exactly MAX_FRAME_SIZE waits for the payload");
+    check(firstStatus(QByteArray(1, '\0')) == FrameParser::Status::Error, "zero length frame is an error");
+    check(firstStatus(QByteArray(4, static_cast<char>(0x80))) == FrameParser::Status::Error,
+          "unterminated four byte length prefix is an error");
+    check(firstStatus(QByteArray(3, static_cast<char>(0x80))) == FrameParser::Status::NeedMoreData,
+          "three byte partial length prefix waits for more data");
+    check(firstStatus(QByteArray()) == FrameParser::Status::NeedMoreData, "empty buffer waits for more data");
+}
+
+// 手工构造只含一名玩家的快照，玩家部分由 writeSnake 写入
+QByteArray craftSnapshot(const std::function<void(Writer&)>& writeSnake, quint32 playerCount = 1)
+{
+    QByteArray message;
+    message.append(static_cast<char>(Opcode::GameState));
+    Writer writer(message);
+    writer.writeVarUInt(2);   // 序号
+    writer.writeVarUInt(0);   // 基线序号
+    writer.writeVarUInt(5);   // 帧号
+    writer.writeU8(0);        // 标志
+    writer.writeVarUInt(100); // 游戏速度
+    writer.writeVarUInt(0);   // 倒计时
+    writer.writePoint(Point(1, 1));
+    writer.writeVarUInt(playerCount);
+    writer.writeVarUInt(1);   // 玩家ID
+    writer.writeU8(0x04);     // 存活，方向UP
+    writer.writeVarUInt(0);   // 分数
+    writer.writeVarUInt(0);   // 输入序号
+    writeSnake(writer);
+    return message;
+}
+
+/**
+ * 截断和畸形的负载：每个截断前缀都必须解码失败，不能越界读取或产生半截状态
+ */
+void testMalformedPayloads()
+{
+    HotspotGameState host;
+    host.isGameStarted = true;
+    host.isSpecialFood = true;
+    host.specialFoodPosition = Point(9, 9);
+    host.gameWinner = "winner";
+    addPlayer(host, "a", 1, straightSnake(Point(4, 4), 4, 1, 0), Direction::RIGHT);
+    addPlayer(host, "b", 2, straightSnake(Point(20, 4), 3, 0, 1), Direction::DOWN);
+    host.playerSnakes["b"].push_back(Point(20, -10));  // 转义位移
+    const SnapshotBaseline baseline = makeBaseline(host, 1);
+    moveSnake(host.playerSnakes["a"], Direction::UP, false);
+    moveSnake(host.playerSnakes["b"], Direction::DOWN, true);
+
+    QByteArray keyframe;
+    encodeGameState(host, 2, nullptr, keyframe);
+    QByteArray delta;
+    encodeGameState(host, 2, &baseline, delta);
+    check(usesDelta(delta, host), "malformed test delta uses delta encoding");
+
+    for (int length = 1; length < keyframe.size(); ++length) {
+        HotspotGameState client = clientStateFor(host);
+        check(!decodeSnapshot(keyframe.left(length), nullptr, client),
+              QString("keyframe truncated to %1 of %2 bytes is rejected").arg(length).arg(keyframe.size()));
+    }
+    for (int length = 1; length < delta.size(); ++length) {
+        HotspotGameState client = clientStateFor(host);
+        check(!decodeSnapshot(delta.left(length), &baseline, client),
+              QString("delta truncated to %1 of %2 bytes is rejected").arg(length).arg(delta.size()));
+    }
+
+    HotspotGameState client;
+    client.playerIds["p"] = 1;
+    client.playerSnakes["p"] = std::deque<Point>();
+    const auto rejects = [&client](const QByteArray& message, const SnapshotBaseline* base, const QString& what) {
+        HotspotGameState copy = client;
+        check(!decodeSnapshot(message, base, copy), what + " is rejected");
+    };
+    const auto accepts = [&client](const QByteArray& message, const SnapshotBaseline* base, const QString& what) {
+        HotspotGameState copy = client;
+        check(decodeSnapshot(message, base, copy), what + " is accepted");
+    };
+
+    accepts(craftSnapshot([](Writer& w) { w.writeU8(0); w.writeVarUInt(2); w.writePoint(Point(3, 3)); w.writeU8(4); }),
+            nullptr, "hand-built snapshot with a zero-length step");
+    rejects(craftSnapshot([](Writer& w) { w.writeU8(0); w.writeVarUInt(2); w.writePoint(Point(3, 3)); w.writeU8(9); }),
+            nullptr, "step byte outside the 3x3 neighbourhood");
+    rejects(craftSnapshot([](Writer& w) { w.writeU8(0); w.writeVarUInt(2); w.writePoint(Point(3, 3)); w.writeU8(0xFF); w.writeVarInt(5); }),
+            nullptr, "escaped step missing its y offset");
+    rejects(craftSnapshot([](Writer& w) { w.writeU8(0); w.writeVarUInt(50); w.writePoint(Point(3, 3)); w.writeU8(4); }),
+            nullptr, "snake length larger than the remaining bytes");
+    rejects(craftSnapshot([](Writer& w) { w.writeU8(2); }), nullptr, "unknown snake encoding");
+    rejects(craftSnapshot([](Writer& w) { w.writeU8(0); w.writeVarUInt(0); }, 256), nullptr, "player count over the limit");
+
+    SnapshotBaseline base;
+    base.sequence = 1;
+    base.snakes[1] = straightSnake(Point(3, 3), 3, 1, 0);
+    const auto deltaSnake = [](quint32 heads, qint32 tailChange) {
+        return [heads, tailChange](Writer& w) {
+            w.writeU8(1);
+            w.writeVarUInt(heads);
+            w.writeVarInt(tailChange);
+            for (quint32 i = 0; i < heads; ++i) {
+                w.writeU8(7);  // dx=+1
+            }
+        };
+    };
+    accepts(craftSnapshot(deltaSnake(1, -1)), &base, "hand-built delta");
+    rejects(craftSnapshot(deltaSnake(1, -1)), nullptr, "delta without a baseline");
+    SnapshotBaseline otherPlayer;
+    otherPlayer.snakes[2] = base.snakes[1];
+    rejects(craftSnapshot(deltaSnake(1, -1)), &otherPlayer, "delta whose baseline lacks the player");
+    rejects(craftSnapshot(deltaSnake(static_cast<quint32>(MAX_DELTA_HEADS + 1), 0)), &base,
+            "delta with more than MAX_DELTA_HEADS heads");
+    rejects(craftSnapshot(deltaSnake(0, -4)), &base, "delta shrinking below zero length");
+    rejects(craftSnapshot(deltaSnake(0, 3)), &base, "delta growing the tail without steps");
+
+    // 基本类型
+    {
+        const QByteArray overlong(5, static_cast<char>(0x80));
+        Reader reader(overlong);
+        quint32 value = 0;
+        check(!reader.readVarUInt(value) && !reader.isValid(), "varint longer than five bytes is rejected");
+        quint8 byte = 0;
+        check(!reader.readU8(byte), "reader stays invalid after an error");
+    }
+    {
+        QByteArray bytes;
+        Writer(bytes).writeVarUInt(1025);
+        bytes.append(QByteArray(1025, 'a'));
+        Reader reader(bytes);
+        QString value;
+        check(!reader.readString(value), "string longer than the limit is rejected");
+    }
+    {
+        QByteArray bytes;
+        Writer writer(bytes);
+        writer.writeVarInt(-70000);
+        writer.writeVarInt(2147483647);
+        writer.writeVarInt(-2147483647 - 1);
+        writer.writeU64(0xfedcba9876543210ULL);
+        Reader reader(bytes);
+        qint32 a = 0, b = 0, c = 0;
+        quint64 d = 0;
+        check(reader.readVarInt(a) && reader.readVarInt(b) && reader.readVarInt(c) && reader.readU64(d) &&
+              reader.atEnd() && a == -70000 && b == 2147483647 && c == -2147483647 - 1 && d == 0xfedcba9876543210ULL,
+              "integer round trips at the edges of their range");
+    }
+
+    // 控制消息：完整消息解码成功，每个截断前缀都失败
+    const auto payload = [](const QByteArray& message, int length) {
+        return Reader(message.constData() + 1, length - 1);
+    };
+    {
+        QList<PlayerInput> inputs;
+        for (quint32 i = 1; i <= 12; ++i) {
+            PlayerInput input;
+            input.sequence = i;
+            input.direction = static_cast<Direction>(i % 4);
+            inputs.append(input);
+        }
+        const QByteArray message = encodePlayerInput(inputs);
+        QList<PlayerInput> decoded;
+        Reader reader = payload(message, message.size());
+        check(decodePlayerInput(reader, decoded) && reader.atEnd() && decoded.size() == MAX_INPUTS_PER_MESSAGE &&
+              decoded.first().sequence == 5 && decoded.last().sequence == 12 &&
+              decoded.last().direction == inputs.last().direction, "player input keeps the last inputs");
+        for (int length = 1; length < message.size(); ++length) {
+            Reader truncated = payload(message, length);
+            check(!decodePlayerInput(truncated, decoded), QString("player input truncated to %1 bytes is rejected").arg(length));
+        }
+    }
+    {
+        QList<LockstepInput> inputs;
+        for (int id = 1; id <= 3; ++id) {
+            LockstepInput input;
+            input.playerId = id * 100;
+            input.direction = static_cast<Direction>(id);
+            inputs.append(input);
+        }
+        QByteArray message;
+        encodeInputBundle(4242, 0xdeadbeef, inputs, message);
+        quint32 tick = 0;
+        quint32 checksum = 0;
+        QList<LockstepInput> decoded;
+        Reader reader = payload(message, message.size());
+        check(decodeInputBundle(reader, tick, checksum, decoded) && reader.atEnd() && tick == 4242 &&
+              checksum == 0xdeadbeef && decoded.size() == 3 && decoded.at(2).playerId == 300 &&
+              decoded.at(2).direction == Direction::RIGHT, "input bundle round trip");
+        for (int length = 1; length < message.size(); ++length) {
+            Reader truncated = payload(message, length);
+            check(!decodeInputBundle(truncated, tick, checksum, decoded),
+                  QString("input bundle truncated to %1 bytes is rejected").arg(length));
+        }
+    }
+    {
+        const QByteArray message = encodePlayerJoin("恢复的玩家", JoinResume, 0x1122334455667788ULL);
+        quint8 version = 0;
+        QString name;
+        quint8 flags = 0;
+        quint32 features = 0;
+        quint64 token = 0;
+        Reader reader = payload(message, message.size());
+        check(decodePlayerJoin(reader, version, name, flags, features, token) && reader.atEnd() &&
+              version == PROTOCOL_VERSION && name == "恢复的玩家" && flags == JoinResume &&
+              features == SUPPORTED_FEATURES && token == 0x1122334455667788ULL, "player join round trip");
+        for (int length = 1; length < message.size(); ++length) {
+            Reader truncated = payload(message, length);
+            check(!decodePlayerJoin(truncated, version, name, flags, features, token),
+                  QString("player join truncated to %1 bytes is rejected").arg(length));
+        }
+    }
+
+    // 压缩消息
+    {
+        QByteArray original;
+        encodeGameState(host, 2, nullptr, original);
+        original.append(QByteArray(COMPRESSION_THRESHOLD, 'z'));
+        const QByteArray compressed = encodeCompressed(original);
+        QByteArray restored;
+        check(decodeCompressed(compressed.mid(1), restored) && restored == original, "compressed message round trip");
+        check(!decodeCompressed(compressed.mid(1, compressed.size() - 4), restored), "truncated compressed message is rejected");
+        QByteArray oversized = compressed.mid(1);
+        oversized[0] = static_cast<char>(0x7F);
+        check(!decodeCompressed(oversized, restored), "compressed message claiming more than MAX_FRAME_SIZE is rejected");
+        QByteArray wrongSize = compressed.mid(1);
+        wrongSize[3] = static_cast<char>(static_cast<uchar>(wrongSize.at(3)) + 1);
+        check(!decodeCompressed(wrongSize, restored), "compressed message with a wrong length header is rejected");
+        check(!decodeCompressed(QByteArray(4, '\0'), restored), "compressed message without data is rejected");
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testSnapshotRoundTrips();
+    testDeltaFallback();
+    testZeroLengthSteps();
+    testFrameParser();
+    testMalformedPayloads();
+
+    if (failures > 0) {
+        qCritical() << "FAIL:" << failures << "of" << checks << "checks failed";
+        return 1;
+    }
+    qInfo() << "PASS:" << checks << "checks";
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QTimer>
+#include <QDebug>
+#include "hotspotnetworkmanager.h"
+#include "hotspotgamemanager.h"
+
+// 锁步开局测试：主机和两个客户端在本机回环上开一局锁步对战，
+// 客户端收到关键帧时本地预测已经推进，进入锁步后必须直接接受后续输入包，不能请求重新同步
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    const quint16 port = 24350;
+    const quint32 ticksToCheck = 3;  // 右侧出生的蛇朝墙走，几帧后就会撞墙结束对局
+
+    HotspotNetworkManager hostNetwork;
+    HotspotGameManager hostGame;
+    hostNetwork.setDedicatedServer(true);
+    hostNetwork.setDiscoveryEnabled(false);
+    hostNetwork.setHostPorts(port, static_cast<quint16>(port + 1));
+    hostGame.setNetworkManager(&hostNetwork);
+    hostGame.setGameSpeed(100);
+    hostGame.setLockstepMode(true);
+
+    int exitCode = -1;
+    auto finish = [&app, &exitCode](int code, const QString& message) {
+        if (exitCode >= 0) {
+            return;
+        }
+        exitCode = code;
+        if (code == 0) {
+            qInfo() << "PASS:" << message;
+        } else {
+            qCritical() << "FAIL:" << message;
+        }
+        app.exit(code);
+    };
+
+    QObject::connect(&hostNetwork, &HotspotNetworkManager::keyframeRequested, &app, [&finish](const QString& playerName) {
+        finish(1, QString("%1 requested a resync").arg(playerName));
+    });
+    auto tryStart = [&hostGame]() {
+        const HotspotGameState state = hostGame.getGameState();
+        if (state.isGameStarted || state.countdownTimer > 0 || state.playerSnakes.size() < 2) {
+            return;
+        }
+        for (auto it = state.playerReadyStatus.constBegin(); it != state.playerReadyStatus.constEnd(); ++it) {
+            if (!it.value()) {
+                return;
+            }
+        }
+        hostGame.startGame();
+    };
+    QObject::connect(&hostGame, &HotspotGameManager::playerJoined, &app, [&tryStart](const QString&) { tryStart(); });
+    QObject::connect(&hostGame, &HotspotGameManager::playerReadyChanged, &app, [&tryStart](const QString&, bool) { tryStart(); });
+
+    if (!hostGame.createRoom(QString(), "Lockstep Test", 2)) {
+        qCritical() << "FAIL: could not start host on port" << port;
+        return 1;
+    }
+
+    const QStringList names = {"alice", "bob"};
+    QVector<HotspotGameManager*> clientGames;
+    QVector<quint32> lockstepStartTicks(names.size(), 0);
+    for (int i = 0; i < names.size(); ++i) {
+        HotspotNetworkManager* network = new HotspotNetworkManager(&app);
+        HotspotGameManager* game = new HotspotGameManager(&app);
+        game->setNetworkManager(network);
+        clientGames.append(game);
+
+        const QString name = names.at(i);
+        QObject::connect(network, &HotspotNetworkManager::connectedToHost, game, [game, name]() {
+            game->joinRoom(name);
+            game->setPlayerReady(name, true);
+        });
+        QObject::connect(game, &HotspotGameManager::gameStateUpdated, game,
+                         [&, i, game](const HotspotGameState& state) {
+            if (!game->isLockstepMode()) {
+                return;
+            }
+            if (lockstepStartTicks[i] == 0) {
+                lockstepStartTicks[i] = state.tick;
+            }
+            for (int j = 0; j < names.size(); ++j) {
+                if (lockstepStartTicks[j] == 0 || clientGames[j]->getGameState().tick < lockstepStartTicks[j] + ticksToCheck) {
+                    return;
+                }
+            }
+            finish(0, QString("%1 input bundles accepted by every client without a resync").arg(ticksToCheck));
+        });
+        network->connectToHost("127.0.0.1", port, static_cast<quint16>(port + 1));
+    }
+
+    // 3秒倒计时加上几帧，正常情况下远小于这个时间
+    QTimer::singleShot(15000, &app, [&finish]() { finish(1, "timed out before the clients entered lockstep"); });
+
+    return app.exec();
+}
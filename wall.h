@@ -23,6 +23,9 @@ public:
     // 获取所有墙体位置
     const QSet<Point>& getWallPositions() const { return wallPositions; }
     
+    // 直接设置墙体位置（用于同步和基准测试的合成场景）
+    void setWallPositions(const QSet<Point>& positions) { wallPositions = positions; }
+    
     // 清空墙体
     void clear();
     